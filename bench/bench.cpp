@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+#include "bench.h"
+#include "SoundWavePlayer.h"
+#include "waveKernels.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr size_t	kEvictBytes = 64 << 20;
+
+nlohmann::json		s_results = nlohmann::json::array();
+
+nlohmann::json toJson(const Stats& stats)
+{
+	return {
+		{ "cold", stats.cold },
+		{ "warm", { { "runs", stats.runs }, { "min", stats.min }, { "median", stats.median }, { "mean", stats.mean },
+			{ "max", stats.max }, { "stddev", stats.stddev } } }
+	};
+}
+
+std::string compilerName()
+{
+#if defined(_MSC_VER)
+	return "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+	return "Clang " __clang_version__;
+#elif defined(__GNUC__)
+	return "GCC " __VERSION__;
+#else
+	return "Unknown";
+#endif
+}
+}
+
+void evictCaches()
+{
+	static std::vector<Uint8> buffer(kEvictBytes);
+	for (size_t i = 0; i < buffer.size(); i += 64)
+	{
+		buffer[i] = (Uint8)(buffer[i] + 1);
+	}
+	g_sink = buffer[0];
+}
+
+Stats summarise(const std::vector<double>& times)
+{
+	Stats stats;
+	if (times.empty())
+	{
+		return stats;
+	}
+	stats.cold = times[0];
+	std::vector<double> warm(times.begin() + 1, times.end());
+	if (warm.empty())
+	{
+		warm.push_back(times[0]);
+	}
+	stats.runs = (int)warm.size();
+	std::sort(warm.begin(), warm.end());
+	stats.min = warm.front();
+	stats.max = warm.back();
+	stats.median = warm[warm.size() / 2];
+	stats.mean = std::accumulate(warm.begin(), warm.end(), 0.0) / (double)warm.size();
+	double variance = 0;
+	for (double t : warm)
+	{
+		variance += (t - stats.mean) * (t - stats.mean);
+	}
+	stats.stddev = std::sqrt(variance / (double)warm.size());
+	return stats;
+}
+
+void record(const std::string& name, const nlohmann::json& params, const std::string& unit, const Stats& stats)
+{
+	nlohmann::json result = toJson(stats);
+	result["name"] = name;
+	result["params"] = params;
+	result["unit"] = unit;
+	s_results.push_back(std::move(result));
+}
+
+bool writeReport(const std::string& path)
+{
+	nlohmann::json report;
+	report["suite"] = "Oscilloscope";
+	report["seed"] = kSeed;
+	report["compiler"] = compilerName();
+#if defined(NDEBUG)
+	report["build"] = "Release";
+#else
+	report["build"] = "Debug";
+#endif
+	report["simd"] = simdLevel2String(detectSimdLevel());
+	report["platform"] = SDL_GetPlatform();
+	report["cpus"] = SDL_GetCPUCount();
+	report["results"] = s_results;
+
+	std::ofstream file(path);
+	file << report.dump(2) << '\n';
+	if (!file)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to write ", path, '\n');
+		return false;
+	}
+	ns_Util::Logger::LOG_MSG("Wrote ", s_results.size(), " results to ", path, '\n');
+	return true;
+}
+
+bool SoftwareTarget::create(int w, int h)
+{
+	destroy();
+	m_pSurface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+	m_pRenderer = m_pSurface ? SDL_CreateSoftwareRenderer(m_pSurface) : nullptr;
+	if (!m_pRenderer)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR("No software renderer");
+		destroy();
+		return false;
+	}
+	return true;
+}
+
+void SoftwareTarget::destroy()
+{
+	if (m_pRenderer)
+	{
+		SDL_DestroyRenderer(m_pRenderer);
+		m_pRenderer = nullptr;
+	}
+	if (m_pSurface)
+	{
+		SDL_FreeSurface(m_pSurface);
+		m_pSurface = nullptr;
+	}
+}
+
+std::unique_ptr<SoundWavePlayer> makeOfflinePlayer(SDL_AudioFormat format, Uint8 channels)
+{
+	std::unique_ptr<SoundWavePlayer> pPlayer = std::make_unique<SoundWavePlayer>(FREQUENCY, AMPLITUDE, PHASE, WaveForm::SINE,
+		SAMPLE_RATE, format, channels, SAMPLE_COUNT, SDLAudioCallback, WINDOW_WIDTH, WINDOW_HEIGHT);
+	SDL_AudioSpec spec;
+	SDL_zero(spec);
+	spec.freq = SAMPLE_RATE;
+	spec.format = format;
+	spec.channels = channels;
+	spec.samples = SAMPLE_COUNT;
+	pPlayer->initOffline(spec);
+	return pPlayer;
+}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <nlohmann/json.hpp>
+
+#include "constants.h"
+
+class SoundWavePlayer;
+
+namespace ns_Bench
+{
+using Clock = std::chrono::steady_clock;
+
+// Every benchmark draws its random input from this, so runs are comparable
+constexpr Uint32 kSeed = 12345;
+
+// Keeps the optimizer from throwing the benchmarked results away
+extern volatile double g_sink;
+
+INLINE double nsPerSample(Clock::duration d, int64_t samples)
+{
+	return std::chrono::duration<double, std::nano>(d).count() / (double)samples;
+}
+
+// Timings of one benchmark in ns per item. The cold run comes first, right after the caches
+// were flushed and with whatever lazily built state the code finds, the warm runs follow it.
+struct Stats
+{
+	double	cold{};
+	double	min{};
+	double	median{};
+	double	mean{};
+	double	max{};
+	double	stddev{};
+	int		runs{};			// Warm runs
+};
+
+// Flushes the data caches by streaming through a buffer larger than the last level cache
+void evictCaches();
+
+// Cold run first, warm ones after it. times is ns per item for every run.
+Stats summarise(const std::vector<double>& times);
+
+// Runs setup() untimed and run() timed, once cold and warmRuns times warm, each run covering
+// items items
+template <typename SetupFn, typename RunFn>
+Stats measure(int warmRuns, int64_t items, SetupFn setup, RunFn run)
+{
+	std::vector<double> times;
+	times.reserve((size_t)warmRuns + 1);
+	evictCaches();
+	for (int r = 0; r <= warmRuns; ++r)
+	{
+		setup();
+		const auto start = Clock::now();
+		run();
+		const auto end = Clock::now();
+		times.push_back(nsPerSample(end - start, items));
+	}
+	return summarise(times);
+}
+
+template <typename RunFn>
+Stats measure(int warmRuns, int64_t items, RunFn run)
+{
+	return measure(warmRuns, items, [] {}, run);
+}
+
+// Adds a result to the JSON report, name is "<area>/<what>" and params tell the cases apart
+void record(const std::string& name, const nlohmann::json& params, const std::string& unit, const Stats& stats);
+
+// Writes every recorded result with the build and machine it came from, false on failure
+bool writeReport(const std::string& path);
+
+// Offscreen software renderer, draws the same on every machine and needs no display
+class SoftwareTarget
+{
+public:
+	~SoftwareTarget() { destroy(); }
+
+	bool create(int w, int h);
+	void destroy();
+
+	INLINE SDL_Renderer* renderer() const { return m_pRenderer; }
+private:
+	SDL_Surface*	m_pSurface{};
+	SDL_Renderer*	m_pRenderer{};
+};
+
+// Sine player at the default tone in format and channels, set up by initOffline() with
+// SAMPLE_COUNT frames per callback as a device would
+std::unique_ptr<SoundWavePlayer> makeOfflinePlayer(SDL_AudioFormat format, Uint8 channels);
+
+// Checks a result against a brute force computation, false and an error on a mismatch
+extern bool checkPyramid();
+
+// Individual benchmarks, run in order by main()
+extern void runSoundWaveBench();
+extern void runWavetableReport();
+extern void runCallbackBench();
+extern void runDecimatorBench();
+extern void runFftBench();
+extern void runTriggerBench();
+extern void runPersistenceBench();
+extern void runTraceBench();
+extern void runBgGridBench();
+}
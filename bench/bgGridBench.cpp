@@ -0,0 +1,60 @@
+#include <SDL.h>
+
+#include "bench.h"
+#include "bgGrid.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int	kFrames = 600;
+
+// Times clear + grid + flush, the rest of the frame is left out so only the grid differs.
+// The cold frame of the cached grid renders the texture.
+template <typename DrawFn>
+Stats timeFrames(SDL_Renderer* pRenderer, DrawFn draw)
+{
+	return measure(kFrames, 1, [&]
+	{
+		SDL_RenderClear(pRenderer);
+		draw();
+		SDL_RenderFlush(pRenderer);
+	});
+}
+
+void logFrameTimes(const char* name, const Stats& t)
+{
+	ns_Util::Logger::LOG_MSG("    ", name, " : mean ", t.mean / 1e6, " ms, median ", t.median / 1e6, " ms, worst ", t.max / 1e6,
+		" ms, cold ", t.cold / 1e6, " ms\n");
+}
+}
+
+void runBgGridBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("BgGrid benchmark, ", kFrames, " frames of ", WINDOW_WIDTH, " x ", WINDOW_HEIGHT, ", software renderer\n");
+
+	SoftwareTarget target;
+	if (!target.create(WINDOW_WIDTH, WINDOW_HEIGHT))
+	{
+		Logger::LOG_MSG("    Skipped\n\n");
+		return;
+	}
+	SDL_Renderer* pRenderer = target.renderer();
+	BgGrid grid(WINDOW_WIDTH, WINDOW_HEIGHT, NUM_OF_COLUMNS);
+	const Stats uncached = timeFrames(pRenderer, [&] { grid.drawUncached(pRenderer); });
+	const Stats cached = timeFrames(pRenderer, [&] { grid.draw(pRenderer); });
+	record("bgGrid/draw", { { "cached", false }, { "width", WINDOW_WIDTH }, { "height", WINDOW_HEIGHT } }, "ns/frame", uncached);
+	record("bgGrid/draw", { { "cached", grid.isCached() }, { "width", WINDOW_WIDTH }, { "height", WINDOW_HEIGHT } }, "ns/frame", cached);
+
+	logFrameTimes("Every line per frame ", uncached);
+	logFrameTimes("Cached texture       ", cached);
+	if (!grid.isCached())
+	{
+		Logger::LOG_MSG("    Render targets are not supported, the cached path fell back to drawing every line\n");
+	}
+	Logger::LOG_MSG("    Speedup              : ", uncached.mean / cached.mean, "x\n\n");
+	grid.releaseTexture();
+}
+}
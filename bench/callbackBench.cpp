@@ -0,0 +1,60 @@
+#include <vector>
+
+#include "bench.h"
+#include "SoundWavePlayer.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+// Fewer blocks than DisplayRing holds, it is drained between runs like the UI thread would
+constexpr int	kCallbacksPerRun = 32;
+constexpr int	kRepeat = 50;
+
+Stats benchCallback(SDL_AudioFormat format, Uint8 channels, bool bPeriodCache)
+{
+	std::unique_ptr<SoundWavePlayer> pPlayer = makeOfflinePlayer(format, channels);
+	SoundWavePlayer& player = *pPlayer;
+	player.setPeriodCacheEnabled(bPeriodCache);
+
+	std::vector<Uint8> stream(player.getDeviceSpecs()->size);
+	const int len = (int)stream.size();
+
+	// The cold run also takes up the parameters setPeriodCacheEnabled() published, its first
+	// callback renders every sample
+	return measure(kRepeat, (int64_t)kCallbacksPerRun * SAMPLE_COUNT, [&] { player.drainDisplayRing(); }, [&]
+	{
+		for (int i = 0; i < kCallbacksPerRun; ++i)
+		{
+			SDLAudioCallback(&player, stream.data(), len);
+		}
+		g_sink = stream[0];
+	});
+}
+}
+
+void runCallbackBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Audio callback, ", kCallbacksPerRun, " callbacks of ", SAMPLE_COUNT, " frames, ", waveForm2String(WaveForm::SINE), " at ",
+		FREQUENCY, " Hz, best of ", kRepeat, " warm runs, cold run in brackets\n");
+
+	const SDL_AudioFormat formats[] = { AUDIO_S8, AUDIO_U8, AUDIO_S16, AUDIO_U16, AUDIO_S32, AUDIO_F32 };
+	const Uint8 channelCounts[] = { MONO, STEREO, QUAD, HEXA };
+	for (SDL_AudioFormat format : formats)
+	{
+		for (Uint8 channels : channelCounts)
+		{
+			const Stats generated = benchCallback(format, channels, false);
+			const Stats cached = benchCallback(format, channels, true);
+			record("callback/sine", { { "format", audioFormat2String(format) }, { "channels", channels }, { "periodCache", false } }, "ns/frame", generated);
+			record("callback/sine", { { "format", audioFormat2String(format) }, { "channels", channels }, { "periodCache", true } }, "ns/frame", cached);
+
+			Logger::LOG_MSG("    ", audioFormat2String(format), ", ", channelsToString(channels), " : generated ", generated.min, " ns/frame (",
+				generated.cold, "), period cache ", cached.min, " ns/frame (", cached.cold, ")\n");
+		}
+	}
+	Logger::LOG_MSG('\n');
+}
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "minMaxDecimator.h"
+#include "waveformPyramid.h"
+#include "SoundWavePlayer.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr Uint32	kRecordLength = 1 << 16;
+constexpr Uint32	kColumns = WINDOW_WIDTH;
+constexpr int		kRepeat = 50;
+
+Stats benchDecimate(const std::vector<Uint8>& samples, SDL_AudioFormat format, SimdLevel level)
+{
+	std::vector<MinMaxColumn> columns(kColumns);
+	return measure(kRepeat, kRecordLength, [&]
+	{
+		decimateMinMax(samples.data(), format, kRecordLength, columns.data(), kColumns, level);
+		g_sink = columns[0].max;
+	});
+}
+}
+
+bool checkPyramid()
+{
+	using ns_Util::Logger;
+	constexpr Uint32 kSamples = 3 << 20;
+	constexpr int kQueries = 200;
+	constexpr float kBias = 128.0f;
+
+	std::mt19937 rng(kSeed);
+	std::vector<Sint16> samples(kSamples);
+	for (Sint16& s : samples)
+	{
+		s = (Sint16)(rng() % 4001) - 2000;
+	}
+	WaveformPyramid pyramid;
+	pyramid.setBias(kBias);
+	for (Uint32 i = 0; i < kSamples; i += SAMPLE_COUNT)
+	{
+		pyramid.append(samples.data() + i, std::min((Uint32)SAMPLE_COUNT, kSamples - i));
+	}
+
+	// Every other query lines its columns up with buckets, those have to match a scan of the
+	// samples exactly. The rest only have to cover the scanned min and max.
+	std::vector<MinMaxColumn> columns(kColumns);
+	std::vector<float> rms(kColumns);
+	int failures = 0;
+	for (int q = 0; q < kQueries; ++q)
+	{
+		const bool bAligned = q % 2 == 0;
+		Uint64 first = 0;
+		Uint64 count = 0;
+		if (bAligned)
+		{
+			const Uint64 width = WaveformPyramid::bucketSamples((int)(rng() % 6));
+			count = kColumns * width;
+			first = (rng() % ((pyramid.summarisedCount() - count) / width + 1)) * width;
+		}
+		else
+		{
+			count = kColumns * WaveformPyramid::BASE_DECIMATION + rng() % (pyramid.summarisedCount() / 2);
+			first = rng() % (pyramid.summarisedCount() - count + 1);
+		}
+		if (!pyramid.query(first, count, columns.data(), rms.data(), kColumns))
+		{
+			++failures;
+			continue;
+		}
+		for (Uint32 c = 0; c < kColumns; ++c)
+		{
+			const Uint64 s0 = first + count * c / kColumns;
+			const Uint64 s1 = first + count * (c + 1) / kColumns;
+			const auto range = std::minmax_element(samples.begin() + s0, samples.begin() + s1);
+			const float lo = *range.first;
+			const float hi = *range.second;
+			bool bOk = columns[c].min <= lo && columns[c].max >= hi;
+			if (bAligned)
+			{
+				double squares = 0;
+				for (Uint64 i = s0; i < s1; ++i)
+				{
+					squares += ((double)samples[i] - kBias) * ((double)samples[i] - kBias);
+				}
+				const double expected = std::sqrt(squares / (s1 - s0));
+				bOk = bOk && columns[c].min == lo && columns[c].max == hi && std::abs(rms[c] - expected) <= expected * 1e-3;
+			}
+			if (!bOk)
+			{
+				++failures;
+				break;
+			}
+		}
+	}
+
+	if (failures > 0)
+	{
+		Logger::LOG_ERROR("WaveformPyramid: ", failures, " of ", kQueries, " queries disagree with a scan of the samples");
+		return false;
+	}
+	Logger::LOG_MSG("WaveformPyramid matches a scan of the samples on ", kQueries, " queries over ", kSamples, " samples\n\n");
+	return true;
+}
+
+void runDecimatorBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Min/max decimation, ", kRecordLength, " samples to ", kColumns, " columns, best of ", kRepeat, " warm runs, cold run in brackets\n");
+
+	const SDL_AudioFormat formats[] = { AUDIO_S8, AUDIO_U8, AUDIO_S16, AUDIO_U16, AUDIO_S32, AUDIO_F32 };
+	std::mt19937 rng(kSeed);
+	for (SDL_AudioFormat format : formats)
+	{
+		// Random bytes are valid samples in every integer format, floats get random integral values
+		std::vector<Uint8> samples((size_t)kRecordLength * SDL_AUDIO_BITSIZE(format) / 8);
+		if (format == AUDIO_F32)
+		{
+			float* pFloats = reinterpret_cast<float*>(samples.data());
+			for (Uint32 i = 0; i < kRecordLength; ++i)
+			{
+				pFloats[i] = (float)(rng() % 2001) - 1000.0f;
+			}
+		}
+		else
+		{
+			for (Uint8& b : samples)
+			{
+				b = (Uint8)rng();
+			}
+		}
+
+		const Stats scalar = benchDecimate(samples, format, SimdLevel::SCALAR);
+		const Stats sse2 = benchDecimate(samples, format, SimdLevel::SSE2);
+		record("decimator/minMax", { { "format", audioFormat2String(format) }, { "simd", simdLevel2String(SimdLevel::SCALAR) } }, "ns/sample", scalar);
+		record("decimator/minMax", { { "format", audioFormat2String(format) }, { "simd", simdLevel2String(SimdLevel::SSE2) } }, "ns/sample", sse2);
+		Logger::LOG_MSG("    ", audioFormat2String(format), " : scalar ", scalar.min, " ns/sample (", scalar.cold, "), SSE2 ", sse2.min,
+			" ns/sample (", sse2.cold, "), ", scalar.min / sse2.min, "x\n");
+	}
+	Logger::LOG_MSG('\n');
+}
+}
@@ -0,0 +1,52 @@
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "fft.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int	kRepeat = 50;
+
+// One spectrum of the analyzer's worker, transform and dB conversion, per sample
+Stats benchSpectrum(const std::vector<float>& samples, Uint32 size, SimdLevel level)
+{
+	const RealFft fft(size, level);
+	std::vector<float> re(fft.bins()), im(fft.bins()), db(fft.bins()), scratch(size);
+	return measure(kRepeat, size, [&]
+	{
+		fft.forward(samples.data(), re.data(), im.data(), scratch.data());
+		powerToDb(re.data(), im.data(), db.data(), fft.bins(), 1.0f, 1e-12f, level);
+		g_sink = db[1];
+	});
+}
+}
+
+void runFftBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Real FFT and dB conversion, best of ", kRepeat, " warm runs, cold run in brackets\n");
+
+	std::mt19937 rng(kSeed);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	std::vector<float> samples(RealFft::MAX_SIZE);
+	for (float& s : samples)
+	{
+		s = uniform(rng);
+	}
+
+	for (Uint32 size = SAMPLE_COUNT; size <= RealFft::MAX_SIZE; size *= 4)
+	{
+		const Stats scalar = benchSpectrum(samples, size, SimdLevel::SCALAR);
+		const Stats sse2 = benchSpectrum(samples, size, SimdLevel::SSE2);
+		record("fft/spectrum", { { "size", size }, { "simd", simdLevel2String(SimdLevel::SCALAR) } }, "ns/sample", scalar);
+		record("fft/spectrum", { { "size", size }, { "simd", simdLevel2String(SimdLevel::SSE2) } }, "ns/sample", sse2);
+		Logger::LOG_MSG("    ", size, " points : scalar ", scalar.min * size / 1e6, " ms (", scalar.cold * size / 1e6, "), SSE2 ",
+			sse2.min * size / 1e6, " ms (", sse2.cold * size / 1e6, "), ", scalar.min / sse2.min, "x\n");
+	}
+	Logger::LOG_MSG('\n');
+}
+}
@@ -0,0 +1,51 @@
+#include <string>
+
+#include "bench.h"
+#include "logger.h"
+
+#undef main
+
+namespace ns_Bench
+{
+volatile double g_sink{};
+}
+
+int main(int argc, char* argv[])
+{
+	std::string jsonPath;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--json" && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else
+		{
+			ns_Util::Logger::LOG_MSG("Usage: ", argv[0], " [--json <path>]\n");
+			ns_Util::Logger::LOG_MSG("    --json <path> : Also write every result as JSON, for comparing runs\n");
+			return arg == "-h" || arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (!ns_Bench::checkPyramid())
+	{
+		return 1;
+	}
+
+	ns_Bench::runSoundWaveBench();
+	ns_Bench::runWavetableReport();
+	ns_Bench::runCallbackBench();
+	ns_Bench::runDecimatorBench();
+	ns_Bench::runFftBench();
+	ns_Bench::runTriggerBench();
+	ns_Bench::runPersistenceBench();
+	ns_Bench::runTraceBench();
+	ns_Bench::runBgGridBench();
+
+	if (!jsonPath.empty() && !ns_Bench::writeReport(jsonPath))
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "persistence.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int	kRepeat = 20;
+constexpr int	kFrames = 1000;
+
+// Display samples of a sine over the full height, a few periods per frame
+std::vector<float> makeFrame(Uint32 count)
+{
+	std::vector<float> samples(count);
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		samples[i] = WINDOW_HEIGHT / 2.0f + std::sin(i * 25.0f / count) * WINDOW_HEIGHT * 0.45f;
+	}
+	return samples;
+}
+
+// Frames a second the worker can take, drawing count samples each
+Stats benchAccumulate(Persistence& persistence, Uint32 count)
+{
+	const std::vector<float> samples = makeFrame(count);
+	return measure(kRepeat, kFrames, [&]
+	{
+		for (int f = 0; f < kFrames; ++f)
+		{
+			persistence.accumulate(samples.data(), AUDIO_F32, count, (f % 16) / 16.0f);
+		}
+	});
+}
+
+// One image, decay and colour mapping, per pixel
+Stats benchImage(SimdLevel level)
+{
+	const Uint32 pixels = (Uint32)WINDOW_WIDTH * WINDOW_HEIGHT;
+	std::mt19937 rng(kSeed);
+	std::vector<float> hits(pixels);
+	for (float& h : hits)
+	{
+		h = rng() % 8 == 0 ? (float)(rng() % 1000) : 0.0f;
+	}
+	std::vector<float> work(pixels);
+	std::vector<Uint32> lut(Persistence::LUT_SIZE, 0xff00ff00u), image(pixels);
+	return measure(kRepeat, pixels, [&] { work = hits; }, [&]
+	{
+		g_sink = decayToPixels(work.data(), pixels, 0.97f, Persistence::LOG_RANGE / 1000.0f, lut.data(), image.data(), level);
+	});
+}
+}
+
+void runPersistenceBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Persistence, ", WINDOW_WIDTH, " x ", WINDOW_HEIGHT, ", best of ", kRepeat, " warm runs, cold run in brackets\n");
+
+	Persistence persistence;
+	persistence.reset(WINDOW_WIDTH, WINDOW_HEIGHT, 1 << 16, sizeof(float));
+	for (Uint32 count : { (Uint32)64, (Uint32)WINDOW_WIDTH, (Uint32)1 << 14 })
+	{
+		const Stats stats = benchAccumulate(persistence, count);
+		record("persistence/accumulate", { { "samples", count } }, "ns/frame", stats);
+		Logger::LOG_MSG("    Frames of ", count, " samples : ", stats.min / 1000.0, " us (", stats.cold / 1000.0, "), ",
+			1e9 / stats.min, " frames/s\n");
+	}
+
+	const Stats scalar = benchImage(SimdLevel::SCALAR);
+	const Stats sse2 = benchImage(SimdLevel::SSE2);
+	record("persistence/image", { { "simd", simdLevel2String(SimdLevel::SCALAR) } }, "ns/pixel", scalar);
+	record("persistence/image", { { "simd", simdLevel2String(SimdLevel::SSE2) } }, "ns/pixel", sse2);
+	const double pixels = (double)WINDOW_WIDTH * WINDOW_HEIGHT;
+	Logger::LOG_MSG("    Image, decay and LUT : scalar ", scalar.min * pixels / 1e6, " ms (", scalar.cold * pixels / 1e6, "), SSE2 ",
+		sse2.min * pixels / 1e6, " ms (", sse2.cold * pixels / 1e6, "), ", scalar.min / sse2.min, "x\n");
+	Logger::LOG_MSG('\n');
+}
+}
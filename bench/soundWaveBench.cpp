@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "bench.h"
+#include "soundWave.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int	kSampleCount = 1 << 22;
+constexpr int	kRepeat = 5;
+
+// Old path: SoundWavePlayer::getSample() used to evaluate getSample(pos / fs) in long double
+Stats benchReference(SoundWave& wave)
+{
+	return measure(kRepeat, kSampleCount, [&]
+	{
+		double sum = 0;
+		for (int pos = 0; pos < kSampleCount; ++pos)
+		{
+			sum += (double)wave.getSample(pos / (SoundWave::value_type)wave.getSampleRate());
+		}
+		g_sink = sum;
+	});
+}
+
+Stats benchPhaseAccumulator(SoundWave& wave)
+{
+	return measure(kRepeat, kSampleCount, [&] { wave.resetPhase(); }, [&]
+	{
+		double sum = 0;
+		for (int pos = 0; pos < kSampleCount; ++pos)
+		{
+			sum += wave.nextSample();
+		}
+		g_sink = sum;
+	});
+}
+
+Stats benchBlockRender(SoundWave& wave, SimdLevel level, size_t blockSize)
+{
+	std::vector<SoundWave::sample_type> block(blockSize);
+	wave.setSimdLevel(level);
+	return measure(kRepeat, kSampleCount, [&] { wave.resetPhase(); }, [&]
+	{
+		double sum = 0;
+		for (size_t pos = 0; pos < (size_t)kSampleCount; pos += blockSize)
+		{
+			wave.render(block.data(), blockSize);
+			sum += block[0];
+		}
+		g_sink = sum;
+	});
+}
+
+// Largest difference between the block kernels and nextSample() over one block
+double blockRenderError(SoundWave& wave, SimdLevel level, size_t blockSize)
+{
+	std::vector<SoundWave::sample_type> block(blockSize);
+	wave.setSimdLevel(level);
+	wave.resetPhase();
+	wave.render(block.data(), blockSize);
+
+	double maxError = 0;
+	wave.resetPhase();
+	for (size_t i = 0; i < blockSize; ++i)
+	{
+		const double error = std::abs((double)block[i] - wave.nextSample());
+		// Square and sawtooth jump by 2A, a sample sitting exactly on the edge may land on either side
+		if (error < wave.getAmplitude())
+		{
+			maxError = std::max(maxError, error);
+		}
+	}
+	return maxError;
+}
+
+// Runs the accumulator for a long time and compares its phase against the exact phase,
+// computed with integer arithmetic as (n * f mod fs) / fs.
+double phaseDrift(int f, int fs, int64_t samples)
+{
+	SoundWave wave(f, AMPLITUDE, WaveForm::SAWTOOTH, 0, fs);
+	for (int64_t n = 0; n < samples; ++n)
+	{
+		wave.nextSample();
+	}
+	const double exact = (double)((samples * f) % fs) / fs;
+	double drift = std::abs(wave.getNormalizedPhase() - exact);
+	return std::min(drift, 1.0 - drift);
+}
+}
+
+void runSoundWaveBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("SoundWave benchmark, ", kSampleCount, " samples, best of ", kRepeat, " warm runs, cold run in brackets\n");
+	Logger::LOG_MSG("    Frequency : ", FREQUENCY, ", Amplitude : ", AMPLITUDE, ", Sample rate : ", SAMPLE_RATE, "\n\n");
+
+	for (int w = 0; w < (int)WaveForm::MAX; ++w)
+	{
+		SoundWave wave(FREQUENCY, AMPLITUDE, (WaveForm)w, PHASE, SAMPLE_RATE);
+		const std::string name = waveForm2String((WaveForm)w);
+
+		const Stats reference = benchReference(wave);
+		const Stats accumulator = benchPhaseAccumulator(wave);
+		record("soundWave/getSample", { { "waveForm", name } }, "ns/sample", reference);
+		record("soundWave/nextSample", { { "waveForm", name } }, "ns/sample", accumulator);
+
+		Logger::LOG_MSG("    ", name, '\n');
+		Logger::LOG_MSG("        getSample(t)  : ", reference.min, " ns/sample (", reference.cold, ")\n");
+		Logger::LOG_MSG("        nextSample()  : ", accumulator.min, " ns/sample (", accumulator.cold, ")\n");
+		Logger::LOG_MSG("        Speedup       : ", reference.min / accumulator.min, "x\n");
+
+		for (size_t blockSize : { (size_t)SAMPLE_COUNT, (size_t)SAMPLE_COUNT * 16 })
+		{
+			for (int l = 0; l <= (int)detectSimdLevel(); ++l)
+			{
+				const Stats block = benchBlockRender(wave, (SimdLevel)l, blockSize);
+				const double error = blockRenderError(wave, (SimdLevel)l, blockSize);
+				record("soundWave/render", { { "waveForm", name }, { "blockSize", blockSize }, { "simd", simdLevel2String((SimdLevel)l) },
+					{ "maxError", error } }, "ns/sample", block);
+				Logger::LOG_MSG("        render(", blockSize, ") ", simdLevel2String((SimdLevel)l), " : ", block.min, " ns/sample (", block.cold, "), ",
+					reference.min / block.min, "x vs getSample(t), ", accumulator.min / block.min, "x vs nextSample(), max error ", error, '\n');
+			}
+		}
+	}
+
+	const int64_t driftSamples = (int64_t)SAMPLE_RATE * 3600;
+	Logger::LOG_MSG("\n    Phase drift after 1 hour at ", SAMPLE_RATE, " Hz : ", phaseDrift(FREQUENCY, SAMPLE_RATE, driftSamples), " cycles\n\n");
+}
+}
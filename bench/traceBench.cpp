@@ -0,0 +1,63 @@
+#include <vector>
+
+#include "bench.h"
+#include "SoundWavePlayer.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int	kFrames = 200;
+
+// SoundWavePlayer::draw() of one captured frame, a polyline when the record fits the width
+// and min/max columns when it does not
+Stats benchDraw(SDL_Renderer* pRenderer, SDL_AudioFormat format, Uint32 recordLength)
+{
+	std::unique_ptr<SoundWavePlayer> pPlayer = makeOfflinePlayer(format, STEREO);
+	SoundWavePlayer& player = *pPlayer;
+	player.setRecordLength(recordLength);
+
+	// Enough audio for a whole frame at the new record length
+	std::vector<Uint8> stream(player.getDeviceSpecs()->size);
+	for (Uint32 i = 0; i < 2 * (recordLength / SAMPLE_COUNT + 2); ++i)
+	{
+		SDLAudioCallback(&player, stream.data(), (int)stream.size());
+		player.drainDisplayRing();
+	}
+
+	return measure(kFrames, 1, [&] { SDL_RenderClear(pRenderer); }, [&]
+	{
+		player.draw(pRenderer);
+		SDL_RenderFlush(pRenderer);
+	});
+}
+}
+
+void runTraceBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Trace drawing, ", kFrames, " frames of ", WINDOW_WIDTH, " x ", WINDOW_HEIGHT, ", software renderer\n");
+
+	SoftwareTarget target;
+	if (!target.create(WINDOW_WIDTH, WINDOW_HEIGHT))
+	{
+		Logger::LOG_MSG("    Skipped\n\n");
+		return;
+	}
+
+	const SDL_AudioFormat formats[] = { AUDIO_S8, AUDIO_U8, AUDIO_S16, AUDIO_U16, AUDIO_S32, AUDIO_F32 };
+	const Uint32 recordLengths[] = { SAMPLE_COUNT, SoundWavePlayer::MAX_RECORD_LENGTH };
+	for (SDL_AudioFormat format : formats)
+	{
+		for (Uint32 recordLength : recordLengths)
+		{
+			const Stats draw = benchDraw(target.renderer(), format, recordLength);
+			record("trace/draw", { { "format", audioFormat2String(format) }, { "recordLength", recordLength } }, "ns/frame", draw);
+			Logger::LOG_MSG("    ", audioFormat2String(format), ", ", recordLength, " samples : median ", draw.median / 1e6, " ms, worst ",
+				draw.max / 1e6, " ms, cold ", draw.cold / 1e6, " ms\n");
+		}
+	}
+	Logger::LOG_MSG('\n');
+}
+}
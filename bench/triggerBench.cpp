@@ -0,0 +1,74 @@
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "bench.h"
+#include "trigger.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int		kRepeat = 50;
+constexpr Uint32	kSamples = 1 << 16;
+constexpr float		kHalfHeight = 100.0f;		// Fits every format
+
+// Display samples of a sine at a rate that crosses the level about every 1000 samples
+template <typename T>
+std::vector<Uint8> makeDisplaySamples()
+{
+	std::vector<Uint8> bytes((size_t)kSamples * sizeof(T));
+	T* pSamples = reinterpret_cast<T*>(bytes.data());
+	for (Uint32 i = 0; i < kSamples; ++i)
+	{
+		const float v = kHalfHeight + std::sin(i * 0.00628f) * kHalfHeight * 0.9f;
+		pSamples[i] = static_cast<T>(std::is_floating_point_v<T> ? v : std::round(v));
+	}
+	return bytes;
+}
+
+// Every trigger in the buffer, the way the audio thread searches one block after another
+Stats benchSearch(const std::vector<Uint8>& samples, SDL_AudioFormat format, SimdLevel level)
+{
+	const Uint32 bytes = SDL_AUDIO_BITSIZE(format) / 8;
+	const TriggerLevels levels{ TriggerSlope::RISING, kHalfHeight - 5.0f, kHalfHeight };
+	return measure(kRepeat, kSamples, [&]
+	{
+		bool bArmed = false;
+		Uint32 triggers = 0;
+		for (Uint32 i = 0; i < kSamples; )
+		{
+			i += findTrigger(samples.data() + (size_t)i * bytes, format, kSamples - i, levels, bArmed, level) + 1;
+			++triggers;
+		}
+		g_sink = triggers;
+	});
+}
+
+template <typename T>
+void benchFormat(SDL_AudioFormat format, const char* name)
+{
+	using ns_Util::Logger;
+	const std::vector<Uint8> samples = makeDisplaySamples<T>();
+	const Stats scalar = benchSearch(samples, format, SimdLevel::SCALAR);
+	const Stats sse2 = benchSearch(samples, format, SimdLevel::SSE2);
+	record("trigger/search", { { "format", name }, { "simd", simdLevel2String(SimdLevel::SCALAR) } }, "ns/sample", scalar);
+	record("trigger/search", { { "format", name }, { "simd", simdLevel2String(SimdLevel::SSE2) } }, "ns/sample", sse2);
+	Logger::LOG_MSG("    ", name, " : scalar ", scalar.min, " ns (", scalar.cold, "), SSE2 ", sse2.min, " ns (", sse2.cold, "), ",
+		scalar.min / sse2.min, "x\n");
+}
+}
+
+void runTriggerBench()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Trigger search per sample, best of ", kRepeat, " warm runs, cold run in brackets\n");
+	benchFormat<Uint8>(AUDIO_U8, "AUDIO_U8 ");
+	benchFormat<Sint16>(AUDIO_S16, "AUDIO_S16");
+	benchFormat<Uint16>(AUDIO_U16, "AUDIO_U16");
+	benchFormat<Sint32>(AUDIO_S32, "AUDIO_S32");
+	benchFormat<float>(AUDIO_F32, "AUDIO_F32");
+	Logger::LOG_MSG('\n');
+}
+}
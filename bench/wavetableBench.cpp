@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "bench.h"
+#include "soundWave.h"
+#include "wavetable.h"
+#include "logger.h"
+
+namespace ns_Bench
+{
+namespace
+{
+constexpr int		kSnrSamples = 1 << 16;
+constexpr int		kSpeedSamples = 1 << 22;
+constexpr int		kRepeat = 5;
+constexpr double	kFrequency = 440.0;		// Not a divisor of the sample rate, so every table position gets visited
+
+WaveKernelParams makeParams(const Wavetable& table)
+{
+	WaveKernelParams params;
+	params.increment = kFrequency / SAMPLE_RATE;
+	params.amplitude = 1.0f;
+	params.wavetable = &table;
+	return params;
+}
+
+// SNR of the interpolated table against the exact waveform at the same phases
+double measureSnr(const Wavetable& table, Interpolation i)
+{
+	std::vector<float> out(kSnrSamples);
+	const WaveKernelParams params = makeParams(table);
+	table.render(out.data(), out.size(), params, i);
+
+	// The tables step through the cycle with a 32 bit fixed point phase, follow the same phase
+	// here so only the interpolation error is measured
+	const Uint32 inc = (Uint32)(Uint64)(params.increment * 4294967296.0);
+	Uint32 phase = 0;
+
+	double signal = 0;
+	double noise = 0;
+	for (int n = 0; n < kSnrSamples; ++n, phase += inc)
+	{
+		const double p = phase / 4294967296.0;
+		const double exact = waveformAt(table.getWaveForm(), p);
+		signal += exact * exact;
+		noise += (out[n] - exact) * (out[n] - exact);
+	}
+	return noise > 0 ? 10 * std::log10(signal / noise) : 999.0;
+}
+
+Stats measureSpeed(const Wavetable& table, Interpolation i)
+{
+	std::vector<float> out(SAMPLE_COUNT);
+	WaveKernelParams params = makeParams(table);
+	return measure(kRepeat, kSpeedSamples, [&] { params.phase = 0; }, [&]
+	{
+		double sum = 0;
+		for (int pos = 0; pos < kSpeedSamples; pos += SAMPLE_COUNT)
+		{
+			table.render(out.data(), out.size(), params, i);
+			params.phase += SAMPLE_COUNT * params.increment;
+			params.phase -= std::floor(params.phase);
+			sum += out[0];
+		}
+		g_sink = sum;
+	});
+}
+}
+
+void runWavetableReport()
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Wavetable precision vs speed, ", kFrequency, " Hz at ", SAMPLE_RATE, " Hz\n");
+
+	const double snrTargets[] = { 60.0, 90.0, 120.0 };
+	for (int w = 0; w < (int)WaveForm::MAX; ++w)
+	{
+		Logger::LOG_MSG("    ", waveForm2String((WaveForm)w), '\n');
+		for (int i = 0; i < (int)Interpolation::MAX; ++i)
+		{
+			int smallestForTarget[3] = { -1, -1, -1 };
+			for (int sizeLog2 = WavetableBank::MIN_SIZE_LOG2; sizeLog2 <= WavetableBank::MAX_SIZE_LOG2; sizeLog2 += 2)
+			{
+				const Wavetable& table = WavetableBank::get(sizeLog2).table((WaveForm)w);
+				const double snr = measureSnr(table, (Interpolation)i);
+				const Stats speed = measureSpeed(table, (Interpolation)i);
+				record("wavetable/render", { { "waveForm", waveForm2String((WaveForm)w) }, { "interpolation", interpolation2String((Interpolation)i) },
+					{ "size", table.size() }, { "snrDb", snr } }, "ns/sample", speed);
+
+				Logger::LOG_MSG("        ", interpolation2String((Interpolation)i), ", ", table.size(), " points : SNR ",
+					snr, " dB, ", speed.min, " ns/sample (", speed.cold, ")\n");
+
+				for (int t = 0; t < 3; ++t)
+				{
+					if (smallestForTarget[t] < 0 && snr >= snrTargets[t])
+					{
+						smallestForTarget[t] = (int)table.size();
+					}
+				}
+			}
+			for (int t = 0; t < 3; ++t)
+			{
+				Logger::LOG_MSG("        ", interpolation2String((Interpolation)i), ", smallest table for ", snrTargets[t], " dB : ");
+				if (smallestForTarget[t] < 0)
+				{
+					Logger::LOG_MSG("not reachable\n");
+				}
+				else
+				{
+					Logger::LOG_MSG(smallestForTarget[t], " points\n");
+				}
+			}
+		}
+	}
+	Logger::LOG_MSG('\n');
+}
+}
@@ -1,19 +1,16 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
 #include "SoundWavePlayer.h"
+#include "sampleFormat.h"
 #include "constants.h"
 #include "logger.h"
 
-DisplayBuffer::~DisplayBuffer()
-{
-	delete[] m_pBuffer;
-	m_pBuffer = nullptr;
-}
-
 DisplayBuffer::DisplayBuffer(Uint32 sampleCount, SDL_AudioFormat type)
+	: m_sampleCount(sampleCount)
 {
 	setFormat(type);
-	m_size = sampleCount * m_bytes;
-	m_pBuffer = new Uint8[m_size];
-	clear();
 }
 
 void DisplayBuffer::setFormat(SDL_AudioFormat type)
@@ -35,12 +32,32 @@ void DisplayBuffer::setFormat(SDL_AudioFormat type)
 	{
 		ns_Util::Logger::LOG_ERROR("Unkown format!");
 	}
+	m_buffer.assign((size_t)m_sampleCount * m_bytes, 0);
+	clear();
+}
+
+void DisplayBuffer::append(const Uint8* pSamples, Uint32 count, Uint64 firstSample)
+{
+	if (firstSample > m_endSample && m_endSample != 0)
+	{
+		m_droppedSamples += firstSample - m_endSample;
+	}
+	m_endSample = firstSample + count;
+
+	if (count >= m_sampleCount)
+	{
+		// Only the newest m_sampleCount samples survive
+		memcpy(m_buffer.data(), pSamples + (size_t)(count - m_sampleCount) * m_bytes, m_buffer.size());
+		return;
+	}
+	const size_t keep = (size_t)(m_sampleCount - count) * m_bytes;
+	memmove(m_buffer.data(), m_buffer.data() + (size_t)count * m_bytes, keep);
+	memcpy(m_buffer.data() + keep, pSamples, (size_t)count * m_bytes);
 }
 
 void DisplayBuffer::clear()
 {
-	memset(m_pBuffer, 0, m_size * sizeof(Uint8));
-	m_pos = 0;
+	memset(m_buffer.data(), 0, m_buffer.size() * sizeof(Uint8));
 }
 
 void DisplayBuffer::print(const std::string & prefix) const
@@ -48,9 +65,10 @@ void DisplayBuffer::print(const std::string & prefix) const
 	using ns_Util::Logger;
 	Logger::LOG_MSG(prefix, "DisplayBuffer: \n");
 	Logger::LOG_MSG(prefix, "    Format             : ", audioFormat2String(m_type), '\n');
-	Logger::LOG_MSG(prefix, "    Size(# of samples) : ", m_size, '\n');
+	Logger::LOG_MSG(prefix, "    Size(# of samples) : ", m_sampleCount, '\n');
 	Logger::LOG_MSG(prefix, "    Bytes(per sample)  : ", m_bytes, '\n');
-	Logger::LOG_MSG(prefix, "    Curr position      : ", m_pos, '\n');
+	Logger::LOG_MSG(prefix, "    End position       : ", m_endSample, '\n');
+	Logger::LOG_MSG(prefix, "    Dropped samples    : ", m_droppedSamples, '\n');
 }
 
 
@@ -58,9 +76,12 @@ void DisplayBuffer::print(const std::string & prefix) const
 SoundWavePlayer::SoundWavePlayer(int f, int a, SoundWave::value_type phase, WaveForm w, 
 	int sampleRate, SDL_AudioFormat format, Uint8 channels, Uint16 sampleCount, SDL_AudioCallback callback, 
 	int displayWidth, int displayHeight)
-	: m_soundWave(f, a, w, phase)
-	, m_audioCallback(callback)
+	: m_audioCallback(callback)
+	, m_soundWave(f, a, w, phase, sampleRate)
+	, m_audioWave(f, 1, w, phase, sampleRate)
+	, m_fadeWave(f, 1, w, phase, sampleRate)
 	, m_graphBuffer(sampleCount, format)
+	, m_pDisplayRing(std::make_unique<DisplayRing>())
 	, m_displayWidth(displayWidth)
 	, m_displayHeight(displayHeight)
 {
@@ -82,6 +103,7 @@ bool SoundWavePlayer::init()
 	// NOTE :: ms = (sampleframes * 1000) / freq
 	m_desiredSpec.callback = m_audioCallback;
 	m_desiredSpec.userdata = this;
+	openPcmFile();
 
 	m_deviceId = SDL_OpenAudioDevice(NULL, 0, &m_desiredSpec, &m_deviceSpec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
 	if (m_deviceId == 0)
@@ -89,10 +111,185 @@ bool SoundWavePlayer::init()
 		ns_Util::Logger::LOG_SDL_ERROR("Failed to open audio");
 		return false;
 	}
-	m_audioPos = 0;
+	setupAudio();
+	return true;
+}
+
+bool SoundWavePlayer::initOffline(const SDL_AudioSpec& spec)
+{
+	m_soundWave.reEquateValues();
+
+	m_desiredSpec = spec;
+	m_desiredSpec.callback = m_audioCallback;
+	m_desiredSpec.userdata = this;
+	openPcmFile();
+
+	// What SDL_OpenAudioDevice() would have filled in, a played file may have changed the layout
+	m_deviceSpec = m_desiredSpec;
+	m_deviceSpec.silence = (m_deviceSpec.format == AUDIO_U8 || m_deviceSpec.format == AUDIO_U16) ? 0x80 : 0x00;
+	m_deviceSpec.size = (Uint32)m_deviceSpec.samples * m_deviceSpec.channels * SDL_AUDIO_BITSIZE(m_deviceSpec.format) / 8;
+	m_deviceId = 0;
+	setupAudio();
+
+	// Take the parameters now, so the render starts at full level instead of ramping up from
+	// silence in the first block like a device that starts playing does
+	if (m_params.update())
+	{
+		const AudioParams& params = m_params.front();
+		const SoundWave::phase_type phase = m_audioWave.getNormalizedPhase();
+		m_audioWave = params.wave;
+		m_audioWave.setNormalizedPhase(phase);
+		m_fadeWave = m_audioWave;
+		m_gain = m_gainTarget = params.gain;
+	}
+	return true;
+}
+
+void SoundWavePlayer::setupAudio()
+{
+	setAudioPosition(0);
 	m_audioLength = getSampleRate();
+
+	// The display keeps samples in device format, which a played file may have changed
+	m_graphBuffer.setFormat(getAudioFormat());
+	m_soundWave.setSampleRate(getSampleRate());
+	m_soundWave.resetPhase();
+
+	// The device is still paused, so the audio side can be set up from here
+	m_audioWave = m_soundWave;
+	m_audioWave.setAmplitude(1);
+	m_fadeWave = m_audioWave;
+	m_renderBuffer.assign(getSampleCount(), 0);
+	m_fadeBuffer.assign(getSampleCount(), 0);
+	m_gain = m_gainTarget = m_gainStep = 0;
+	m_bRamping = m_bCrossfade = false;
+	m_callbackTiming.reset();
+	m_lastTimingDump = CallbackTiming::Report{};
+	m_msSinceTimingDump = 0;
+
+	startFilePlayback();
+
+	// Every display block holds one render block, allocated up front so the audio thread never does
+	m_displayBlockSize = getSampleCount();
+	m_pDisplayRing->reset();
+	for (size_t i = 0; i < DisplayRing::capacity(); ++i)
+	{
+		m_pDisplayRing->slots()[i].samples.assign((size_t)m_displayBlockSize * graphBufferBytes(), 0);
+	}
+	m_capturedFrames = 0;
+	m_captureScratch.assign((size_t)getSampleCount() * graphBufferBytes(), 0);
+	m_bCapturing = m_bTriggerArmed = m_bSingleDone = false;
+	m_holdoffLeft = m_samplesWaiting = 0;
+	m_lastSample = 0.0f;
+	m_rearmSeen = m_rearmRequests.load(std::memory_order_relaxed);
+	m_triggeredFrames.store(0, std::memory_order_relaxed);
+	m_autoFrames.store(0, std::memory_order_relaxed);
+	for (int i = 0; i < TripleBuffer<DisplayFrame>::SLOT_COUNT; ++i)
+	{
+		DisplayFrame& frame = m_displayFrames.slots()[i];
+		frame.samples.assign((size_t)std::max(MAX_RECORD_LENGTH, graphBufferSize()) * graphBufferBytes(), 0);
+		frame.size = 0;
+		frame.count = 0;
+		frame.frameNumber = 0;
+	}
+
+	setRecordLength(graphBufferSize());
+	m_columns.resize(m_displayWidth);
+	m_traceRenderer.reserve(TRACE_COUNT, std::max(graphBufferSize(), (Uint32)m_displayWidth));
+	TraceStyle style;
+	style.color = m_waveColor;
+	style.thickness = m_waveSF;
+	m_traceRenderer.setStyle(TRACE_WAVE, style);
+	style.color = m_rmsColor;
+	style.thickness = 1.0f;
+	m_traceRenderer.setStyle(TRACE_RMS, style);
+
+	m_pyramid.clear();
+	m_pyramid.setBias(getDisplayHeight() / 2.0f);
+	m_rms.resize(m_displayWidth);
+	m_rmsColumns.resize(m_displayWidth);
+
+	const SDL_FRect area = spectrumArea();
+	m_spectrum.reset(getSampleRate(), getDisplayHeight() / 2.0f, getDisplayHeight() / 2.0f, (Uint32)area.w);
+	m_spectrumHeights.assign((size_t)area.w, 0.0f);
+	m_waterfall.setSize((int)area.w, (int)area.h);
+	m_waterfall.setRange(SpectrumAnalyzer::DB_FLOOR, 0.0f);
+	m_waterfallSpectrum = 0;
+	m_persistence.reset(m_displayWidth, m_displayHeight, std::max(MAX_RECORD_LENGTH, graphBufferSize()), graphBufferBytes());
+	if (m_bPersistenceView)
+	{
+		m_persistence.start();
+	}
+	style.color = m_spectrumColor;
+	m_traceRenderer.setStyle(TRACE_SPECTRUM, style);
+
+	publishParams();
 	graphBufferClear();
-	return true;
+}
+
+void SoundWavePlayer::openPcmFile()
+{
+	if (m_audioFile.empty() || !PcmFile::handles(m_audioFile))
+	{
+		return;
+	}
+	PcmLayout rawLayout = m_rawLayout;
+	if (!rawLayout.valid())
+	{
+		rawLayout.format = m_desiredSpec.format;
+		rawLayout.channels = m_desiredSpec.channels;
+		rawLayout.sampleRate = m_desiredSpec.freq;
+	}
+	m_pPcmFile = std::make_unique<PcmFile>();
+	if (!m_pPcmFile->open(m_audioFile, rawLayout))
+	{
+		m_pPcmFile.reset();
+		return;
+	}
+
+	// Ask the device for the file's own layout, so it can play without any conversion
+	const PcmLayout& layout = m_pPcmFile->layout();
+	if (!layout.bPacked24)
+	{
+		m_desiredSpec.format = layout.format;
+	}
+	if (layout.channels == MONO || layout.channels == STEREO || layout.channels == QUAD || layout.channels == HEXA)
+	{
+		m_desiredSpec.channels = (Uint8)layout.channels;
+	}
+	m_desiredSpec.freq = layout.sampleRate;
+}
+
+void SoundWavePlayer::startFilePlayback()
+{
+	m_bMappedPlayback = false;
+	if (m_audioFile.empty())
+	{
+		return;
+	}
+	m_fileStream.setLevels(m_volume, (float)m_soundWave.getAmplitude(), getDisplayHeight() / 2.0f);
+	if (!PcmFile::handles(m_audioFile))
+	{
+		if (!m_fileStream.open(m_audioFile, m_deviceSpec))
+		{
+			ns_Util::Logger::LOG_ERROR("Playing the generated tone instead of ", m_audioFile, '\n');
+		}
+	}
+	else if (!m_pPcmFile || m_pPcmFile->frameCount() == 0)
+	{
+		ns_Util::Logger::LOG_ERROR("No audio in ", m_audioFile, ", playing the generated tone\n");
+		m_pPcmFile.reset();
+	}
+	else if (m_pPcmFile->matches(m_deviceSpec))
+	{
+		setPlayhead(0);
+		m_bMappedPlayback = true;
+	}
+	else if (!m_fileStream.open(std::make_unique<PcmDecoder>(std::move(m_pPcmFile)), m_deviceSpec))
+	{
+		// The device took another layout, the decode thread converts then
+		ns_Util::Logger::LOG_ERROR("Playing the generated tone instead of ", m_audioFile, '\n');
+	}
 }
 
 void SoundWavePlayer::start()
@@ -102,7 +299,6 @@ void SoundWavePlayer::start()
 
 void SoundWavePlayer::update(uint64_t elapsedTimeInMs, const std::vector<SDL_Event>& events)
 {
-	(void)elapsedTimeInMs;
 	for (size_t i = 0, size = events.size(); i < size; ++i)
 	{
 		if (events[i].type == SDL_KEYDOWN)
@@ -110,50 +306,200 @@ void SoundWavePlayer::update(uint64_t elapsedTimeInMs, const std::vector<SDL_Eve
 			handleKeyEvent(events[i].key.keysym.scancode);
 		}
 	}
+	m_waterfall.update(events);
+	m_persistence.update(events);
+	drainDisplayRing();
+
+	// Page the mapped file in ahead of the audio thread and out behind it, from here so the
+	// audio thread never makes the system calls
+	if (m_bMappedPlayback)
+	{
+		m_pPcmFile->adviseAround(getPlayhead());
+	}
+
+	m_msSinceTimingDump += elapsedTimeInMs;
+	if (m_msSinceTimingDump >= TIMING_DUMP_INTERVAL_MS)
+	{
+		const CallbackTiming::Report report = m_callbackTiming.report();
+		if (m_bTimingDump)
+		{
+			ns_Util::Logger::LOG_MSG("Last ", m_msSinceTimingDump / 1000.0, " s of audio\n");
+			report.since(m_lastTimingDump).print("    ");
+		}
+		m_lastTimingDump = report;
+		m_msSinceTimingDump = 0;
+	}
+}
+
+void SoundWavePlayer::setRecordLength(Uint32 samples)
+{
+	m_recordLength.store(std::clamp(samples, MIN_RECORD_LENGTH, MAX_RECORD_LENGTH), std::memory_order_relaxed);
+}
+
+const DisplayFrame& SoundWavePlayer::acquireDisplayFrame()
+{
+	m_displayFrames.update();
+	return m_displayFrames.front();
+}
+
+void SoundWavePlayer::drainDisplayRing()
+{
+	while (const DisplayBlock* pBlock = m_pDisplayRing->peek())
+	{
+		m_graphBuffer.append(pBlock->samples.data(), pBlock->count, pBlock->firstSample);
+		m_pyramid.append(pBlock->samples.data(), getGraphBufferFormat(), pBlock->count);
+		m_spectrum.append(pBlock->samples.data(), getGraphBufferFormat(), pBlock->count);
+		m_pDisplayRing->pop();
+	}
+	if (m_spectrumView != SpectrumView::OFF)
+	{
+		m_spectrum.submit();
+	}
 }
 
 void SoundWavePlayer::draw(SDL_Renderer* pRenderer)
 {
-	SDL_SetRenderDrawColor(pRenderer, m_waveColor.r, m_waveColor.g, m_waveColor.b, m_waveColor.a);
-	SDL_RenderSetScale(pRenderer, m_waveSF, m_waveSF);
+	drawSpectrum(pRenderer);
+	const SDL_FRect area = traceArea();
+	if (m_bHistoryView)
+	{
+		drawHistory(pRenderer, area);
+		return;
+	}
+	m_traceRenderer.clearTrace(TRACE_RMS);
 
-	const int yNormalizer = m_displayHeight;
+	if (m_bPersistenceView)
+	{
+		m_traceRenderer.clearTrace(TRACE_WAVE);
+		m_persistence.draw(pRenderer, SDL_Rect{ (int)area.x, (int)area.y, (int)area.w, (int)area.h });
+		m_traceRenderer.draw(pRenderer);
+		return;
+	}
+
+	const DisplayFrame& frame = acquireDisplayFrame();
+	if (frame.frameNumber == 0)
+	{
+		return;
+	}
+	const Uint8* pSamples = frame.samples.data();
+
+	// More samples than pixels, one min/max span per column keeps the cost at O(width)
+	const Uint32 columns = (Uint32)area.w;
+	if (frame.count > columns)
+	{
+		if (decimateMinMax(pSamples, frame.format, frame.count, m_columns.data(), columns, m_soundWave.getSimdLevel()))
+		{
+			m_traceRenderer.setColumns(TRACE_WAVE, m_columns.data(), columns, area);
+		}
+		else
+		{
+			ns_Util::Logger::LOG_ERROR("Unkown format!");
+			m_traceRenderer.clearTrace(TRACE_WAVE);
+		}
+		m_traceRenderer.draw(pRenderer);
+		return;
+	}
 
-	switch (getAudioFormat())
+	switch (frame.format)
 	{
 		case AUDIO_S8:
-			drawHelper<Sint8>((Sint8*)getGraphBuffer(), pRenderer, 0, m_displayWidth, yNormalizer);
+			m_traceRenderer.setSamples(TRACE_WAVE, (const Sint8*)pSamples, frame.count, area, frame.triggerOffset);
 			break;
 
 		case AUDIO_U8:
-			drawHelper<Uint8>((Uint8*)getGraphBuffer(), pRenderer, 0, m_displayWidth, yNormalizer);
+			m_traceRenderer.setSamples(TRACE_WAVE, (const Uint8*)pSamples, frame.count, area, frame.triggerOffset);
 			break;
 
 		case AUDIO_S16:
-			drawHelper<Sint16>((Sint16*)getGraphBuffer(), pRenderer, 0, m_displayWidth, yNormalizer);
+			m_traceRenderer.setSamples(TRACE_WAVE, (const Sint16*)pSamples, frame.count, area, frame.triggerOffset);
 			break;
 
 		case AUDIO_U16:
-			drawHelper<Uint16>((Uint16*)getGraphBuffer(), pRenderer, 0, m_displayWidth, yNormalizer);
+			m_traceRenderer.setSamples(TRACE_WAVE, (const Uint16*)pSamples, frame.count, area, frame.triggerOffset);
 			break;
 
 		case AUDIO_S32:
-			drawHelper<Sint32>((Sint32*)getGraphBuffer(), pRenderer, 0, m_displayWidth, yNormalizer);
+			m_traceRenderer.setSamples(TRACE_WAVE, (const Sint32*)pSamples, frame.count, area, frame.triggerOffset);
 			break;
 
 		case AUDIO_F32:
-			drawHelper<float>((float*)getGraphBuffer(), pRenderer, 0, m_displayWidth, yNormalizer);
+			m_traceRenderer.setSamples(TRACE_WAVE, (const float*)pSamples, frame.count, area, frame.triggerOffset);
 			break;
 
 		default:
 			ns_Util::Logger::LOG_ERROR("Unkown format!");
+			m_traceRenderer.clearTrace(TRACE_WAVE);
 			break;
 	}
+	m_traceRenderer.draw(pRenderer);
+}
+
+void SoundWavePlayer::drawHistory(SDL_Renderer* pRenderer, const SDL_FRect& area)
+{
+	// Newest summarised stretch of the recording, at the current zoom
+	const Uint32 columns = (Uint32)area.w;
+	const Uint64 available = m_pyramid.summarisedCount();
+	const Uint64 span = std::min(m_historySamplesPerColumn * columns, available);
+
+	if (m_pyramid.query(available - span, span, m_columns.data(), m_rms.data(), columns))
+	{
+		const float bias = m_pyramid.getBias();
+		for (Uint32 c = 0; c < columns; ++c)
+		{
+			m_rmsColumns[c].min = bias - m_rms[c];
+			m_rmsColumns[c].max = bias + m_rms[c];
+		}
+		m_traceRenderer.setColumns(TRACE_WAVE, m_columns.data(), columns, area);
+		m_traceRenderer.setColumns(TRACE_RMS, m_rmsColumns.data(), columns, area);
+	}
+	else
+	{
+		m_traceRenderer.clearTrace(TRACE_WAVE);
+		m_traceRenderer.clearTrace(TRACE_RMS);
+	}
+	m_traceRenderer.draw(pRenderer);
+}
+
+void SoundWavePlayer::drawSpectrum(SDL_Renderer* pRenderer)
+{
+	m_traceRenderer.clearTrace(TRACE_SPECTRUM);
+	if (m_spectrumView == SpectrumView::OFF)
+	{
+		return;
+	}
+	const SpectrumAnalyzer::Spectrum& spectrum = m_spectrum.acquireSpectrum();
+	const SDL_FRect area = spectrumArea();
+
+	// One column per new spectrum, so the waterfall scrolls as fast as spectra come in
+	if (m_spectrumView == SpectrumView::WATERFALL)
+	{
+		if (spectrum.frameNumber != m_waterfallSpectrum && spectrum.frameNumber != 0)
+		{
+			m_waterfall.push(pRenderer, spectrum.columnDb.data(), spectrum.columns);
+			m_waterfallSpectrum = spectrum.frameNumber;
+		}
+		m_waterfall.draw(pRenderer, SDL_Rect{ (int)area.x, (int)area.y, (int)area.w, (int)area.h });
+		return;
+	}
+	if (spectrum.frameNumber == 0)
+	{
+		return;
+	}
+
+	// 0 dB at the top of the area, SpectrumAnalyzer::DB_FLOOR at the bottom
+	const float pixelsPerDb = area.h / -SpectrumAnalyzer::DB_FLOOR;
+	const Uint32 columns = std::min(spectrum.columns, (Uint32)m_spectrumHeights.size());
+	for (Uint32 c = 0; c < columns; ++c)
+	{
+		m_spectrumHeights[c] = std::clamp((spectrum.columnDb[c] - SpectrumAnalyzer::DB_FLOOR) * pixelsPerDb, 0.0f, area.h);
+	}
+	m_traceRenderer.setSamples(TRACE_SPECTRUM, m_spectrumHeights.data(), columns, area);
 }
 
 void SoundWavePlayer::play()
 {
 	m_bPaused = false;
+	m_callbackTiming.restartInterval();
 	SDL_PauseAudioDevice(m_deviceId, 0);
 }
 
@@ -174,11 +520,11 @@ void SoundWavePlayer::print(const std::string& prefix) const
 	using ns_Util::Logger;
 	Logger::LOG_MSG(prefix, "SoundWavePlayer: \n");
 	Logger::LOG_MSG(prefix, "    Device Id              : ", m_deviceId, '\n');
-	Logger::LOG_MSG(prefix, "    Audio Position         : ", m_audioPos, '\n');
+	Logger::LOG_MSG(prefix, "    Audio Position         : ", getAudioPosition(), '\n');
 	Logger::LOG_MSG(prefix, "    Audio Length           : ", m_audioLength, '\n');
 	Logger::LOG_MSG(prefix, "    Volume                 : ", m_volume, '\n');
 	Logger::LOG_MSG(prefix, "    WaveColor(R, G, B, A)  : (", (int)m_waveColor.r, ',', (int)m_waveColor.g, ',', (int)m_waveColor.b, ',', (int)m_waveColor.a, ")\n");
-	Logger::LOG_MSG(prefix, "    Wave point scaling     : ", m_waveSF, '\n');
+	Logger::LOG_MSG(prefix, "    Trace thickness        : ", m_waveSF, '\n');
 	Logger::LOG_MSG(prefix, "    Display Width          : ", m_displayWidth, '\n');
 	Logger::LOG_MSG(prefix, "    Display Height         : ", m_displayHeight, '\n');
 	Logger::LOG_MSG(prefix, "    Desired Audio Specs    : \n");
@@ -186,23 +532,50 @@ void SoundWavePlayer::print(const std::string& prefix) const
 	Logger::LOG_MSG(prefix, "    Device Audio Specs     : \n");
 	printAudioSpec(m_deviceSpec, prefix + "          ");
 	m_soundWave.print(prefix + "          ");
-	m_graphBuffer.print(prefix + "          ");
-}
-
-template<typename T>
-void SoundWavePlayer::drawHelper(T *arr, SDL_Renderer* pRenderer, int xStart, int xEnd, int yNormalizer)
-{
-	for (int x2 = xStart + 1, x1 = xStart, y2 = 0, y1 = 0; x2 < xEnd; ++x2, ++x1)
+	m_fileStream.print(prefix + "          ");
+	if (m_pPcmFile)
 	{
-		y2 = static_cast<int>((yNormalizer - arr[x2]) / m_waveSF);
-		y1 = static_cast<int>((yNormalizer - arr[x1]) / m_waveSF);
-		SDL_RenderDrawLine(pRenderer, int(x2 / m_waveSF), y2, int(x1 / m_waveSF), y1);
+		Logger::LOG_MSG(prefix, "    Mapped playback        : ", !m_bMappedPlayback ? "Off" : (m_volume == 1.0f ? "Straight from the mapping" : "Scaled by the volume from the mapping"), ", frame ", getPlayhead(), '\n');
+		m_pPcmFile->print(prefix + "          ");
 	}
+	Logger::LOG_MSG(prefix, "    Period cache           : ", m_bPeriodCacheEnabled ? "Enabled" : "Disabled", '\n');
+	Logger::LOG_MSG(prefix, "    Display ring           : ", m_pDisplayRing->size(), " of ", DisplayRing::capacity(), " blocks filled, ",
+		m_pDisplayRing->overruns(), " overruns\n");
+	const DisplayFrame& frame = m_displayFrames.front();
+	Logger::LOG_MSG(prefix, "    Record length          : ", getRecordLength(), " samples\n");
+	Logger::LOG_MSG(prefix, "    Display frame          : #", frame.frameNumber, " from sample ", frame.firstSample, ", ",
+		waveForm2String(frame.waveForm), " at ", frame.frequency, " Hz, gain ", frame.gain, '\n');
+	Logger::LOG_MSG(prefix, "    Trigger                : ", triggerMode2String(m_trigger.mode), ", ", triggerSlope2String(m_trigger.slope),
+		" at ", m_trigger.level, ", hysteresis ", m_trigger.hysteresis, ", holdoff ", m_trigger.holdoffMs, " ms\n");
+	Logger::LOG_MSG(prefix, "    Trigger frames         : ", m_triggeredFrames.load(std::memory_order_relaxed), " triggered, ",
+		m_autoFrames.load(std::memory_order_relaxed), " auto\n");
+	Logger::LOG_MSG(prefix, "    History view           : ", m_bHistoryView ? "On" : "Off", ", ", m_historySamplesPerColumn, " samples per column\n");
+	Logger::LOG_MSG(prefix, "    Spectrum view          : ", m_spectrumView == SpectrumView::OFF ? "Off" : (m_spectrumView == SpectrumView::TRACE ? "Trace" : "Waterfall"), '\n');
+	m_spectrum.print(prefix + "          ");
+	m_waterfall.print(prefix + "          ");
+	Logger::LOG_MSG(prefix, "    Persistence view       : ", m_bPersistenceView ? "On" : "Off", '\n');
+	m_persistence.print(prefix + "          ");
+	m_callbackTiming.report().print(prefix + "          ");
+	Logger::LOG_MSG(prefix, "    Timing dump            : ", m_bTimingDump ? "Every " : "Off, every ", TIMING_DUMP_INTERVAL_MS / 1000, " s\n");
+	m_graphBuffer.print(prefix + "          ");
+	m_pyramid.print(prefix + "          ");
+	m_traceRenderer.print(prefix + "          ");
 }
 
 void SoundWavePlayer::exit()
 {
-	SDL_CloseAudioDevice(m_deviceId);
+	if (m_deviceId != 0)
+	{
+		SDL_CloseAudioDevice(m_deviceId);
+		m_deviceId = 0;
+	}
+	m_spectrum.stop();
+	m_waterfall.releaseTexture();
+	m_persistence.stop();
+	m_persistence.releaseTexture();
+	m_fileStream.close();
+	m_bMappedPlayback = false;
+	m_pPcmFile.reset();
 	SDL_zero(m_desiredSpec);
 	SDL_zero(m_deviceSpec);
 	m_graphBuffer.clear();
@@ -215,21 +588,104 @@ void SoundWavePlayer::handleKeyEvent(SDL_Scancode keyCode)
 		case SDL_SCANCODE_C:
 			m_soundWave.setNextWaveForm();
 			m_graphBuffer.clear();
-			m_audioPos = 0;
+			publishParams();
+			break;
+
+		case SDL_SCANCODE_W:
+			m_soundWave.setNextOscillatorMode();
+			publishParams();
+			break;
+		case SDL_SCANCODE_I:
+			m_soundWave.setNextInterpolation();
+			publishParams();
+			break;
+		case SDL_SCANCODE_P:
+			m_bPeriodCacheEnabled = !m_bPeriodCacheEnabled;
+			publishParams();
 			break;
 
 		case SDL_SCANCODE_RIGHT:
 			m_soundWave.changeFrequency(1);
+			publishParams();
 			break;
 		case SDL_SCANCODE_LEFT:
 			m_soundWave.changeFrequency(-1);
+			publishParams();
 			break;
 		
 		case SDL_SCANCODE_UP:
 			m_soundWave.changeAmplitude(1);
+			publishParams();
 			break;
 		case SDL_SCANCODE_DOWN:
 			m_soundWave.changeAmplitude(-1);
+			publishParams();
+			break;
+
+		case SDL_SCANCODE_EQUALS:
+			setRecordLength(getRecordLength() * 2);
+			break;
+		case SDL_SCANCODE_MINUS:
+			setRecordLength(getRecordLength() / 2);
+			break;
+
+		case SDL_SCANCODE_H:
+			m_bHistoryView = !m_bHistoryView;
+			break;
+		case SDL_SCANCODE_T:
+			m_bTimingDump = !m_bTimingDump;
+			break;
+		case SDL_SCANCODE_S:
+			m_spectrumView = (SpectrumView)(((int)m_spectrumView + 1) % (int)SpectrumView::MAX);
+			break;
+		case SDL_SCANCODE_V:
+			m_spectrum.setNextWindow();
+			break;
+		case SDL_SCANCODE_RIGHTBRACKET:
+			m_spectrum.setSize(m_spectrum.getSize() * 2);
+			break;
+		case SDL_SCANCODE_LEFTBRACKET:
+			m_spectrum.setSize(m_spectrum.getSize() / 2);
+			break;
+		case SDL_SCANCODE_M:
+			m_trigger.setNextMode();
+			publishParams();
+			break;
+		case SDL_SCANCODE_E:
+			m_trigger.setNextSlope();
+			publishParams();
+			break;
+		case SDL_SCANCODE_K:
+			m_trigger.changeLevel(-0.05f);
+			publishParams();
+			break;
+		case SDL_SCANCODE_L:
+			m_trigger.changeLevel(0.05f);
+			publishParams();
+			break;
+		case SDL_SCANCODE_Y:
+			m_trigger.setNextHysteresis();
+			publishParams();
+			break;
+		case SDL_SCANCODE_O:
+			m_trigger.setNextHoldoff();
+			publishParams();
+			break;
+		case SDL_SCANCODE_R:
+			rearmTrigger();
+			break;
+		case SDL_SCANCODE_D:
+			m_bPersistenceView = !m_bPersistenceView;
+			m_bPersistenceView ? m_persistence.start() : m_persistence.stop();
+			break;
+		case SDL_SCANCODE_G:
+			m_persistence.setNextDecay();
+			break;
+		case SDL_SCANCODE_PAGEUP:
+			m_historySamplesPerColumn = std::min(m_historySamplesPerColumn * 2, MAX_HISTORY_SAMPLES_PER_COLUMN);
+			break;
+		case SDL_SCANCODE_PAGEDOWN:
+			m_historySamplesPerColumn = std::max(m_historySamplesPerColumn / 2, (Uint64)WaveformPyramid::BASE_DECIMATION);
 			break;
 
 		case SDL_SCANCODE_SPACE:
@@ -253,114 +709,590 @@ void SoundWavePlayer::printAudioSpec(const SDL_AudioSpec& spec, const std::strin
 }
 
 
-template <typename T>
-void SDLAudioCBHelper(SoundWavePlayer* pSoundWavePlayer, T* pStream, T* pGraphBuffer, int len)
+namespace
+{
+// Display samples as they are
+struct CopySample
+{
+	template <typename T>
+	INLINE T operator()(T v) const { return v; }
+};
+
+// Sends the first channel of count interleaved frames to the display, firstSample is the
+// audio position of the first frame. toDisplay maps a sample to display units.
+template <typename T, int C, typename Map = CopySample>
+INLINE void sendToDisplay(SoundWavePlayer* pSoundWavePlayer, const T* pFrames, Uint32 count, Uint64 firstSample, Map toDisplay = Map{})
+{
+	const Uint32 blockSize = pSoundWavePlayer->displayBlockSize();
+	while (blockSize > 0 && count > 0)
+	{
+		const Uint32 n = std::min(count, blockSize);
+		DisplayBlock* pBlock = pSoundWavePlayer->beginDisplayBlock();
+		if (pBlock)
+		{
+			T* pDst = reinterpret_cast<T*>(pBlock->samples.data());
+			for (Uint32 i = 0; i < n; ++i)
+			{
+				pDst[i] = toDisplay(pFrames[C * i]);
+			}
+			pBlock->firstSample = firstSample;
+			pBlock->count = n;
+			pSoundWavePlayer->commitDisplayBlock();
+		}
+		pFrames += (size_t)C * n;
+		firstSample += n;
+		count -= n;
+	}
+}
+
+// Hands the first channel of count interleaved frames to the trigger and the display frames,
+// a scratch buffer at a time
+template <typename T, int C, typename Map = CopySample>
+INLINE void captureFrames(SoundWavePlayer* pSoundWavePlayer, const T* pFrames, Uint32 count, Uint64 firstSample, Map toDisplay = Map{})
+{
+	T* pScratch = reinterpret_cast<T*>(pSoundWavePlayer->getCaptureScratch());
+	const Uint32 scratchSize = pSoundWavePlayer->captureScratchSize();
+	while (scratchSize > 0 && count > 0)
+	{
+		const Uint32 n = std::min(count, scratchSize);
+		for (Uint32 i = 0; i < n; ++i)
+		{
+			pScratch[i] = toDisplay(pFrames[C * i]);
+		}
+		pSoundWavePlayer->captureDisplay(reinterpret_cast<const Uint8*>(pScratch), n, firstSample);
+		pFrames += (size_t)C * n;
+		firstSample += n;
+		count -= n;
+	}
+}
+
+// Sends count display samples of the given size to the display
+INLINE void sendBytesToDisplay(SoundWavePlayer* pSoundWavePlayer, const Uint8* pSamples, Uint32 bytes, Uint32 count, Uint64 firstSample)
 {
+	const Uint32 blockSize = pSoundWavePlayer->displayBlockSize();
+	while (blockSize > 0 && count > 0)
+	{
+		const Uint32 n = std::min(count, blockSize);
+		DisplayBlock* pBlock = pSoundWavePlayer->beginDisplayBlock();
+		if (pBlock)
+		{
+			memcpy(pBlock->samples.data(), pSamples, (size_t)n * bytes);
+			pBlock->firstSample = firstSample;
+			pBlock->count = n;
+			pSoundWavePlayer->commitDisplayBlock();
+		}
+		pSamples += (size_t)n * bytes;
+		firstSample += n;
+		count -= n;
+	}
+}
+
+// Gain of frame i is gain + i * gainStep, so a parameter change is ramped across the block
+template <typename T, int C>
+INLINE void convertFrames(const SoundWave::sample_type* pSrc, T* pDst, Uint32 count, float gain, float gainStep, float yOffset)
+{
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		const T value = static_cast<T>(pSrc[i] * (gain + i * gainStep) + yOffset);
+
+		// Same audio data for all channels
+		for (int j = 0; j < C; ++j)
+		{
+			pDst[C * i + j] = value;
+		}
+	}
+}
+
+// PeriodConvertFn for one sample type and channel count
+template <typename T, int C>
+void convertPeriod(const float* pSrc, Uint8* pFrames, Uint8* pDisplay, Uint32 count, float gain, float yOffset)
+{
+	T* pOut = reinterpret_cast<T*>(pFrames);
+	T* pMono = reinterpret_cast<T*>(pDisplay);
+	convertFrames<T, C>(pSrc, pOut, count, gain, 0.0f, yOffset);
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		pMono[i] = pOut[C * i];
+	}
+}
+
+// Fully specialized audio callback, waveform, sample type and channel count are all known
+// at compile time so the conversion loop has no branches left in it.
+template <WaveForm W, typename T, int C>
+void SDLAudioKernel(SoundWavePlayer* pSoundWavePlayer, Uint8* pStreamBytes, int len)
+{
+	T* pStream = reinterpret_cast<T*>(pStreamBytes);
+	const Uint32 numOfFrames = len / (sizeof(T) * C);
+
 	const float yOffset = pSoundWavePlayer->getDisplayHeight() / 2.0f;
-	const int numOfChannels = pSoundWavePlayer->getAudioChannels();
-	for (int i = 0, max = len / (pSoundWavePlayer->graphBufferBytes() * numOfChannels); i < max; ++i)
+	const float gain = pSoundWavePlayer->getGain();
+	const float gainStep = pSoundWavePlayer->getGainStep();
+
+	SoundWave& soundWave = pSoundWavePlayer->getAudioWave();
+	SoundWave::sample_type* pBlock = pSoundWavePlayer->getRenderBuffer();
+	const Uint32 blockSize = pSoundWavePlayer->renderBufferSize();
+
+	for (Uint32 done = 0; done < numOfFrames; )
 	{
-		if (pSoundWavePlayer->getAudioLength() <= 0)
+		const Uint32 count = std::min(blockSize, numOfFrames - done);
+
+		// One block render, then one conversion pass to the device format
+		soundWave.renderAs<W>(pBlock, count);
+		if (pSoundWavePlayer->isCrossfading())
 		{
-			pStream[i] = pSoundWavePlayer->getDeviceSpecs()->silence;
+			pSoundWavePlayer->crossfadeBlock(pBlock, count, done, numOfFrames);
 		}
-		else
+
+		T* pOut = pStream + (size_t)done * C;
+		convertFrames<T, C>(pBlock, pOut, count, gain + done * gainStep, gainStep, yOffset);
+
+		// Hand the data to the display for plotting
+		sendToDisplay<T, C>(pSoundWavePlayer, pOut, count, pSoundWavePlayer->getAudioPosition());
+		captureFrames<T, C>(pSoundWavePlayer, pOut, count, pSoundWavePlayer->getAudioPosition());
+
+		pSoundWavePlayer->incrementAudioPosition(count);
+		done += count;
+	}
+}
+
+// Steady state tone, streams the pre-rendered period instead of generating anything
+void SDLAudioCachedKernel(SoundWavePlayer* pSoundWavePlayer, Uint8* pStream, int len)
+{
+	const PeriodCache& cache = pSoundWavePlayer->getPeriodCache();
+	SoundWave& soundWave = pSoundWavePlayer->getAudioWave();
+	const Uint32 numOfFrames = len / cache.frameBytes();
+
+	// The cursor is derived from the phase, so switching in and out of the cache is seamless
+	Uint32 frame = cache.frameForPhase(soundWave.getNormalizedPhase());
+	for (Uint32 done = 0; done < numOfFrames; )
+	{
+		const Uint32 count = std::min(numOfFrames - done, cache.periodFrames() - frame);
+		memcpy(pStream + (size_t)done * cache.frameBytes(), cache.frames() + (size_t)frame * cache.frameBytes(), (size_t)count * cache.frameBytes());
+		const Uint8* pDisplay = cache.display() + (size_t)frame * cache.sampleBytes();
+		sendBytesToDisplay(pSoundWavePlayer, pDisplay, cache.sampleBytes(), count, pSoundWavePlayer->getAudioPosition() + done);
+		pSoundWavePlayer->captureDisplay(pDisplay, count, pSoundWavePlayer->getAudioPosition() + done);
+		done += count;
+		frame = 0;
+	}
+	soundWave.advancePhase(numOfFrames);
+	pSoundWavePlayer->incrementAudioPosition(numOfFrames);
+}
+
+// File playback, the decode thread has done all the work and this only copies out of its ring
+void SDLAudioFileKernel(SoundWavePlayer* pSoundWavePlayer, Uint8* pStream, int len)
+{
+	AudioFileStream& fileStream = pSoundWavePlayer->getFileStream();
+	const Uint32 frameBytes = fileStream.frameBytes();
+	const Uint32 numOfFrames = len / frameBytes;
+	const Uint64 firstSample = pSoundWavePlayer->getAudioPosition();
+
+	Uint32 done = 0;
+	while (done < numOfFrames)
+	{
+		const Uint8* pFrames = nullptr;
+		const Uint8* pDisplay = nullptr;
+		const Uint32 count = fileStream.beginRead(numOfFrames - done, pFrames, pDisplay);
+		if (count == 0)
 		{
-			SoundWave::value_type y = pSoundWavePlayer->getSample() * pSoundWavePlayer->getVolume();
-			pStream[numOfChannels * i] = static_cast<T>(y + yOffset);
+			break;
+		}
+		memcpy(pStream + (size_t)done * frameBytes, pFrames, (size_t)count * frameBytes);
+		sendBytesToDisplay(pSoundWavePlayer, pDisplay, fileStream.sampleBytes(), count, firstSample + done);
+		pSoundWavePlayer->captureDisplay(pDisplay, count, firstSample + done);
+		fileStream.endRead(count);
+		done += count;
+	}
 
-			// Same audio data for all channels
-			if (numOfChannels > 1)
-			{
-				for (int j = 1; j <= numOfChannels; ++j)
-				{
-					pStream[numOfChannels * i + j] = pStream[numOfChannels * i];
-				}
-			}
-			pSoundWavePlayer->incrementAudioPosition(1);
+	// Decoder fell behind or the file has ended
+	if (done < numOfFrames)
+	{
+		memset(pStream + (size_t)done * frameBytes, pSoundWavePlayer->getDeviceSpecs()->silence, (size_t)(numOfFrames - done) * frameBytes);
+		fileStream.underrun(numOfFrames - done);
+	}
+	pSoundWavePlayer->incrementAudioPosition(done);
+}
+
+// Mapped file already in device format, copied straight from the mapping at full volume and
+// scaled sample by sample otherwise. The display samples are scaled from the mapping directly
+// into the display blocks and frames, they do not follow the volume.
+template <typename T, int C>
+void SDLAudioMappedKernel(SoundWavePlayer* pSoundWavePlayer, Uint8* pStream, int len)
+{
+	const PcmFile& file = pSoundWavePlayer->getPcmFile();
+	const Uint32 frameBytes = sizeof(T) * C;
+	const Uint32 numOfFrames = len / frameBytes;
+	const Uint64 firstSample = pSoundWavePlayer->getAudioPosition();
+	const float volume = pSoundWavePlayer->getFileVolume();
+	const DisplayTransform<T> toDisplay{ pSoundWavePlayer->getDisplayGain(), pSoundWavePlayer->getDisplayHeight() / 2.0f };
 
-			// Copy data to display buffer for plotting
-			Uint32& graphPos = pSoundWavePlayer->getGraphBufferPosition();
-			if (graphPos >= pSoundWavePlayer->graphBufferSize())
+	Uint64 frame = pSoundWavePlayer->getPlayhead();
+	for (Uint32 done = 0; done < numOfFrames; )
+	{
+		// Loops at the end of the file
+		if (frame >= file.frameCount())
+		{
+			frame = 0;
+		}
+		const Uint32 count = (Uint32)std::min<Uint64>(numOfFrames - done, file.frameCount() - frame);
+		const T* pFrames = reinterpret_cast<const T*>(file.frames(frame));
+		if (volume == 1.0f)
+		{
+			memcpy(pStream + (size_t)done * frameBytes, pFrames, (size_t)count * frameBytes);
+		}
+		else
+		{
+			T* pOut = reinterpret_cast<T*>(pStream) + (size_t)done * C;
+			for (size_t i = 0, n = (size_t)count * C; i < n; ++i)
 			{
-				graphPos = 0;
+				pOut[i] = toDeviceSample<T>(toNormalizedSample(pFrames[i]) * volume);
 			}
-			pGraphBuffer[graphPos++] = pStream[numOfChannels * i];
 		}
+		sendToDisplay<T, C>(pSoundWavePlayer, pFrames, count, firstSample + done, toDisplay);
+		captureFrames<T, C>(pSoundWavePlayer, pFrames, count, firstSample + done, toDisplay);
+		frame += count;
+		done += count;
 	}
+	pSoundWavePlayer->setPlayhead(frame);
+	pSoundWavePlayer->incrementAudioPosition(numOfFrames);
 }
 
-void SDLAudioCallback(void* pUserData, Uint8* pStream, int pStreamLengthInBytes)
+void SDLAudioSilenceKernel(SoundWavePlayer* pSoundWavePlayer, Uint8* pStream, int len)
 {
-	SoundWavePlayer* player = (SoundWavePlayer *)pUserData;
-	Uint8* pGraphBuffer = player->getGraphBuffer();
-	
-	switch (player->getAudioFormat())
+	memset(pStream, pSoundWavePlayer->getDeviceSpecs()->silence, len);
+}
+
+// Kernel table, indexed by [WaveForm][format][channels]
+constexpr int NUM_OF_FORMATS = 6;
+constexpr int NUM_OF_CHANNEL_LAYOUTS = 4;
+
+using ChannelKernels = std::array<SDLAudioKernelFn, NUM_OF_CHANNEL_LAYOUTS>;
+using FormatKernels = std::array<ChannelKernels, NUM_OF_FORMATS>;
+
+template <WaveForm W, typename T>
+constexpr ChannelKernels makeChannelKernels()
+{
+	return { &SDLAudioKernel<W, T, MONO>, &SDLAudioKernel<W, T, STEREO>, &SDLAudioKernel<W, T, QUAD>, &SDLAudioKernel<W, T, HEXA> };
+}
+
+template <WaveForm W>
+constexpr FormatKernels makeFormatKernels()
+{
+	return { makeChannelKernels<W, Sint8>(), makeChannelKernels<W, Uint8>(), makeChannelKernels<W, Sint16>(),
+		makeChannelKernels<W, Uint16>(), makeChannelKernels<W, Sint32>(), makeChannelKernels<W, float>() };
+}
+
+constexpr std::array<FormatKernels, (int)WaveForm::MAX> s_audioKernels =
+{
+	makeFormatKernels<WaveForm::SINE>(),
+	makeFormatKernels<WaveForm::SQUARE>(),
+	makeFormatKernels<WaveForm::SAWTOOTH>(),
+	makeFormatKernels<WaveForm::TRIANGLE>(),
+};
+
+template <typename T>
+constexpr ChannelKernels makeMappedChannelKernels()
+{
+	return { &SDLAudioMappedKernel<T, MONO>, &SDLAudioMappedKernel<T, STEREO>, &SDLAudioMappedKernel<T, QUAD>, &SDLAudioMappedKernel<T, HEXA> };
+}
+
+// Mapped file kernels, indexed by [format][channels]
+constexpr FormatKernels s_mappedKernels =
+{
+	makeMappedChannelKernels<Sint8>(), makeMappedChannelKernels<Uint8>(), makeMappedChannelKernels<Sint16>(),
+	makeMappedChannelKernels<Uint16>(), makeMappedChannelKernels<Sint32>(), makeMappedChannelKernels<float>()
+};
+
+// Period converters, indexed by [format][channels]
+using ChannelConverters = std::array<PeriodConvertFn, NUM_OF_CHANNEL_LAYOUTS>;
+
+template <typename T>
+constexpr ChannelConverters makeChannelConverters()
+{
+	return { &convertPeriod<T, MONO>, &convertPeriod<T, STEREO>, &convertPeriod<T, QUAD>, &convertPeriod<T, HEXA> };
+}
+
+constexpr std::array<ChannelConverters, NUM_OF_FORMATS> s_periodConverters =
+{
+	makeChannelConverters<Sint8>(), makeChannelConverters<Uint8>(), makeChannelConverters<Sint16>(),
+	makeChannelConverters<Uint16>(), makeChannelConverters<Sint32>(), makeChannelConverters<float>()
+};
+
+// Same order as makeFormatKernels()
+int formatIndex(SDL_AudioFormat format)
+{
+	switch (format)
 	{
-		case AUDIO_S8:
-			SDLAudioCBHelper<Sint8>(player, (Sint8*)pStream, (Sint8*)pGraphBuffer, pStreamLengthInBytes);
-			break;
+		case AUDIO_S8:	return 0;
+		case AUDIO_U8:	return 1;
+		case AUDIO_S16:	return 2;
+		case AUDIO_U16:	return 3;
+		case AUDIO_S32:	return 4;
+		case AUDIO_F32:	return 5;
+		default:		return -1;
+	}
+}
 
-		case AUDIO_U8:
-			SDLAudioCBHelper<Uint8>(player, (Uint8*)pStream, (Uint8*)pGraphBuffer, pStreamLengthInBytes);
-			break;
+// Same order as makeChannelKernels()
+int channelIndex(Uint8 channels)
+{
+	switch (channels)
+	{
+		case MONO:		return 0;
+		case STEREO:	return 1;
+		case QUAD:		return 2;
+		case HEXA:		return 3;
+		default:		return -1;
+	}
+}
+}
 
-		case AUDIO_S16:
-			SDLAudioCBHelper<Sint16>(player, (Sint16*)pStream, (Sint16*)pGraphBuffer, pStreamLengthInBytes);
-			break;
+void SoundWavePlayer::selectAudioKernels(AudioParams& params) const
+{
+	params.kernel = params.rampKernel = SDLAudioSilenceKernel;
 
-		case AUDIO_U16:
-			SDLAudioCBHelper<Uint16>(player, (Uint16*)pStream, (Uint16*)pGraphBuffer, pStreamLengthInBytes);
-			break;
+	const int wave = (int)params.wave.getWaveForm();
+	const int format = formatIndex(getAudioFormat());
+	const int channels = channelIndex(getAudioChannels());
+	if (format < 0 || channels < 0 || wave < 0 || wave >= (int)WaveForm::MAX)
+	{
+		if (isAudioReady())
+		{
+			ns_Util::Logger::LOG_ERROR("No audio kernel for ", audioFormat2String(getAudioFormat()), ", ", channelsToString(getAudioChannels()), '\n');
+		}
+		return;
+	}
+	if (m_bMappedPlayback)
+	{
+		params.kernel = params.rampKernel = s_mappedKernels[format][channels];
+		return;
+	}
+	if (m_fileStream.isOpen())
+	{
+		params.kernel = params.rampKernel = SDLAudioFileKernel;
+		return;
+	}
+	if (getAudioLength() > 0 && renderBufferSize() > 0)
+	{
+		params.kernel = params.rampKernel = s_audioKernels[wave][format][channels];
+	}
+	if (getAudioLength() > 0 && params.cache.valid())
+	{
+		params.kernel = SDLAudioCachedKernel;
+	}
+}
 
-		case AUDIO_S32:
-			SDLAudioCBHelper<Sint32>(player, (Sint32*)pStream, (Sint32*)pGraphBuffer, pStreamLengthInBytes);
-			break;
+void SoundWavePlayer::publishParams()
+{
+	AudioParams& params = m_params.back();
+	params.wave = m_soundWave;
+	params.wave.setAmplitude(1);
+	params.gain = m_soundWave.getAmplitude() * m_volume;
+	params.displayGain = (float)m_soundWave.getAmplitude();
+	params.volume = m_volume;
+	m_fileStream.setLevels(m_volume, params.displayGain, getDisplayHeight() / 2.0f);
 
-		case AUDIO_F32:
-			SDLAudioCBHelper<float>(player, (float*)pStream, (float*)pGraphBuffer, pStreamLengthInBytes);
-			break;
+	// Build the new period on this thread, the slot is not visible to the audio thread until
+	// publish(), and the slot handed back by publish() is one the audio thread has let go of
+	const int format = formatIndex(getAudioFormat());
+	const int channels = channelIndex(getAudioChannels());
+	params.cache.clear();
+	if (m_bPeriodCacheEnabled && isAudioReady() && format >= 0 && channels >= 0 && !m_fileStream.isOpen() && !m_bMappedPlayback)
+	{
+		const Uint32 sampleBytes = SDL_AUDIO_BITSIZE(getAudioFormat()) / 8;
+		params.cache.build(params.wave, s_periodConverters[format][channels], sampleBytes * getAudioChannels(), sampleBytes,
+			params.gain, getDisplayHeight() / 2.0f);
+	}
+	selectAudioKernels(params);
 
-		default:
-			ns_Util::Logger::LOG_ERROR("Unkown format!");
-			break;
+	// Trigger levels in display units, the middle of the display is zero
+	const float halfHeight = getDisplayHeight() / 2.0f;
+	const float hysteresis = m_trigger.hysteresis * halfHeight;
+	params.trigger.mode = m_trigger.mode;
+	params.trigger.levels.slope = m_trigger.slope;
+	params.trigger.levels.fire = halfHeight + m_trigger.level * halfHeight;
+	params.trigger.levels.arm = params.trigger.levels.fire + (m_trigger.slope == TriggerSlope::RISING ? -hysteresis : hysteresis);
+	params.trigger.holdoff = (Uint32)(m_trigger.holdoffMs * getSampleRate() / 1000.0f);
+	params.trigger.autoTimeout = (Uint32)(m_trigger.autoTimeoutMs * getSampleRate() / 1000.0f);
+	m_params.publish();
+}
+
+SDLAudioKernelFn SoundWavePlayer::beginAudioBlock(int len)
+{
+	if (m_params.update())
+	{
+		const AudioParams& params = m_params.front();
+
+		// Keep playing from the current phase, a new frequency only changes the slope
+		const SoundWave::phase_type phase = m_audioWave.getNormalizedPhase();
+		const bool bReshaped = params.wave.getWaveForm() != m_audioWave.getWaveForm()
+			|| params.wave.getOscillatorMode() != m_audioWave.getOscillatorMode()
+			|| params.wave.getInterpolation() != m_audioWave.getInterpolation()
+			|| params.wave.getWavetableSize() != m_audioWave.getWavetableSize();
+		if (bReshaped)
+		{
+			m_fadeWave = m_audioWave;
+			m_bCrossfade = true;
+		}
+		m_audioWave = params.wave;
+		m_audioWave.setNormalizedPhase(phase);
+
+		// Ramp the gain across this whole callback
+		const Uint32 frameBytes = SDL_AUDIO_BITSIZE(getAudioFormat()) / 8 * getAudioChannels();
+		const Uint32 numOfFrames = frameBytes > 0 ? len / frameBytes : 0;
+		m_gainTarget = params.gain;
+		m_gainStep = numOfFrames > 0 ? (m_gainTarget - m_gain) / numOfFrames : 0.0f;
+		m_bRamping = true;
 	}
+
+	const AudioParams& params = m_params.front();
+	SDLAudioKernelFn kernel = m_bRamping ? params.rampKernel : params.kernel;
+	return kernel ? kernel : SDLAudioSilenceKernel;
 }
 
-std::string audioFormat2String(SDL_AudioFormat format)
+void SoundWavePlayer::endAudioBlock()
 {
-	std::string strFormat;
-	switch (format)
+	if (m_bRamping)
 	{
-		case AUDIO_S8:
-			strFormat = "AUDIO_S8";
-			break;
+		m_gain = m_gainTarget;
+		m_gainStep = 0.0f;
+		m_bRamping = false;
+		m_bCrossfade = false;
+	}
+}
 
-		case AUDIO_U8:
-			strFormat = "AUDIO_U8";
-			break;
+void SoundWavePlayer::publishCaptureFrame()
+{
+	DisplayFrame& frame = m_displayFrames.back();
+	frame.frameNumber = ++m_capturedFrames;
+	frame.triggerPos = 0;
+	frame.waveForm = m_audioWave.getWaveForm();
+	frame.oscillatorMode = m_audioWave.getOscillatorMode();
+	frame.frequency = m_audioWave.getFrequency();
+	frame.gain = m_gain;
+	frame.format = getAudioFormat();
+	m_displayFrames.publish();
 
-		case AUDIO_S16:
-			strFormat = "AUDIO_S16";
-			break;
+	// publish() hands back an old frame, start it over
+	m_displayFrames.back().count = 0;
+}
 
-		case AUDIO_U16:
-			strFormat = "AUDIO_U16";
-			break;
+void SoundWavePlayer::captureDisplay(const Uint8* pSamples, Uint32 count, Uint64 firstSample)
+{
+	const TriggerParams& trigger = m_params.front().trigger;
+	const SDL_AudioFormat format = getAudioFormat();
+	const Uint32 bytes = SDL_AUDIO_BITSIZE(format) / 8;
 
-		case AUDIO_S32:
-			strFormat = "AUDIO_S32";
-			break;
+	if (count == 0)
+	{
+		return;
+	}
 
-		case AUDIO_F32:
-			strFormat = "AUDIO_F32";
-			break;
+	// The sample before the first one is the last one of the previous call
+	const Uint8* pFirst = pSamples;
+	const float previous = m_lastSample;
+	m_lastSample = displaySampleAt(pSamples, format, count - 1);
 
-		default:
-			strFormat = "Unkown";
-			break;
+	const Uint32 rearm = m_rearmRequests.load(std::memory_order_relaxed);
+	if (rearm != m_rearmSeen || trigger.mode != TriggerMode::SINGLE)
+	{
+		m_rearmSeen = rearm;
+		m_bSingleDone = false;
+	}
+
+	while (count > 0)
+	{
+		Uint32 n = count;
+		if (m_bCapturing)
+		{
+			DisplayFrame& frame = getCaptureFrame();
+			n = std::min(count, frame.size - frame.count);
+			memcpy(frame.samples.data() + (size_t)frame.count * bytes, pSamples, (size_t)n * bytes);
+			frame.count += n;
+			if (frame.count == frame.size)
+			{
+				std::atomic<Uint64>& frames = frame.bTriggered ? m_triggeredFrames : m_autoFrames;
+				frames.store(frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				m_persistence.submit(frame.samples.data(), format, frame.count, frame.triggerOffset);
+				publishCaptureFrame();
+				m_bCapturing = false;
+				m_bTriggerArmed = false;
+				m_bSingleDone = trigger.mode == TriggerMode::SINGLE;
+				m_holdoffLeft = trigger.holdoff;
+				m_samplesWaiting = 0;
+			}
+		}
+		else if (m_bSingleDone)
+		{
+			return;
+		}
+		else if (m_holdoffLeft > 0)
+		{
+			n = std::min(count, m_holdoffLeft);
+			m_holdoffLeft -= n;
+		}
+		else
+		{
+			// AUTO gives up on the trigger once it has waited autoTimeout samples
+			Uint32 limit = count;
+			if (trigger.mode == TriggerMode::AUTO)
+			{
+				limit = std::min(count, trigger.autoTimeout - std::min(m_samplesWaiting, trigger.autoTimeout));
+			}
+			n = findTrigger(pSamples, format, limit, trigger.levels, m_bTriggerArmed);
+			if (n == count)
+			{
+				m_samplesWaiting += n;
+			}
+			else
+			{
+				DisplayFrame& frame = getCaptureFrame();
+				frame.firstSample = firstSample + n;
+				frame.size = getRecordLength();
+				frame.count = 0;
+				frame.bTriggered = n < limit;
+				frame.triggerOffset = 0.0f;
+				if (frame.bTriggered)
+				{
+					const Uint32 fired = (Uint32)((pSamples - pFirst) / bytes) + n;
+					frame.triggerOffset = crossingOffset(fired > 0 ? displaySampleAt(pFirst, format, fired - 1) : previous,
+						displaySampleAt(pFirst, format, fired), trigger.levels.fire);
+				}
+				if (frame.size == 0)
+				{
+					return;
+				}
+				m_bCapturing = true;
+			}
+		}
+		pSamples += (size_t)n * bytes;
+		firstSample += n;
+		count -= n;
 	}
-	return strFormat;
+}
+
+void SoundWavePlayer::crossfadeBlock(SoundWave::sample_type* pBlock, Uint32 count, Uint32 offset, Uint32 total)
+{
+	SoundWave::sample_type* pFade = m_fadeBuffer.data();
+	m_fadeWave.render(pFade, count);
+
+	const float step = 1.0f / total;
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		const float t = (offset + i) * step;
+		pBlock[i] = pFade[i] + t * (pBlock[i] - pFade[i]);
+	}
+}
+
+void SDLAudioCallback(void* pUserData, Uint8* pStream, int pStreamLengthInBytes)
+{
+	const Uint64 start = SDL_GetPerformanceCounter();
+	SoundWavePlayer* player = (SoundWavePlayer *)pUserData;
+	player->beginAudioBlock(pStreamLengthInBytes)(player, pStream, pStreamLengthInBytes);
+	player->endAudioBlock();
+
+	const Uint32 frameBytes = SDL_AUDIO_BITSIZE(player->getAudioFormat()) / 8 * player->getAudioChannels();
+	player->getCallbackTiming().record(start, SDL_GetPerformanceCounter(), frameBytes > 0 ? pStreamLengthInBytes / frameBytes : 0,
+		player->getSampleRate());
 }
 
 std::string channelsToString(Uint8 channels)
@@ -1,39 +1,131 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <SDL.h>
 #include <SDL_audio.h>
 #include "soundWave.h"
+#include "periodCache.h"
+#include "tripleBuffer.h"
+#include "spscRing.h"
+#include "traceRenderer.h"
+#include "minMaxDecimator.h"
+#include "waveformPyramid.h"
+#include "audioFileStream.h"
+#include "wavFile.h"
+#include "callbackTiming.h"
+#include "spectrumAnalyzer.h"
+#include "waterfall.h"
+#include "trigger.h"
+#include "persistence.h"
+#include "sampleFormat.h"
 
 extern void SDLAudioCallback(void* pUserData, Uint8* pStream, int pStreamLengthInBytes);
-extern std::string audioFormat2String(SDL_AudioFormat format);
 extern std::string channelsToString(Uint8 channels);
 
 class SoundWavePlayer;
+
+// Audio callback specialized for one waveform, sample format and channel count
+using SDLAudioKernelFn = void (*)(SoundWavePlayer* pSoundWavePlayer, Uint8* pStream, int len);
+
+// Trigger as the audio thread runs it, see SoundWavePlayer::captureDisplay()
+struct TriggerParams
+{
+	TriggerMode			mode{ TriggerMode::AUTO };
+	TriggerLevels		levels;
+	Uint32				holdoff{};			// Samples
+	Uint32				autoTimeout{};		// Samples
+};
+
+// Everything the audio callback needs to know about the signal, written by the UI thread
+// and handed to the audio thread as one block, see SoundWavePlayer::publishParams()
+struct AudioParams
+{
+	SoundWave			wave{ 0, 1, WaveForm::SINE, 0 };	// Renders at unit amplitude, amplitude is in gain
+	float				gain{};								// amplitude * volume
+	float				displayGain{};						// Display units per full scale of a played file
+	float				volume{ 1.0f };						// Of a played file
+	SDLAudioKernelFn	kernel{};							// Steady state kernel, may stream from cache
+	SDLAudioKernelFn	rampKernel{};						// Generates every sample, used while gain or waveform move
+	PeriodCache			cache;
+	TriggerParams		trigger;
+};
+
+// Run of consecutive display samples, the first channel of the device frames in device format.
+// Filled by the audio thread in place, see SoundWavePlayer::beginDisplayBlock().
+struct DisplayBlock
+{
+	Uint64				firstSample{};		// Audio position of the first sample
+	Uint32				count{};			// # of samples in use
+	std::vector<Uint8>	samples;			// Preallocated, never resized by the audio thread
+};
+
+using DisplayRing = SpscRing<DisplayBlock, 64>;
+
+// What the right half of the display shows next to the time trace
+enum class SpectrumView
+{
+	OFF,
+	TRACE,			// Spectrum as a trace
+	WATERFALL,		// Spectra over time, scrolling
+	MAX
+};
+
+// One complete trace, getRecordLength() display samples plus the state they were captured
+// with. The audio thread assembles it in place and publishes it once full, see
+// SoundWavePlayer::getCaptureFrame().
+struct DisplayFrame
+{
+	std::vector<Uint8>	samples;			// Preallocated, never resized by the audio thread
+	Uint32				size{};				// Record length when the capture started
+	Uint32				count{};			// # of samples captured, the frame is published at size
+	Uint64				firstSample{};		// Audio position of the first sample
+	Uint64				frameNumber{};		// Increases by one per published frame, 0 is no frame yet
+	Uint32				triggerPos{};		// Sample the trace is aligned on
+	bool				bTriggered{};		// Starts at a trigger, not at an AUTO timeout
+	float				triggerOffset{};	// Trigger crossing is this many samples before the first one, [0, 1]
+	WaveForm			waveForm{};
+	OscillatorMode		oscillatorMode{};
+	int					frequency{};
+	float				gain{};				// amplitude * volume
+	SDL_AudioFormat		format{};
+};
+
+// Sliding window over the most recent display samples, always contiguous and oldest first.
+// Only the UI thread touches it, the audio thread hands samples over through DisplayRing.
 struct DisplayBuffer
 {
 	friend class SoundWavePlayer;
 
-	~DisplayBuffer();
-
 	DisplayBuffer(Uint32 sampleCount, SDL_AudioFormat type);
 
 	void setFormat(SDL_AudioFormat type);
 
 	// size is in sample not in byte
-	INLINE Uint32 size() const { return m_size / m_bytes; }
+	INLINE Uint32 size() const { return m_sampleCount; }
 
 	// size of each sample
 	INLINE Uint32 bytes() const { return m_bytes; }
 
+	// Audio position one past the newest sample in the window
+	INLINE Uint64 endSample() const { return m_endSample; }
+
+	// Samples that never made it into the window, the display fell behind the audio thread
+	INLINE Uint64 droppedSamples() const { return m_droppedSamples; }
+
+	// Appends count samples starting at audio position firstSample, the oldest ones slide out
+	void append(const Uint8* pSamples, Uint32 count, Uint64 firstSample);
+
 	void clear();
 
 	void print(const std::string& prefix = "") const;
 private:
-	Uint8					*m_pBuffer{};
-	Uint32					m_size{};
-	Uint32					m_pos{};
+	std::vector<Uint8>		m_buffer;
+	Uint32					m_sampleCount{};
 	Uint32					m_bytes{};
+	Uint64					m_endSample{};
+	Uint64					m_droppedSamples{};
 	SDL_AudioFormat			m_type{};
 };
 
@@ -47,24 +139,38 @@ public:
 		int sampleRate, SDL_AudioFormat format, Uint8 channels, Uint16 sampleCount, SDL_AudioCallback callback,
 		int displayWidth, int displayHeight);
 
-	INLINE void setFrequency(int f) { m_soundWave.setFrequency(f); }
-	INLINE void setAmplitude(int a) { m_soundWave.setAmplitude(a); }
-	INLINE void setPhase(SoundWave::value_type phase) { m_soundWave.setPhase(phase); }
-	INLINE void setWaveForm(WaveForm w) { m_soundWave.setWaveForm(w); }
-	INLINE void setAudioPosition(int pos) { m_audioPos = pos; }
-	INLINE void setAudioLength(int len) { m_audioLength = len; }
+	INLINE void setFrequency(int f) { m_soundWave.setFrequency(f); publishParams(); }
+	INLINE void setAmplitude(int a) { m_soundWave.setAmplitude(a); publishParams(); }
+	INLINE void setPhase(SoundWave::value_type phase) { m_soundWave.setPhase(phase); publishParams(); }
+	INLINE void setWaveForm(WaveForm w) { m_soundWave.setWaveForm(w); publishParams(); }
+	INLINE void setAudioPosition(Uint64 pos) { m_audioPos.store(pos, std::memory_order_relaxed); }
+	INLINE void setAudioLength(int len) { m_audioLength = len; publishParams(); }
 	INLINE void setSampleRate(int s) { m_desiredSpec.freq = s; }
 	INLINE void setAudioFormat(SDL_AudioFormat format) { m_desiredSpec.format = format; }
 	INLINE void setAudioChannels(Uint8 channels) { m_desiredSpec.channels = channels; }
 	INLINE void setSampleCount(Uint16 samples) { m_desiredSpec.samples = samples; }
 	INLINE void setAudioCallback(SDL_AudioCallback callback) { m_audioCallback = callback; }
-	INLINE void setVolume(float volume) { m_volume = volume; }
+	INLINE void setVolume(float volume) { m_volume = volume; publishParams(); }
+
+	// Plays the file instead of the generated tone, set before init(). rawLayout describes
+	// .raw and .pcm files, the device's own layout is assumed when it is not valid.
+	INLINE void setAudioFile(const std::string& path, const PcmLayout& rawLayout = PcmLayout{}) { m_audioFile = path; m_rawLayout = rawLayout; }
+	INLINE const std::string& getAudioFile() const { return m_audioFile; }
+
+	// UI thread. Snapshots the sound wave, rebuilds the period cache and picks the audio
+	// kernels for the current waveform, device format and channel count, then hands all of
+	// it to the audio thread without locking. Must be called whenever the generated signal
+	// changes, the callback never looks at m_soundWave.
+	void publishParams();
+
+	INLINE void setPeriodCacheEnabled(bool enabled) { m_bPeriodCacheEnabled = enabled; publishParams(); }
+	INLINE bool isPeriodCacheEnabled() const { return m_bPeriodCacheEnabled; }
 
 	INLINE int getFrequency() const { return m_soundWave.getFrequency(); }
 	INLINE int getAmplitude() const { return m_soundWave.getAmplitude(); }
 	INLINE SoundWave::value_type getPhase() const { return m_soundWave.getPhase(); }
 	INLINE WaveForm getWaveForm() const { return m_soundWave.getWaveForm(); }
-	INLINE int getAudioPosition() const { return m_audioPos; }
+	INLINE Uint64 getAudioPosition() const { return m_audioPos.load(std::memory_order_relaxed); }
 	INLINE int getAudioLength() const { return m_audioLength; }
 	INLINE int getSampleRate() const { return m_deviceSpec.freq; }
 	INLINE SDL_AudioFormat getAudioFormat() const { return m_deviceSpec.format; }
@@ -73,6 +179,7 @@ public:
 	INLINE SDL_AudioCallback getAudioCallback() const { return m_audioCallback; }
 	INLINE float getVolume() const { return m_volume; }
 
+	// UI side model of the signal, changes reach the audio thread through publishParams()
 	INLINE SoundWave& getSoundWave() { return m_soundWave; }
 	INLINE const SoundWave& getSoundWave() const { return m_soundWave; }
 
@@ -81,11 +188,10 @@ public:
 	INLINE int getDisplayWidth() const { return m_displayWidth; }
 	INLINE int getDisplayHeight() const { return m_displayHeight; }
 
-	// Display Buffer API
-	INLINE Uint8* getGraphBuffer() { return m_graphBuffer.m_pBuffer; }
-	INLINE const Uint8* getGraphBuffer() const { return m_graphBuffer.m_pBuffer; }
+	// Display Buffer API, UI thread
+	INLINE Uint8* getGraphBuffer() { return m_graphBuffer.m_buffer.data(); }
+	INLINE const Uint8* getGraphBuffer() const { return m_graphBuffer.m_buffer.data(); }
 
-	INLINE void setGraphBufferFormat(SDL_AudioFormat format) { m_graphBuffer.setFormat(format); }
 	INLINE SDL_AudioFormat getGraphBufferFormat() const { return m_graphBuffer.m_type; }
 
 	INLINE Uint32 graphBufferSize() const { return m_graphBuffer.size(); }
@@ -94,20 +200,99 @@ public:
 
 	INLINE void graphBufferClear() { return m_graphBuffer.clear(); }
 
-	INLINE void setGraphBufferPosition(int pos) { m_graphBuffer.m_pos = pos; }
-	INLINE Uint32& getGraphBufferPosition() { return m_graphBuffer.m_pos; }
-	INLINE const Uint32& getGraphBufferPosition() const { return m_graphBuffer.m_pos; }
+	// Moves every finished display block from the audio thread into the graph buffer
+	void drainDisplayRing();
+	INLINE const DisplayRing& getDisplayRing() const { return *m_pDisplayRing; }
 
-	INLINE void incrementGraphBufferPosition(Uint32 inc = 1) { m_graphBuffer.m_pos += inc; }
+	// Latest complete frame from the audio thread, frameNumber is 0 until there is one
+	const DisplayFrame& acquireDisplayFrame();
 	// Display Buffer API
 
-	INLINE void incrementAudioPosition(Uint32 inc = 1) { m_audioPos += inc; }
+	// Audio thread side of the display hand off. Fill at most displayBlockSize() samples of
+	// the returned block, then commit it. nullptr when the UI thread is behind, the samples
+	// are dropped and counted as an overrun, the audio thread never waits.
+	INLINE DisplayBlock* beginDisplayBlock() { return m_pDisplayRing->beginWrite(); }
+	INLINE void commitDisplayBlock() { m_pDisplayRing->commitWrite(); }
+	INLINE Uint32 displayBlockSize() const { return m_displayBlockSize; }
+
+	// Samples per display frame. Longer records than the display is wide get decimated to
+	// min/max columns when drawn. Takes effect with the next frame the audio thread starts.
+	static constexpr Uint32 MIN_RECORD_LENGTH = 64;
+	static constexpr Uint32 MAX_RECORD_LENGTH = 1 << 16;
+	void setRecordLength(Uint32 samples);
+	INLINE Uint32 getRecordLength() const { return m_recordLength.load(std::memory_order_relaxed); }
+
+	// Audio thread, the frame being assembled. Fill it up to its size, then
+	// publishCaptureFrame() stamps it and swaps in a fresh one.
+	INLINE DisplayFrame& getCaptureFrame() { return m_displayFrames.back(); }
+	void publishCaptureFrame();
+
+	// Audio thread. Runs count display samples starting at audio position firstSample through
+	// the trigger and copies them into the capture frame, which starts at the sample that
+	// fires the trigger and is published once full.
+	void captureDisplay(const Uint8* pSamples, Uint32 count, Uint64 firstSample);
+
+	// Display samples converted for captureDisplay(), captureScratchSize() of them
+	INLINE Uint8* getCaptureScratch() { return m_captureScratch.data(); }
+	INLINE Uint32 captureScratchSize() const { return getSampleCount(); }
+
+	// Trigger setup, UI thread. Changes reach the audio thread through publishParams().
+	INLINE const TriggerSettings& getTrigger() const { return m_trigger; }
+	INLINE void setTrigger(const TriggerSettings& trigger) { m_trigger = trigger; publishParams(); }
+
+	// Lets a SINGLE trigger capture one more frame
+	INLINE void rearmTrigger() { m_rearmRequests.fetch_add(1, std::memory_order_relaxed); }
+
+	// Audio thread is the only writer, so there is no need for an atomic add
+	INLINE void incrementAudioPosition(Uint32 inc = 1) { m_audioPos.store(getAudioPosition() + inc, std::memory_order_relaxed); }
+
+	// Scratch buffer the audio callback renders one block into before converting it
+	INLINE SoundWave::sample_type* getRenderBuffer() { return m_renderBuffer.data(); }
+	INLINE Uint32 renderBufferSize() const { return (Uint32)m_renderBuffer.size(); }
+
+	// Audio thread API
+	// Picks up the latest published parameters and returns the kernel for this callback
+	SDLAudioKernelFn beginAudioBlock(int len);
+	void endAudioBlock();
+
+	INLINE SoundWave& getAudioWave() { return m_audioWave; }
+	INLINE const PeriodCache& getPeriodCache() const { return m_params.front().cache; }
+	INLINE AudioFileStream& getFileStream() { return m_fileStream; }
+	INLINE float getDisplayGain() const { return m_params.front().displayGain; }
+	INLINE float getFileVolume() const { return m_params.front().volume; }
+
+	// Mapped PCM file played as it is, and the frame of it that plays next
+	INLINE const PcmFile& getPcmFile() const { return *m_pPcmFile; }
+	INLINE Uint64 getPlayhead() const { return m_playhead.load(std::memory_order_relaxed); }
+	INLINE void setPlayhead(Uint64 frame) { m_playhead.store(frame, std::memory_order_relaxed); }
+
+	// Stamped by SDLAudioCallback(), read from any thread
+	INLINE CallbackTiming& getCallbackTiming() { return m_callbackTiming; }
+	INLINE const CallbackTiming& getCallbackTiming() const { return m_callbackTiming; }
+
+	// Gain of frame i of the current callback is getGain() + i * getGainStep()
+	INLINE float getGain() const { return m_gain; }
+	INLINE float getGainStep() const { return m_gainStep; }
+
+	// Fades from the previous waveform into the block, offset is the first frame of the
+	// block within a callback of total frames
+	INLINE bool isCrossfading() const { return m_bCrossfade; }
+	void crossfadeBlock(SoundWave::sample_type* pBlock, Uint32 count, Uint32 offset, Uint32 total);
+	// Audio thread API
 	
-	// audio_pos / SAMPLE_RATE
-	INLINE SoundWave::value_type getSample() const { return m_soundWave.getSample(m_audioPos / (SoundWave::value_type)getSampleRate()); }
+	// Advances the phase accumulator of the sound wave by one sample
+	INLINE SoundWave::sample_type getSample() { return m_soundWave.nextSample(); }
 
 	bool init();
 
+	// Sets the audio side up for spec without opening a device. SDLAudioCallback() can then
+	// be called directly to render as fast as it goes, see OfflineRenderer. A file set with
+	// setAudioFile() may change the layout like it does for the device.
+	bool initOffline(const SDL_AudioSpec& spec);
+
+	// Device spec is known, by init() or initOffline()
+	INLINE bool isAudioReady() const { return m_deviceSpec.freq > 0; }
+
 	void start();
 	void update(uint64_t elapsedTimeInMs, const std::vector<SDL_Event> &events);
 	void draw(SDL_Renderer* pRenderer);
@@ -120,8 +305,17 @@ public:
 
 	void print(const std::string& prefix = "") const;
 private:
-	template<typename T>
-	void drawHelper(T* arr, SDL_Renderer* pRenderer, int xStart, int xEnd, int yNormalizer);
+	void drawHistory(SDL_Renderer* pRenderer, const SDL_FRect& area);
+	void drawSpectrum(SDL_Renderer* pRenderer);
+
+	// Where the time trace goes, the left half of the display when the spectrum is shown
+	// next to it
+	INLINE SDL_FRect traceArea() const { return { 0.0f, 0.0f, (float)(m_spectrumView != SpectrumView::OFF ? m_displayWidth / 2 : m_displayWidth), (float)m_displayHeight }; }
+	INLINE SDL_FRect spectrumArea() const { return { (float)(m_displayWidth / 2), 0.0f, (float)(m_displayWidth - m_displayWidth / 2), (float)m_displayHeight }; }
+	void setupAudio();
+	void openPcmFile();
+	void startFilePlayback();
+	void selectAudioKernels(AudioParams& params) const;
 	void exit();
 	void handleKeyEvent(SDL_Scancode keyCode);
 	void printAudioSpec(const SDL_AudioSpec& spec, const std::string &prefix = "") const;
@@ -132,18 +326,94 @@ private:
 	SDL_AudioSpec			m_deviceSpec{};
 	SDL_AudioCallback		m_audioCallback{};
 
-	SoundWave				m_soundWave;
+	SoundWave				m_soundWave;		// UI thread
 
-	int						m_audioPos{};
+	std::atomic<Uint64>		m_audioPos{};		// # of samples played, 64 bit so it never wraps
 	int						m_audioLength{};
 
+	std::string					m_audioFile;
+	PcmLayout					m_rawLayout;
+	AudioFileStream				m_fileStream;		// Open while a decoded or converted file plays
+	std::unique_ptr<PcmFile>	m_pPcmFile;			// Played straight from the mapping when m_bMappedPlayback
+	bool						m_bMappedPlayback{};
+	std::atomic<Uint64>			m_playhead{};		// Next frame of m_pPcmFile, audio thread writes
+
+	bool						m_bPeriodCacheEnabled{ true };
+	TripleBuffer<AudioParams>	m_params;
+
+	// Audio thread only
+	SoundWave							m_audioWave;		// Owns the phase the callback plays from
+	SoundWave							m_fadeWave;			// Previous waveform while crossfading
+	std::vector<SoundWave::sample_type>	m_renderBuffer;
+	std::vector<SoundWave::sample_type>	m_fadeBuffer;
+	float								m_gain{};
+	float								m_gainTarget{};
+	float								m_gainStep{};
+	bool								m_bRamping{};
+	bool								m_bCrossfade{};
+
 	bool					m_bPaused{ true };
 
-	DisplayBuffer			m_graphBuffer;
+	DisplayBuffer					m_graphBuffer;
+	std::unique_ptr<DisplayRing>	m_pDisplayRing;		// Heap, it is cache line aligned
+	Uint32							m_displayBlockSize{};
+	TripleBuffer<DisplayFrame>		m_displayFrames;
+	std::atomic<Uint32>				m_recordLength{};
+	std::vector<MinMaxColumn>		m_columns;			// Decimated frame, one per pixel column
+	Uint64							m_capturedFrames{};	// Audio thread
+
+	// Trigger, m_trigger is the UI side and everything else belongs to the audio thread
+	TriggerSettings					m_trigger;
+	std::vector<Uint8>				m_captureScratch;
+	bool							m_bCapturing{};			// Filling the capture frame
+	bool							m_bTriggerArmed{};
+	bool							m_bSingleDone{};		// SINGLE has its frame, waits for a re-arm
+	Uint32							m_holdoffLeft{};
+	Uint32							m_samplesWaiting{};		// Searched without a trigger since the last frame
+	float							m_lastSample{};			// Last display sample captureDisplay() was given
+	std::atomic<Uint32>				m_rearmRequests{};		// UI thread counts, the audio thread follows
+	Uint32							m_rearmSeen{};
+	std::atomic<Uint64>				m_triggeredFrames{};
+	std::atomic<Uint64>				m_autoFrames{};
 
 	float					m_volume{ 1.0f };
 	SDL_Color				m_waveColor;
-	float					m_waveSF{ 2.0f };
+	float					m_waveSF{ 2.0f };		// Trace thickness in pixels
+	TraceRenderer			m_traceRenderer;
+
+	// Traces drawn by m_traceRenderer
+	static constexpr int	TRACE_WAVE = 0;
+	static constexpr int	TRACE_RMS = 1;
+	static constexpr int	TRACE_SPECTRUM = 2;
+	static constexpr int	TRACE_COUNT = 3;
+
+	// Whole recording so far, drawn instead of the live frame in the history view
+	static constexpr Uint64	MAX_HISTORY_SAMPLES_PER_COLUMN = (Uint64)1 << 24;
+	WaveformPyramid			m_pyramid;
+	bool					m_bHistoryView{};
+	Uint64					m_historySamplesPerColumn{ WaveformPyramid::BASE_DECIMATION };
+	std::vector<float>		m_rms;
+	std::vector<MinMaxColumn>	m_rmsColumns;
+	SDL_Color				m_rmsColor{ 255, 215, 0, SDL_ALPHA_OPAQUE };		// Gold
+
+	// Callback timing, dumped every TIMING_DUMP_INTERVAL_MS for the time since the last dump
+	static constexpr Uint64	TIMING_DUMP_INTERVAL_MS = 10000;
+	CallbackTiming			m_callbackTiming;
+	CallbackTiming::Report	m_lastTimingDump;
+	Uint64					m_msSinceTimingDump{};
+	bool					m_bTimingDump{ true };
+
+	// Spectrum of the display samples, drawn in the right half of the display when on
+	SpectrumAnalyzer		m_spectrum;
+	SpectrumView			m_spectrumView{ SpectrumView::OFF };
+	Waterfall				m_waterfall;
+	Uint64					m_waterfallSpectrum{};		// Last spectrum pushed into m_waterfall
+	std::vector<float>		m_spectrumHeights;		// Pixels above the bottom, one per column
+	SDL_Color				m_spectrumColor{ 0, 191, 255, SDL_ALPHA_OPAQUE };	// Deep sky blue
+
+	// Every captured frame accumulated, drawn instead of the live frame when on
+	Persistence				m_persistence;
+	bool					m_bPersistenceView{};
 
 	const int				m_displayWidth{};
 	const int				m_displayHeight{};
@@ -0,0 +1,189 @@
+#include "appOptions.h"
+#include "frameProfiler.h"
+#include "logger.h"
+
+#include <cstdlib>
+
+namespace
+{
+bool parseNumber(const char* pText, double minValue, double maxValue, double& value)
+{
+	char* pEnd = nullptr;
+	const double v = std::strtod(pText, &pEnd);
+	if (pEnd == pText || *pEnd != '\0' || !(v >= minValue && v <= maxValue))
+	{
+		return false;
+	}
+	value = v;
+	return true;
+}
+
+bool parseWaveForm(const std::string& text, WaveForm& waveForm)
+{
+	if (text == "sine")				waveForm = WaveForm::SINE;
+	else if (text == "square")		waveForm = WaveForm::SQUARE;
+	else if (text == "sawtooth")	waveForm = WaveForm::SAWTOOTH;
+	else if (text == "triangle")	waveForm = WaveForm::TRIANGLE;
+	else							return false;
+	return true;
+}
+}
+
+bool AppOptions::parse(int argc, char* argv[])
+{
+	render.layout.format = FORMAT;
+	render.layout.channels = CHANNELS;
+	render.layout.sampleRate = SAMPLE_RATE;
+	double number = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help")
+		{
+			bShowHelp = true;
+			return false;
+		}
+		else if (arg == "-f" || arg == "--file")
+		{
+			if (i + 1 >= argc)
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a file name\n");
+				return false;
+			}
+			audioFile = argv[++i];
+		}
+		else if (arg == "-r" || arg == "--raw")
+		{
+			if (i + 1 >= argc || !PcmLayout::parse(argv[i + 1], rawLayout))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a layout like S16:2:44100\n");
+				return false;
+			}
+			++i;
+		}
+		else if (arg == "--frame-log")
+		{
+			if (i + 1 >= argc)
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a file name\n");
+				return false;
+			}
+			frameLog = argv[++i];
+		}
+		else if (arg == "--render")
+		{
+			if (i + 1 >= argc)
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a file name\n");
+				return false;
+			}
+			render.path = argv[++i];
+		}
+		else if (arg == "--layout")
+		{
+			if (i + 1 >= argc || !PcmLayout::parse(argv[i + 1], render.layout))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a layout like S16:2:44100\n");
+				return false;
+			}
+			++i;
+		}
+		else if (arg == "--seconds")
+		{
+			if (i + 1 >= argc || !parseNumber(argv[i + 1], 0.0, 1e7, render.seconds))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a duration in seconds\n");
+				return false;
+			}
+			++i;
+		}
+		else if (arg == "--wave")
+		{
+			if (i + 1 >= argc || !parseWaveForm(argv[i + 1], render.waveForm))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs one of sine, square, sawtooth or triangle\n");
+				return false;
+			}
+			frames.waveForm = render.waveForm;
+			++i;
+		}
+		else if (arg == "--frequency")
+		{
+			if (i + 1 >= argc || !parseNumber(argv[i + 1], 1.0, 1e6, number))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a frequency in Hz\n");
+				return false;
+			}
+			render.frequency = frames.frequency = (int)number;
+			++i;
+		}
+		else if (arg == "--level")
+		{
+			if (i + 1 >= argc || !parseNumber(argv[i + 1], 0.0, 1.0, number))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a level between 0 and 1\n");
+				return false;
+			}
+			render.level = (float)number;
+			++i;
+		}
+		else if (arg == "--frames")
+		{
+			if (i + 1 >= argc)
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a path prefix\n");
+				return false;
+			}
+			frames.prefix = argv[++i];
+		}
+		else if (arg == "--frame-count" || arg == "--fps" || arg == "--encoders")
+		{
+			if (i + 1 >= argc || !parseNumber(argv[i + 1], arg == "--encoders" ? 0.0 : 1.0, 1e6, number))
+			{
+				ns_Util::Logger::LOG_ERROR(arg, " needs a count\n");
+				return false;
+			}
+			int& value = arg == "--frame-count" ? frames.frameCount : (arg == "--fps" ? frames.framesPerSecond : frames.encoders);
+			value = (int)number;
+			framesPerSecond = frames.framesPerSecond;
+			++i;
+		}
+		else if (arg == "--vsync")
+		{
+			bVsync = true;
+		}
+		else
+		{
+			ns_Util::Logger::LOG_ERROR("Unknown option ", arg, '\n');
+			return false;
+		}
+	}
+	return true;
+}
+
+void AppOptions::printUsage(const std::string& program)
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG("Usage: ", program, " [options]\n");
+	Logger::LOG_MSG("    -f, --file <path>  : Play and display an audio file instead of the tone, e.g. Resources/Audio/File_1MB.ogg\n");
+	Logger::LOG_MSG("                         .wav, .raw and .pcm files are memory mapped and play without a copy when the device takes their layout\n");
+	Logger::LOG_MSG("                         and the volume is full, other volumes scale every sample on the way out\n");
+	Logger::LOG_MSG("    -r, --raw <layout> : Layout of a .raw or .pcm file as FORMAT:CHANNELS:RATE, e.g. S16:2:44100,\n");
+	Logger::LOG_MSG("                         FORMAT is one of S8, U8, S16, U16, S24, S32 or F32. Defaults to the device layout.\n");
+	Logger::LOG_MSG("    --frame-log <path> : Write the time of every phase of the last ", FrameProfiler::RING_FRAMES, " frames as CSV on exit,\n");
+	Logger::LOG_MSG("                         F writes them at any time, to frame_times.csv when not given\n");
+	Logger::LOG_MSG("    --render <path>    : Render the tone to a .wav, .raw or .pcm file as fast as it goes and exit,\n");
+	Logger::LOG_MSG("                         no window or audio device is opened\n");
+	Logger::LOG_MSG("    --layout <layout>  : Layout to render as FORMAT:CHANNELS:RATE, defaults to the device layout.\n");
+	Logger::LOG_MSG("                         WAV takes U8, S16, S24, S32 and F32, CHANNELS is 1, 2, 4 or 6\n");
+	Logger::LOG_MSG("    --seconds <s>      : Length to render, 10 by default\n");
+	Logger::LOG_MSG("    --wave <name>      : sine, square, sawtooth or triangle, sine by default\n");
+	Logger::LOG_MSG("    --frequency <Hz>   : Tone frequency, ", FREQUENCY, " by default\n");
+	Logger::LOG_MSG("    --level <0..1>     : Peak level of the rendered tone, 0.5 by default\n");
+	Logger::LOG_MSG("    --frames <prefix>  : Draw the scope to <prefix>000000.png onwards without a display and exit\n");
+	Logger::LOG_MSG("    --frame-count <n>  : Frames to draw, 60 by default\n");
+	Logger::LOG_MSG("    --fps <n>          : Frame rate of the window, and the one the audio moves on at between recorded frames, 60 by default\n");
+	Logger::LOG_MSG("    --vsync            : Present frames at the display's refresh rate instead of --fps\n");
+	Logger::LOG_MSG("    --encoders <n>     : PNG encoder threads, one per core but one by default\n");
+	Logger::LOG_MSG("    -h, --help         : Show this help\n");
+}
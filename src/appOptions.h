@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include "wavFile.h"
+#include "offlineRenderer.h"
+#include "frameRecorder.h"
+
+// What the command line asked for
+struct AppOptions
+{
+	std::string		audioFile;			// Played instead of the generated tone when set
+	PcmLayout		rawLayout;			// Layout of a .raw or .pcm audioFile, not valid when not given
+	std::string		frameLog;			// Frame times as CSV, written on exit
+	int				framesPerSecond{ 60 };	// Of the window, and of recorded frames
+	bool			bVsync{};			// Present waits for the display instead of the loop pacing itself
+	bool			bShowHelp{};
+
+	// Renders to render.path instead of opening the window and the device when it is set
+	OfflineRenderer::Settings	render;
+
+	// Writes frames.prefix000000.png onwards without a window or the device when it is set.
+	// The tone and the audio file are the ones given for the rest.
+	FrameRecorder::Settings		frames;
+
+	// Returns false when the command line is malformed or asks for help
+	bool parse(int argc, char* argv[]);
+
+	static void printUsage(const std::string& program);
+};
@@ -0,0 +1,55 @@
+#include "audioDecoder.h"
+#include "logger.h"
+#include "oggVorbis.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+std::string lowerCaseExtension(const std::string& path)
+{
+	const size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos)
+	{
+		return "";
+	}
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return extension;
+}
+
+class VorbisDecoder : public AudioDecoder
+{
+public:
+	bool open(const std::string& path) { return m_file.open(path); }
+
+	int channels() const override { return m_file.channels(); }
+	int sampleRate() const override { return m_file.sampleRate(); }
+	Uint64 lengthInFrames() const override { return m_file.lengthInFrames(); }
+
+	Uint32 read(float* pFrames, Uint32 frames) override { return m_file.read(pFrames, frames); }
+
+	bool rewind() override { return m_file.rewind(); }
+
+	std::string name() const override { return "Ogg Vorbis"; }
+private:
+	OggVorbisFile	m_file;
+};
+}
+
+std::unique_ptr<AudioDecoder> openAudioDecoder(const std::string& path)
+{
+	const std::string extension = lowerCaseExtension(path);
+	if (extension == "ogg")
+	{
+		std::unique_ptr<VorbisDecoder> pDecoder = std::make_unique<VorbisDecoder>();
+		if (pDecoder->open(path))
+		{
+			return pDecoder;
+		}
+		return nullptr;
+	}
+	ns_Util::Logger::LOG_ERROR("Cannot play ", path, ", unknown audio file type '", extension, "'\n");
+	return nullptr;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <SDL.h>
+#include "constants.h"
+
+// Compressed audio file being decoded front to back, into interleaved float frames in [-1, 1]
+class AudioDecoder
+{
+public:
+	virtual ~AudioDecoder() = default;
+
+	virtual int channels() const = 0;
+	virtual int sampleRate() const = 0;
+
+	// 0 when the file does not say
+	virtual Uint64 lengthInFrames() const = 0;
+
+	// Decodes up to frames frames into pFrames, returns how many, 0 at the end of the file
+	virtual Uint32 read(float* pFrames, Uint32 frames) = 0;
+
+	// Back to the first frame, for looping
+	virtual bool rewind() = 0;
+
+	virtual std::string name() const = 0;
+};
+
+// Decoder for the file, picked by its extension. nullptr when the file cannot be opened or
+// its format is not built in.
+std::unique_ptr<AudioDecoder> openAudioDecoder(const std::string& path);
@@ -0,0 +1,260 @@
+#include "audioFileStream.h"
+#include "sampleFormat.h"
+#include "logger.h"
+
+#include <algorithm>
+
+namespace
+{
+template <typename T>
+void convertChunk(const float* pSrc, Uint8* pFrames, Uint8* pDisplay, Uint32 count, int channels,
+	float volume, float displayGain, float displayOffset)
+{
+	T* pOut = reinterpret_cast<T*>(pFrames);
+	T* pMono = reinterpret_cast<T*>(pDisplay);
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		const float* pFrame = pSrc + (size_t)channels * i;
+		for (int c = 0; c < channels; ++c)
+		{
+			pOut[(size_t)channels * i + c] = toDeviceSample<T>(pFrame[c] * volume);
+		}
+		pMono[i] = toDisplaySample<T>(pFrame[0] * displayGain + displayOffset);
+	}
+}
+}
+
+bool AudioFileStream::open(const std::string& path, const SDL_AudioSpec& deviceSpec)
+{
+	if (!open(openAudioDecoder(path), deviceSpec))
+	{
+		return false;
+	}
+	m_name = path;
+	return true;
+}
+
+bool AudioFileStream::open(std::unique_ptr<AudioDecoder> pDecoder, const SDL_AudioSpec& deviceSpec)
+{
+	close();
+	if (!pDecoder)
+	{
+		return false;
+	}
+
+	switch (deviceSpec.format)
+	{
+		case AUDIO_S8:	m_convert = convertChunk<Sint8>;	break;
+		case AUDIO_U8:	m_convert = convertChunk<Uint8>;	break;
+		case AUDIO_S16:	m_convert = convertChunk<Sint16>;	break;
+		case AUDIO_U16:	m_convert = convertChunk<Uint16>;	break;
+		case AUDIO_S32:	m_convert = convertChunk<Sint32>;	break;
+		case AUDIO_F32:	m_convert = convertChunk<float>;	break;
+		default:
+			ns_Util::Logger::LOG_ERROR("Cannot stream a file to ", audioFormat2String(deviceSpec.format), '\n');
+			return false;
+	}
+
+	m_pResampler = SDL_NewAudioStream(AUDIO_F32SYS, (Uint8)pDecoder->channels(), pDecoder->sampleRate(),
+		AUDIO_F32SYS, deviceSpec.channels, deviceSpec.freq);
+	if (!m_pResampler)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR("Failed to create the file resampler");
+		return false;
+	}
+
+	m_channels = deviceSpec.channels;
+	m_sampleRate = deviceSpec.freq;
+	m_sampleBytes = SDL_AUDIO_BITSIZE(deviceSpec.format) / 8;
+	m_frameBytes = m_sampleBytes * m_channels;
+
+	// Everything the decode thread and the callback touch is allocated here, once
+	m_decoded.assign((size_t)DECODE_CHUNK * pDecoder->channels(), 0.0f);
+	m_converted.assign((size_t)DECODE_CHUNK * m_channels, 0.0f);
+	m_frames.assign((size_t)RING_FRAMES * m_frameBytes, 0);
+	m_display.assign((size_t)RING_FRAMES * m_sampleBytes, 0);
+
+	m_writePos.store(0, std::memory_order_relaxed);
+	m_readPos.store(0, std::memory_order_relaxed);
+	m_bFinished.store(false, std::memory_order_relaxed);
+	m_bEndOfFile = false;
+	m_bDecodedSinceRewind = false;
+	m_decodedFrames.store(0, std::memory_order_relaxed);
+	m_decodeTicks.store(0, std::memory_order_relaxed);
+	m_underruns.store(0, std::memory_order_relaxed);
+	m_underrunFrames.store(0, std::memory_order_relaxed);
+	m_pDecoder = std::move(pDecoder);
+	m_name = m_pDecoder->name();
+
+	// A couple of chunks up front so the first callbacks have something, the rest of the
+	// file is decoded while it plays
+	for (Uint32 i = 0; i < PREFILL_CHUNKS; ++i)
+	{
+		decodeChunk();
+	}
+
+	m_bRunning.store(true, std::memory_order_release);
+	m_decodeThread = std::thread(&AudioFileStream::decodeLoop, this);
+	return true;
+}
+
+void AudioFileStream::close()
+{
+	m_bRunning.store(false, std::memory_order_release);
+	if (m_decodeThread.joinable())
+	{
+		m_decodeThread.join();
+	}
+	if (m_pResampler)
+	{
+		SDL_FreeAudioStream(m_pResampler);
+		m_pResampler = nullptr;
+	}
+	m_pDecoder.reset();
+}
+
+void AudioFileStream::setLevels(float volume, float displayGain, float displayOffset)
+{
+	m_volume.store(volume, std::memory_order_relaxed);
+	m_displayGain.store(displayGain, std::memory_order_relaxed);
+	m_displayOffset.store(displayOffset, std::memory_order_relaxed);
+}
+
+Uint32 AudioFileStream::beginRead(Uint32 frames, const Uint8*& pFrames, const Uint8*& pDisplay) const
+{
+	const Uint64 read = m_readPos.load(std::memory_order_relaxed);
+	const Uint64 available = m_writePos.load(std::memory_order_acquire) - read;
+	const Uint32 first = (Uint32)(read & (RING_FRAMES - 1));
+	pFrames = m_frames.data() + (size_t)first * m_frameBytes;
+	pDisplay = m_display.data() + (size_t)first * m_sampleBytes;
+	return (Uint32)std::min<Uint64>({ frames, available, RING_FRAMES - first });
+}
+
+void AudioFileStream::endRead(Uint32 frames)
+{
+	m_readPos.store(m_readPos.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+}
+
+void AudioFileStream::underrun(Uint32 frames)
+{
+	if (m_bFinished.load(std::memory_order_acquire)
+		&& m_readPos.load(std::memory_order_relaxed) == m_writePos.load(std::memory_order_acquire))
+	{
+		return;
+	}
+	m_underruns.fetch_add(1, std::memory_order_relaxed);
+	m_underrunFrames.fetch_add(frames, std::memory_order_relaxed);
+}
+
+double AudioFileStream::decodeFramesPerSecond() const
+{
+	const Uint64 ticks = m_decodeTicks.load(std::memory_order_relaxed);
+	if (ticks == 0)
+	{
+		return 0.0;
+	}
+	return (double)m_decodedFrames.load(std::memory_order_relaxed) * SDL_GetPerformanceFrequency() / ticks;
+}
+
+void AudioFileStream::decodeLoop()
+{
+	// Sleeps for a quarter of a chunk whenever the ring is full, it holds many chunks
+	const Uint32 idleMs = std::max(1u, DECODE_CHUNK * 1000u / (Uint32)std::max(m_sampleRate, 1) / 4);
+	while (m_bRunning.load(std::memory_order_acquire))
+	{
+		if (!decodeChunk())
+		{
+			SDL_Delay(idleMs);
+		}
+	}
+}
+
+bool AudioFileStream::decodeChunk()
+{
+	const Uint64 write = m_writePos.load(std::memory_order_relaxed);
+	const Uint64 read = m_readPos.load(std::memory_order_acquire);
+	if (RING_FRAMES - (write - read) < DECODE_CHUNK || m_bFinished.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const Uint32 count = pullConverted(DECODE_CHUNK);
+	if (count == 0)
+	{
+		m_bFinished.store(true, std::memory_order_release);
+		return false;
+	}
+
+	const float volume = m_volume.load(std::memory_order_relaxed);
+	const float displayGain = m_displayGain.load(std::memory_order_relaxed);
+	const float displayOffset = m_displayOffset.load(std::memory_order_relaxed);
+
+	// The chunk may wrap around the end of the ring
+	const Uint32 first = (Uint32)(write & (RING_FRAMES - 1));
+	const Uint32 head = std::min(count, RING_FRAMES - first);
+	m_convert(m_converted.data(), m_frames.data() + (size_t)first * m_frameBytes, m_display.data() + (size_t)first * m_sampleBytes,
+		head, m_channels, volume, displayGain, displayOffset);
+	if (head < count)
+	{
+		m_convert(m_converted.data() + (size_t)head * m_channels, m_frames.data(), m_display.data(),
+			count - head, m_channels, volume, displayGain, displayOffset);
+	}
+	m_writePos.store(write + count, std::memory_order_release);
+
+	m_decodedFrames.fetch_add(count, std::memory_order_relaxed);
+	m_decodeTicks.fetch_add(SDL_GetPerformanceCounter() - start, std::memory_order_relaxed);
+	return true;
+}
+
+Uint32 AudioFileStream::pullConverted(Uint32 frames)
+{
+	const int fileChannels = m_pDecoder->channels();
+	const int wantBytes = (int)(frames * m_channels * sizeof(float));
+	while (SDL_AudioStreamAvailable(m_pResampler) < wantBytes && !m_bEndOfFile)
+	{
+		const Uint32 decoded = m_pDecoder->read(m_decoded.data(), DECODE_CHUNK);
+		if (decoded == 0)
+		{
+			// A file that decodes to nothing would loop forever
+			if (m_bLoop && m_bDecodedSinceRewind && m_pDecoder->rewind())
+			{
+				m_bDecodedSinceRewind = false;
+				continue;
+			}
+			SDL_AudioStreamFlush(m_pResampler);
+			m_bEndOfFile = true;
+			break;
+		}
+		m_bDecodedSinceRewind = true;
+		if (SDL_AudioStreamPut(m_pResampler, m_decoded.data(), (int)(decoded * fileChannels * sizeof(float))) != 0)
+		{
+			ns_Util::Logger::LOG_SDL_ERROR("Failed to resample ", m_name);
+			m_bEndOfFile = true;
+			break;
+		}
+	}
+	const int got = SDL_AudioStreamGet(m_pResampler, m_converted.data(), wantBytes);
+	return got > 0 ? (Uint32)(got / (m_channels * sizeof(float))) : 0;
+}
+
+void AudioFileStream::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "AudioFileStream: \n");
+	if (!isOpen())
+	{
+		Logger::LOG_MSG(prefix, "    File               : None\n");
+		return;
+	}
+	const Uint64 length = m_pDecoder->lengthInFrames();
+	Logger::LOG_MSG(prefix, "    File               : ", m_name, ", ", m_pDecoder->name(), ", ", m_pDecoder->channels(), " channels at ",
+		m_pDecoder->sampleRate(), " Hz, ", length > 0 ? (double)length / m_pDecoder->sampleRate() : 0.0, " s\n");
+	Logger::LOG_MSG(prefix, "    Ring(in frames)    : ", m_writePos.load(std::memory_order_relaxed) - m_readPos.load(std::memory_order_relaxed),
+		" of ", RING_FRAMES, " decoded ahead\n");
+	const double framesPerSecond = decodeFramesPerSecond();
+	Logger::LOG_MSG(prefix, "    Decoded            : ", m_decodedFrames.load(std::memory_order_relaxed), " frames, ", framesPerSecond, " frames/s, ",
+		framesPerSecond / std::max(m_sampleRate, 1), "x realtime\n");
+	Logger::LOG_MSG(prefix, "    Underruns          : ", underruns(), ", ", underrunFrames(), " frames of silence\n");
+	Logger::LOG_MSG(prefix, "    State              : ", m_bFinished.load(std::memory_order_relaxed) ? "Finished" : (m_bLoop ? "Looping" : "Playing"), '\n');
+}
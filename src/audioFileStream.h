@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+#include "audioDecoder.h"
+
+// Plays an audio file through the device.
+//
+// A background thread decodes the file a chunk at a time, converts it to the device rate,
+// format and channel count and writes it into a preallocated ring, together with the first
+// channel of every frame in display units. Playback starts once the first chunk is in, the
+// rest of the file is decoded while it plays, and the audio callback only copies out of the
+// ring. The ring has a single writer and a single reader and neither side ever waits.
+class AudioFileStream
+{
+public:
+	static constexpr Uint32 RING_FRAMES = 1 << 16;		// Power of two, ~1.5 s at 44.1 kHz
+	static constexpr Uint32 DECODE_CHUNK = 4096;		// Frames converted per decode step
+	static constexpr Uint32 PREFILL_CHUNKS = 2;			// Decoded by open() before playback starts
+
+	AudioFileStream() = default;
+	~AudioFileStream() { close(); }
+
+	AudioFileStream(const AudioFileStream&) = delete;
+	AudioFileStream& operator=(const AudioFileStream&) = delete;
+
+	// UI thread, before the device plays from the stream. Starts the decode thread.
+	bool open(const std::string& path, const SDL_AudioSpec& deviceSpec);
+	bool open(std::unique_ptr<AudioDecoder> pDecoder, const SDL_AudioSpec& deviceSpec);
+
+	// UI thread, after the device stopped playing from the stream
+	void close();
+
+	INLINE bool isOpen() const { return m_pDecoder != nullptr; }
+
+	// Starts over at the end of the file instead of going silent, set before open()
+	INLINE void setLooping(bool bLoop) { m_bLoop = bLoop; }
+
+	// Output is sample * volume at full scale of the device format, the display gets
+	// sample * displayGain + displayOffset like the generated tone. Applies from the next
+	// decoded chunk, so the audio follows after up to a ring of latency.
+	void setLevels(float volume, float displayGain, float displayOffset);
+
+	// Audio thread. Up to frames decoded frames that are contiguous in the ring, as device
+	// frames and display samples, 0 when the decoder is behind. endRead() once copied.
+	Uint32 beginRead(Uint32 frames, const Uint8*& pFrames, const Uint8*& pDisplay) const;
+	void endRead(Uint32 frames);
+
+	// Audio thread, the callback had to play frames of silence. Not an underrun once a file
+	// that does not loop has ended.
+	void underrun(Uint32 frames);
+
+	INLINE Uint32 frameBytes() const { return m_frameBytes; }
+	INLINE Uint32 sampleBytes() const { return m_sampleBytes; }
+
+	INLINE Uint64 underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+	INLINE Uint64 underrunFrames() const { return m_underrunFrames.load(std::memory_order_relaxed); }
+
+	// Device frames produced per second of decode thread time
+	double decodeFramesPerSecond() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	using ConvertFn = void (*)(const float* pSrc, Uint8* pFrames, Uint8* pDisplay, Uint32 count, int channels,
+		float volume, float displayGain, float displayOffset);
+
+	void decodeLoop();
+
+	// Converts one chunk into the ring, false when there is no room or nothing left to decode
+	bool decodeChunk();
+
+	// Fills m_converted with up to frames device frames, returns how many
+	Uint32 pullConverted(Uint32 frames);
+
+private:
+	std::unique_ptr<AudioDecoder>	m_pDecoder;
+	SDL_AudioStream*				m_pResampler{};		// File rate and channels to the device's, as float
+	ConvertFn						m_convert{};
+	std::string						m_name;
+
+	// Decode thread only, once it runs
+	std::vector<float>				m_decoded;			// One chunk straight from the decoder
+	std::vector<float>				m_converted;		// One chunk at device rate and channels
+	bool							m_bEndOfFile{};
+	bool							m_bDecodedSinceRewind{};
+
+	std::vector<Uint8>				m_frames;			// RING_FRAMES device frames
+	std::vector<Uint8>				m_display;			// RING_FRAMES display samples
+	Uint32							m_frameBytes{};
+	Uint32							m_sampleBytes{};
+	int								m_channels{};
+	int								m_sampleRate{};
+
+	std::atomic<Uint64>				m_writePos{};		// Frames decoded, decode thread
+	std::atomic<Uint64>				m_readPos{};		// Frames played, audio thread
+	std::atomic<bool>				m_bFinished{};		// Everything decoded, no looping
+	std::atomic<bool>				m_bRunning{};
+	std::thread						m_decodeThread;
+	bool							m_bLoop{ true };
+
+	std::atomic<float>				m_volume{ 1.0f };
+	std::atomic<float>				m_displayGain{ 1.0f };
+	std::atomic<float>				m_displayOffset{};
+
+	std::atomic<Uint64>				m_decodedFrames{};
+	std::atomic<Uint64>				m_decodeTicks{};	// SDL_GetPerformanceCounter() ticks spent decoding
+	std::atomic<Uint64>				m_underruns{};
+	std::atomic<Uint64>				m_underrunFrames{};
+};
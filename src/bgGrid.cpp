@@ -1,4 +1,5 @@
 #include "bgGrid.h"
+#include "logger.h"
 
 BgGrid::BgGrid(int screenWidth, int screenHeight, int numOfCols)
 	: m_numOfCols(numOfCols)
@@ -10,7 +11,47 @@ BgGrid::BgGrid(int screenWidth, int screenHeight, int numOfCols)
     calculateGridPoints();
 }
 
+BgGrid::~BgGrid()
+{
+    releaseTexture();
+}
+
+void BgGrid::update(const std::vector<SDL_Event>& events)
+{
+    for (size_t i = 0, size = events.size(); i < size; ++i)
+    {
+        // Target textures lose their content on these, a device reset also loses the texture
+        if (events[i].type == SDL_RENDER_TARGETS_RESET)
+        {
+            m_bDirty = true;
+        }
+        else if (events[i].type == SDL_RENDER_DEVICE_RESET)
+        {
+            releaseTexture();
+            m_bDirty = true;
+        }
+    }
+}
+
 void BgGrid::draw(SDL_Renderer* pRenderer)
+{
+    if ((m_bDirty || m_pTextureOwner != pRenderer) && !m_bTargetsUnsupported)
+    {
+        m_bTargetsUnsupported = !renderToTexture(pRenderer);
+    }
+
+    if (!m_pTexture)
+    {
+        drawUncached(pRenderer);
+        return;
+    }
+
+    // The copy covers the whole screen, so it also stands in for the clear
+    SDL_RenderSetScale(pRenderer, 1.0f, 1.0f);
+    SDL_RenderCopy(pRenderer, m_pTexture, nullptr, nullptr);
+}
+
+void BgGrid::drawUncached(SDL_Renderer* pRenderer)
 {
     // Fill background
     SDL_SetRenderDrawColor(pRenderer, m_backGround.r, m_backGround.g, m_backGround.b, SDL_ALPHA_OPAQUE);
@@ -30,6 +71,77 @@ void BgGrid::draw(SDL_Renderer* pRenderer)
     drawAxisLine(pRenderer, 0, m_centreY, m_screenWidth, m_centreY);
 }
 
+void BgGrid::setScreenSize(int screenWidth, int screenHeight)
+{
+    m_screenWidth = screenWidth;
+    m_screenHeight = screenHeight;
+    m_centreX = screenWidth / 2;
+    m_centreY = screenHeight / 2;
+    calculateGridPoints();
+    releaseTexture();
+    m_bDirty = true;
+}
+
+void BgGrid::setNumOfCols(int numOfCols)
+{
+    m_numOfCols = numOfCols;
+    calculateGridPoints();
+    m_bDirty = true;
+}
+
+void BgGrid::print(const std::string& prefix) const
+{
+    using ns_Util::Logger;
+    Logger::LOG_MSG(prefix, "BgGrid: \n");
+    Logger::LOG_MSG(prefix, "    Screen(W x H)      : ", m_screenWidth, " x ", m_screenHeight, '\n');
+    Logger::LOG_MSG(prefix, "    # of columns       : ", m_numOfCols, '\n');
+    Logger::LOG_MSG(prefix, "    Cached texture     : ", m_pTexture ? "Yes" : "No", ", built ", m_textureBuilds, " times\n");
+}
+
+bool BgGrid::renderToTexture(SDL_Renderer* pRenderer)
+{
+    if (m_pTextureOwner != pRenderer)
+    {
+        releaseTexture();
+    }
+
+    if (!m_pTexture)
+    {
+        m_pTexture = SDL_CreateTexture(pRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, m_screenWidth, m_screenHeight);
+        if (!m_pTexture)
+        {
+            ns_Util::Logger::LOG_SDL_ERROR("BgGrid: no render target texture, drawing every frame");
+            return false;
+        }
+        m_pTextureOwner = pRenderer;
+        SDL_SetTextureBlendMode(m_pTexture, SDL_BLENDMODE_NONE);
+    }
+
+    SDL_Texture* pPrevTarget = SDL_GetRenderTarget(pRenderer);
+    if (SDL_SetRenderTarget(pRenderer, m_pTexture) != 0)
+    {
+        ns_Util::Logger::LOG_SDL_ERROR("BgGrid: can not render to texture, drawing every frame");
+        releaseTexture();
+        return false;
+    }
+    drawUncached(pRenderer);
+    SDL_SetRenderTarget(pRenderer, pPrevTarget);
+
+    m_bDirty = false;
+    ++m_textureBuilds;
+    return true;
+}
+
+void BgGrid::releaseTexture()
+{
+    if (m_pTexture)
+    {
+        SDL_DestroyTexture(m_pTexture);
+        m_pTexture = nullptr;
+    }
+    m_pTextureOwner = nullptr;
+}
+
 void BgGrid::calculateGridPoints()
 {
     m_vecX.clear();
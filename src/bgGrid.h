@@ -1,25 +1,54 @@
 #pragma once
 
 #include <SDL.h>
+#include <string>
 #include <vector>
+#include "constants.h"
 
+// Static oscilloscope background. The grid is drawn once into a render target texture and
+// every frame only copies that texture, it is redrawn when the size, the number of columns
+// or a colour changes, or when the renderer loses its targets.
 class BgGrid
 {
 public:
 	BgGrid(int screenWidth, int screenHeight, int numOfCols);
+	~BgGrid();
 
+	BgGrid(const BgGrid&) = delete;
+	BgGrid& operator=(const BgGrid&) = delete;
+
+	void update(const std::vector<SDL_Event>& events);
 	void draw(SDL_Renderer *pRenderer);
+
+	// Old path, issues every line on each call. Used when render targets are not supported.
+	void drawUncached(SDL_Renderer* pRenderer);
+
+	void setScreenSize(int screenWidth, int screenHeight);
+	void setNumOfCols(int numOfCols);
+	INLINE void setBackGroundColor(SDL_Color color) { m_backGround = color; m_bDirty = true; }
+	INLINE void setAxisColor(SDL_Color color) { m_axisColor = color; m_bDirty = true; }
+	INLINE void setGridLineColor(SDL_Color color) { m_gridLineColor = color; m_bDirty = true; }
+	INLINE void setFineLineColor(SDL_Color color) { m_fineLineColor = color; m_bDirty = true; }
+
+	INLINE int getNumOfCols() const { return m_numOfCols; }
+	INLINE bool isCached() const { return m_pTexture != nullptr; }
+
+	// Frees the cached texture, must happen before its renderer is destroyed
+	void releaseTexture();
+
+	void print(const std::string& prefix = "") const;
 private:
 	void calculateGridPoints();
+	bool renderToTexture(SDL_Renderer* pRenderer);
 	void drawFineLine(SDL_Renderer* pRenderer, int x1, int y1, int x2, int y2);
 	void drawGridLine(SDL_Renderer* pRenderer, int x1, int y1, int x2, int y2);
 	void drawAxisLine(SDL_Renderer* pRenderer, int x1, int y1, int x2, int y2);
 private:
-	const int			m_numOfCols{};
-	const int			m_screenWidth{};
-	const int			m_screenHeight{};
-	const int			m_centreX{};
-	const int			m_centreY{};
+	int					m_numOfCols{};
+	int					m_screenWidth{};
+	int					m_screenHeight{};
+	int					m_centreX{};
+	int					m_centreY{};
 
 	float				m_axisLineSF{6.0f};		// Axis line scale factor
 	float				m_gridLineSF{3.0f};		// Grid line scale factor
@@ -32,4 +61,10 @@ private:
 
 	std::vector<int>	m_vecX;
 	std::vector<int>	m_vecY;
+
+	SDL_Texture*		m_pTexture{};
+	SDL_Renderer*		m_pTextureOwner{};		// Renderer m_pTexture was created on
+	bool				m_bDirty{ true };
+	bool				m_bTargetsUnsupported{};
+	int					m_textureBuilds{};
 };
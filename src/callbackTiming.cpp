@@ -0,0 +1,173 @@
+#include "callbackTiming.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Single writer, so a plain load and store is enough and never waits
+INLINE void add(std::atomic<Uint64>& counter, Uint64 value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+INLINE Uint32 ticksToUs(Uint64 ticks, Uint64 frequency)
+{
+	return (Uint32)std::min<Uint64>(ticks * 1000000 / frequency, 0xFFFFFFFF);
+}
+}
+
+int TimingHistogram::bucketOf(Uint32 us)
+{
+	if (us < SUB_BUCKETS)
+	{
+		return (int)us;
+	}
+	int msb = 31;
+	while ((us >> msb) == 0)
+	{
+		--msb;
+	}
+	// The SUB_BUCKET_BITS bits under the leading one pick the bucket within its power of two
+	const int shift = msb - SUB_BUCKET_BITS;
+	return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + (int)((us >> shift) & (SUB_BUCKETS - 1));
+}
+
+Uint32 TimingHistogram::bucketUpperBound(int bucket)
+{
+	if (bucket < SUB_BUCKETS)
+	{
+		return (Uint32)bucket;
+	}
+	const int shift = bucket / SUB_BUCKETS - 1;
+	const Uint64 lower = (Uint64)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+	return (Uint32)std::min<Uint64>(lower + ((Uint64)1 << shift) - 1, 0xFFFFFFFF);
+}
+
+void TimingHistogram::record(Uint32 us)
+{
+	add(m_counts[bucketOf(us)], 1);
+}
+
+TimingHistogram::Snapshot TimingHistogram::snapshot() const
+{
+	Snapshot snapshot;
+	for (int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.counts[i];
+	}
+	return snapshot;
+}
+
+void TimingHistogram::reset()
+{
+	for (std::atomic<Uint64>& count : m_counts)
+	{
+		count.store(0, std::memory_order_relaxed);
+	}
+}
+
+Uint32 TimingHistogram::Snapshot::percentile(double p) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	const Uint64 rank = std::max<Uint64>(1, (Uint64)std::ceil(std::clamp(p, 0.0, 1.0) * count));
+	Uint64 seen = 0;
+	for (int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		seen += counts[i];
+		if (seen >= rank)
+		{
+			return bucketUpperBound(i);
+		}
+	}
+	return bucketUpperBound(BUCKET_COUNT - 1);
+}
+
+TimingHistogram::Snapshot TimingHistogram::Snapshot::since(const Snapshot& earlier) const
+{
+	Snapshot diff;
+	for (int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		diff.counts[i] = counts[i] - earlier.counts[i];
+		diff.count += diff.counts[i];
+	}
+	return diff;
+}
+
+void CallbackTiming::record(Uint64 startTicks, Uint64 endTicks, Uint32 frames, int sampleRate)
+{
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	const Uint32 durationUs = ticksToUs(endTicks - startTicks, frequency);
+	const Uint32 deadlineUs = sampleRate > 0 ? (Uint32)((Uint64)frames * 1000000 / (Uint64)sampleRate) : 0;
+
+	m_duration.record(durationUs);
+	if (m_lastStart != 0)
+	{
+		m_interval.record(ticksToUs(startTicks - m_lastStart, frequency));
+	}
+	m_lastStart = startTicks;
+
+	add(m_busyUs, durationUs);
+	add(m_deadlineUs, deadlineUs);
+	m_lastDeadlineUs.store(deadlineUs, std::memory_order_relaxed);
+	if (durationUs > deadlineUs)
+	{
+		add(m_misses, 1);
+	}
+
+	// Last, a report that sees this callback sees the rest of it
+	m_callbacks.store(m_callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+CallbackTiming::Report CallbackTiming::report() const
+{
+	Report report;
+	report.callbacks = m_callbacks.load(std::memory_order_acquire);
+	report.misses = m_misses.load(std::memory_order_relaxed);
+	report.busyUs = m_busyUs.load(std::memory_order_relaxed);
+	report.deadlineUs = m_deadlineUs.load(std::memory_order_relaxed);
+	report.lastDeadlineUs = m_lastDeadlineUs.load(std::memory_order_relaxed);
+	report.duration = m_duration.snapshot();
+	report.interval = m_interval.snapshot();
+	return report;
+}
+
+void CallbackTiming::reset()
+{
+	m_duration.reset();
+	m_interval.reset();
+	m_callbacks.store(0, std::memory_order_relaxed);
+	m_misses.store(0, std::memory_order_relaxed);
+	m_busyUs.store(0, std::memory_order_relaxed);
+	m_deadlineUs.store(0, std::memory_order_relaxed);
+	m_lastDeadlineUs.store(0, std::memory_order_relaxed);
+	m_lastStart = 0;
+}
+
+CallbackTiming::Report CallbackTiming::Report::since(const Report& earlier) const
+{
+	Report diff;
+	diff.duration = duration.since(earlier.duration);
+	diff.interval = interval.since(earlier.interval);
+	diff.callbacks = callbacks - earlier.callbacks;
+	diff.misses = misses - earlier.misses;
+	diff.busyUs = busyUs - earlier.busyUs;
+	diff.deadlineUs = deadlineUs - earlier.deadlineUs;
+	diff.lastDeadlineUs = lastDeadlineUs;
+	return diff;
+}
+
+void CallbackTiming::Report::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "CallbackTiming: \n");
+	Logger::LOG_MSG(prefix, "    Callbacks          : ", callbacks, ", deadline ", lastDeadlineUs, " us, ", misses, " missed\n");
+	Logger::LOG_MSG(prefix, "    DSP load           : ", load(), " %, peak ", peakLoad(), " %\n");
+	Logger::LOG_MSG(prefix, "    Duration(in us)    : p50 ", duration.percentile(0.5), ", p99 ", duration.percentile(0.99), ", max ", duration.max(), '\n');
+	Logger::LOG_MSG(prefix, "    Interval(in us)    : p50 ", interval.percentile(0.5), ", p99 ", interval.percentile(0.99), ", max ", interval.max(), '\n');
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <SDL.h>
+#include "constants.h"
+
+// Histogram of times in microseconds. Buckets are exact below SUB_BUCKETS and then
+// SUB_BUCKETS per power of two, so a bucket's upper bound is within 12.5 % of every value
+// in it, from 1 us to over an hour. One thread records, any thread takes snapshots, no locks.
+class TimingHistogram
+{
+public:
+	static constexpr int SUB_BUCKET_BITS = 3;
+	static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static constexpr int BUCKET_COUNT = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	struct Snapshot
+	{
+		std::array<Uint64, BUCKET_COUNT>	counts{};
+		Uint64								count{};
+
+		// Upper bound of the bucket holding the p-th fraction of the values, 0 when empty
+		Uint32 percentile(double p) const;
+		INLINE Uint32 max() const { return percentile(1.0); }
+
+		// What was recorded between earlier and this one
+		Snapshot since(const Snapshot& earlier) const;
+	};
+
+	// Recording thread only
+	void record(Uint32 us);
+
+	Snapshot snapshot() const;
+
+	// Only while nothing records
+	void reset();
+
+	static int bucketOf(Uint32 us);
+	static Uint32 bucketUpperBound(int bucket);
+private:
+	std::array<std::atomic<Uint64>, BUCKET_COUNT>	m_counts{};
+};
+
+// How long the audio callback takes against the time its buffer lasts.
+//
+// The callback stamps itself with SDL_GetPerformanceCounter() on entry and exit. Its
+// duration and the interval since the previous callback go into histograms, and the
+// deadline is the buffer length, samples * 1000 / freq ms. A callback that takes longer than
+// its deadline is a miss, the device runs dry before the next buffer is ready. DSP load is
+// the time spent in the callback over the time the buffers played for.
+class CallbackTiming
+{
+public:
+	struct Report
+	{
+		TimingHistogram::Snapshot	duration;
+		TimingHistogram::Snapshot	interval;
+		Uint64						callbacks{};
+		Uint64						misses{};
+		Uint64						busyUs{};
+		Uint64						deadlineUs{};		// Summed over the callbacks
+		Uint32						lastDeadlineUs{};
+
+		// Percent of the buffer time spent in the callback, on average and at worst
+		INLINE double load() const { return deadlineUs > 0 ? 100.0 * busyUs / deadlineUs : 0.0; }
+		INLINE double peakLoad() const { return lastDeadlineUs > 0 ? 100.0 * duration.max() / lastDeadlineUs : 0.0; }
+
+		Report since(const Report& earlier) const;
+
+		void print(const std::string& prefix = "") const;
+	};
+
+	// Audio thread, once per callback that filled frames frames at sampleRate
+	void record(Uint64 startTicks, Uint64 endTicks, Uint32 frames, int sampleRate);
+
+	// Everything since the last reset(), from any thread
+	Report report() const;
+
+	// Only while the callback does not run
+	void reset();
+
+	// Only while the callback does not run, the next callback starts over instead of counting
+	// the pause as an interval
+	INLINE void restartInterval() { m_lastStart = 0; }
+private:
+	TimingHistogram			m_duration;
+	TimingHistogram			m_interval;
+	std::atomic<Uint64>		m_callbacks{};
+	std::atomic<Uint64>		m_misses{};
+	std::atomic<Uint64>		m_busyUs{};
+	std::atomic<Uint64>		m_deadlineUs{};
+	std::atomic<Uint32>		m_lastDeadlineUs{};
+	Uint64					m_lastStart{};			// Audio thread
+};
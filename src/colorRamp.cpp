@@ -0,0 +1,73 @@
+#include "colorRamp.h"
+#include "logger.h"
+
+#include <algorithm>
+
+void buildColorRamp(const ColorStop* pStops, int stopCount, Uint32* pLut, int count)
+{
+	int s = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const float x = count > 1 ? (float)i / (count - 1) : 0.0f;
+		while (s + 2 < stopCount && x > pStops[s + 1].at)
+		{
+			++s;
+		}
+		const ColorStop& lo = pStops[s];
+		const ColorStop& hi = pStops[std::min(s + 1, stopCount - 1)];
+		const float t = hi.at > lo.at ? std::clamp((x - lo.at) / (hi.at - lo.at), 0.0f, 1.0f) : 0.0f;
+		const Uint32 r = (Uint32)(lo.r + (hi.r - lo.r) * t + 0.5f);
+		const Uint32 g = (Uint32)(lo.g + (hi.g - lo.g) * t + 0.5f);
+		const Uint32 b = (Uint32)(lo.b + (hi.b - lo.b) * t + 0.5f);
+		pLut[i] = 0xff000000u | (r << 16) | (g << 8) | b;
+	}
+}
+
+void StreamingTexture::setSize(int width, int height)
+{
+	release();
+	m_width = std::max(width, 1);
+	m_height = std::max(height, 1);
+}
+
+void StreamingTexture::update(const std::vector<SDL_Event>& events)
+{
+	for (size_t i = 0, size = events.size(); i < size; ++i)
+	{
+		if (events[i].type == SDL_RENDER_DEVICE_RESET)
+		{
+			release();
+		}
+	}
+}
+
+SDL_Texture* StreamingTexture::acquire(SDL_Renderer* pRenderer, bool& bCreated)
+{
+	bCreated = false;
+	if (m_pTexture && m_pTextureOwner == pRenderer)
+	{
+		return m_pTexture;
+	}
+	release();
+	m_pTexture = SDL_CreateTexture(pRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, m_width, m_height);
+	if (!m_pTexture)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR(m_pName, ": can not create the streaming texture");
+		return nullptr;
+	}
+	m_pTextureOwner = pRenderer;
+	SDL_SetTextureBlendMode(m_pTexture, m_blendMode);
+	++m_builds;
+	bCreated = true;
+	return m_pTexture;
+}
+
+void StreamingTexture::release()
+{
+	if (m_pTexture)
+	{
+		SDL_DestroyTexture(m_pTexture);
+		m_pTexture = nullptr;
+	}
+	m_pTextureOwner = nullptr;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+
+// Colour of a ramp at position at, from 0 to 1
+struct ColorStop
+{
+	float	at;
+	float	r, g, b;
+};
+
+// count opaque SDL_PIXELFORMAT_ARGB8888 colours into pLut, entry i at i / (count - 1) along
+// the ramp, blended linearly between the stops around it. Stops go from 0 to 1 in order.
+extern void buildColorRamp(const ColorStop* pStops, int stopCount, Uint32* pLut, int count);
+
+// Streaming SDL_PIXELFORMAT_ARGB8888 texture of an image drawn on one renderer.
+//
+// The texture belongs to the renderer it was created on. acquire() makes it again when asked
+// for another renderer or after update() saw the device reset, and says when it did, as the
+// pixels of a new texture have to be written again.
+class StreamingTexture
+{
+public:
+	StreamingTexture(const char* pName, SDL_BlendMode blendMode) : m_pName(pName), m_blendMode(blendMode) {}
+	~StreamingTexture() { release(); }
+
+	StreamingTexture(const StreamingTexture&) = delete;
+	StreamingTexture& operator=(const StreamingTexture&) = delete;
+
+	// width by height pixels from the next acquire()
+	void setSize(int width, int height);
+
+	// Drops the texture when the device was reset, it is gone with it
+	void update(const std::vector<SDL_Event>& events);
+
+	// Texture on pRenderer, nullptr when it can not be created. bCreated is set when it was
+	// just made and its pixels are undefined.
+	SDL_Texture* acquire(SDL_Renderer* pRenderer, bool& bCreated);
+
+	// Texture made on pRenderer, nullptr when there is none
+	INLINE SDL_Texture* get(SDL_Renderer* pRenderer) const { return m_pTextureOwner == pRenderer ? m_pTexture : nullptr; }
+
+	// Frees the texture, must happen before its renderer is destroyed
+	void release();
+
+	INLINE bool isCreated() const { return m_pTexture != nullptr; }
+	INLINE int builds() const { return m_builds; }
+private:
+	const char*			m_pName;				// Prefix of error messages
+	SDL_BlendMode		m_blendMode;
+	int					m_width{ 1 };
+	int					m_height{ 1 };
+	SDL_Texture*		m_pTexture{};
+	SDL_Renderer*		m_pTextureOwner{};		// Renderer m_pTexture was created on
+	int					m_builds{};
+};
@@ -0,0 +1,283 @@
+#include "fft.h"
+#include "simd.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+constexpr double PI = 3.14159265358979323846;
+
+INLINE Uint32 log2Of(Uint32 size)
+{
+	Uint32 bits = 0;
+	while ((1u << bits) < size)
+	{
+		++bits;
+	}
+	return bits;
+}
+
+// One radix-2 stage over n complex points, butterflies of span h
+void butterfliesScalar(float* pRe, float* pIm, Uint32 n, Uint32 h, const float* pCos, const float* pSin)
+{
+	for (Uint32 s = 0; s < n; s += 2 * h)
+	{
+		for (Uint32 j = 0; j < h; ++j)
+		{
+			const Uint32 a = s + j;
+			const Uint32 b = a + h;
+			const float tr = pRe[b] * pCos[j] - pIm[b] * pSin[j];
+			const float ti = pRe[b] * pSin[j] + pIm[b] * pCos[j];
+			pRe[b] = pRe[a] - tr;
+			pIm[b] = pIm[a] - ti;
+			pRe[a] += tr;
+			pIm[a] += ti;
+		}
+	}
+}
+
+#if OSC_X86
+// Four butterflies at a time, h is a multiple of 4
+OSC_TARGET_SSE2 void butterfliesSse2(float* pRe, float* pIm, Uint32 n, Uint32 h, const float* pCos, const float* pSin)
+{
+	for (Uint32 s = 0; s < n; s += 2 * h)
+	{
+		for (Uint32 j = 0; j < h; j += 4)
+		{
+			const Uint32 a = s + j;
+			const Uint32 b = a + h;
+			const __m128 wc = _mm_loadu_ps(pCos + j);
+			const __m128 ws = _mm_loadu_ps(pSin + j);
+			const __m128 ar = _mm_loadu_ps(pRe + a);
+			const __m128 ai = _mm_loadu_ps(pIm + a);
+			const __m128 br = _mm_loadu_ps(pRe + b);
+			const __m128 bi = _mm_loadu_ps(pIm + b);
+			const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wc), _mm_mul_ps(bi, ws));
+			const __m128 ti = _mm_add_ps(_mm_mul_ps(br, ws), _mm_mul_ps(bi, wc));
+			_mm_storeu_ps(pRe + b, _mm_sub_ps(ar, tr));
+			_mm_storeu_ps(pIm + b, _mm_sub_ps(ai, ti));
+			_mm_storeu_ps(pRe + a, _mm_add_ps(ar, tr));
+			_mm_storeu_ps(pIm + a, _mm_add_ps(ai, ti));
+		}
+	}
+}
+
+// 10 * log10(x) for x > 0. x = 2^e * m with m moved into [sqrt(1/2), sqrt(2)), then
+// log2(m) = 2 / ln(2) * atanh(t), t = (m - 1) / (m + 1), from four terms of the atanh series.
+// |t| < 0.172, so the first term left out is below 2e-8.
+OSC_TARGET_SSE2 INLINE __m128 decibelsSse2(__m128 x)
+{
+	const __m128i bits = _mm_castps_si128(x);
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+	const __m128 bHigh = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+	m = _mm_sub_ps(m, _mm_and_ps(bHigh, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+	e = _mm_add_ps(e, _mm_and_ps(bHigh, _mm_set1_ps(1.0f)));
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+	const __m128 t2 = _mm_mul_ps(t, t);
+	__m128 series = _mm_add_ps(_mm_set1_ps(1.0f / 5.0f), _mm_mul_ps(t2, _mm_set1_ps(1.0f / 7.0f)));
+	series = _mm_add_ps(_mm_set1_ps(1.0f / 3.0f), _mm_mul_ps(t2, series));
+	series = _mm_add_ps(one, _mm_mul_ps(t2, series));
+	const __m128 log2m = _mm_mul_ps(_mm_mul_ps(t, series), _mm_set1_ps((float)(2.0 / 0.69314718055994531)));
+
+	// 10 * log10(2)
+	return _mm_mul_ps(_mm_add_ps(e, log2m), _mm_set1_ps(3.01029995663981195f));
+}
+
+OSC_TARGET_SSE2 Uint32 powerToDbSse2(const float* pRe, const float* pIm, float* pDb, Uint32 count, float scale, float floorPower)
+{
+	const __m128 vScale = _mm_set1_ps(scale);
+	const __m128 vFloor = _mm_set1_ps(floorPower);
+	Uint32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 re = _mm_loadu_ps(pRe + i);
+		const __m128 im = _mm_loadu_ps(pIm + i);
+		const __m128 power = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)), vScale);
+		_mm_storeu_ps(pDb + i, decibelsSse2(_mm_max_ps(power, vFloor)));
+	}
+	return i;
+}
+#endif // OSC_X86
+}
+
+std::string fftWindow2String(FftWindow window)
+{
+	switch (window)
+	{
+		case FftWindow::RECTANGULAR:		return "Rectangular";
+		case FftWindow::HANN:				return "Hann";
+		case FftWindow::HAMMING:			return "Hamming";
+		case FftWindow::BLACKMAN_HARRIS:	return "Blackman-Harris";
+		case FftWindow::FLAT_TOP:			return "Flat top";
+		default:							return "Unknown";
+	}
+}
+
+void makeFftWindow(FftWindow window, float* pOut, Uint32 n)
+{
+	// Generalised cosine windows, w(i) = sum of a[k] * cos(2 pi k i / n) with alternating signs
+	std::array<double, 5> a{ 1.0, 0.0, 0.0, 0.0, 0.0 };
+	switch (window)
+	{
+		case FftWindow::HANN:				a = { 0.5, 0.5, 0.0, 0.0, 0.0 };								break;
+		case FftWindow::HAMMING:			a = { 0.54, 0.46, 0.0, 0.0, 0.0 };								break;
+		case FftWindow::BLACKMAN_HARRIS:	a = { 0.35875, 0.48829, 0.14128, 0.01168, 0.0 };				break;
+		case FftWindow::FLAT_TOP:			a = { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 };	break;
+		default:																							break;
+	}
+
+	double sum = 0.0;
+	std::vector<double> w(n);
+	for (Uint32 i = 0; i < n; ++i)
+	{
+		double v = 0.0;
+		double sign = 1.0;
+		for (size_t k = 0; k < a.size(); ++k)
+		{
+			v += sign * a[k] * std::cos(2.0 * PI * (double)k * i / n);
+			sign = -sign;
+		}
+		w[i] = v;
+		sum += v;
+	}
+	for (Uint32 i = 0; i < n; ++i)
+	{
+		pOut[i] = (float)(w[i] * 2.0 / sum);
+	}
+}
+
+RealFft::RealFft(Uint32 size, SimdLevel level)
+	: m_size(1u << log2Of(std::clamp(size, MIN_SIZE, MAX_SIZE)))
+	, m_half(m_size / 2)
+	, m_simdLevel(OSC_X86 && level >= SimdLevel::SSE2 ? SimdLevel::SSE2 : SimdLevel::SCALAR)
+{
+	if (size != m_size)
+	{
+		ns_Util::Logger::LOG_ERROR("FFT size ", size, " is not a power of two in [", MIN_SIZE, ", ", MAX_SIZE, "], using ", m_size, '\n');
+	}
+
+	const Uint32 bits = log2Of(m_half);
+	m_bitReverse.resize(m_half);
+	for (Uint32 i = 0; i < m_half; ++i)
+	{
+		Uint32 r = 0;
+		for (Uint32 b = 0; b < bits; ++b)
+		{
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+		m_bitReverse[i] = r;
+	}
+
+	// e^(-i pi j / h) for the stage of span h, laid out stage after stage
+	m_stageCos.resize(m_half);
+	m_stageSin.resize(m_half);
+	for (Uint32 h = 1; h < m_half; h *= 2)
+	{
+		for (Uint32 j = 0; j < h; ++j)
+		{
+			m_stageCos[h - 1 + j] = (float)std::cos(PI * j / h);
+			m_stageSin[h - 1 + j] = (float)-std::sin(PI * j / h);
+		}
+	}
+
+	m_splitCos.resize(m_half);
+	m_splitSin.resize(m_half);
+	for (Uint32 k = 0; k < m_half; ++k)
+	{
+		m_splitCos[k] = (float)std::cos(2.0 * PI * k / m_size);
+		m_splitSin[k] = (float)-std::sin(2.0 * PI * k / m_size);
+	}
+}
+
+const RealFft& RealFft::plan(Uint32 size)
+{
+	static std::mutex s_mutex;
+	static std::array<std::unique_ptr<RealFft>, 17> s_plans;
+
+	const Uint32 index = log2Of(std::clamp(size, MIN_SIZE, MAX_SIZE));
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (!s_plans[index])
+	{
+		s_plans[index] = std::make_unique<RealFft>(1u << index);
+	}
+	return *s_plans[index];
+}
+
+void RealFft::forward(const float* pIn, float* pRe, float* pIm, float* pScratch) const
+{
+	// Even samples are the real part and odd ones the imaginary part of N/2 complex points,
+	// loaded in bit reversed order for the in place stages
+	float* pZr = pScratch;
+	float* pZi = pScratch + m_half;
+	for (Uint32 i = 0; i < m_half; ++i)
+	{
+		const Uint32 r = m_bitReverse[i];
+		pZr[r] = pIn[2 * i];
+		pZi[r] = pIn[2 * i + 1];
+	}
+
+	for (Uint32 h = 1; h < m_half; h *= 2)
+	{
+#if OSC_X86
+		if (m_simdLevel >= SimdLevel::SSE2 && h >= 4)
+		{
+			butterfliesSse2(pZr, pZi, m_half, h, m_stageCos.data() + h - 1, m_stageSin.data() + h - 1);
+			continue;
+		}
+#endif
+		butterfliesScalar(pZr, pZi, m_half, h, m_stageCos.data() + h - 1, m_stageSin.data() + h - 1);
+	}
+
+	// X[k] = E[k] + e^(-2 pi i k / N) * O[k], the spectra of the even and odd samples taken
+	// apart from Z[k] and conj(Z[N/2 - k])
+	pRe[0] = pZr[0] + pZi[0];
+	pIm[0] = 0.0f;
+	pRe[m_half] = pZr[0] - pZi[0];
+	pIm[m_half] = 0.0f;
+	for (Uint32 k = 1; k < m_half; ++k)
+	{
+		const float a = pZr[k];
+		const float b = pZi[k];
+		const float c = pZr[m_half - k];
+		const float d = pZi[m_half - k];
+		const float evenRe = 0.5f * (a + c);
+		const float evenIm = 0.5f * (b - d);
+		const float oddRe = 0.5f * (b + d);
+		const float oddIm = 0.5f * (c - a);
+		pRe[k] = evenRe + m_splitCos[k] * oddRe - m_splitSin[k] * oddIm;
+		pIm[k] = evenIm + m_splitCos[k] * oddIm + m_splitSin[k] * oddRe;
+	}
+}
+
+size_t RealFft::memoryUsage() const
+{
+	return m_bitReverse.capacity() * sizeof(Uint32)
+		+ (m_stageCos.capacity() + m_stageSin.capacity() + m_splitCos.capacity() + m_splitSin.capacity()) * sizeof(float);
+}
+
+void powerToDb(const float* pRe, const float* pIm, float* pDb, Uint32 count, float scale, float floorPower, SimdLevel level)
+{
+	Uint32 i = 0;
+#if OSC_X86
+	if (level >= SimdLevel::SSE2)
+	{
+		i = powerToDbSse2(pRe, pIm, pDb, count, scale, floorPower);
+	}
+#else
+	(void)level;
+#endif
+	for (; i < count; ++i)
+	{
+		const float power = (pRe[i] * pRe[i] + pIm[i] * pIm[i]) * scale;
+		pDb[i] = 10.0f * std::log10(std::max(power, floorPower));
+	}
+}
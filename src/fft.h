@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+#include "waveKernels.h"
+
+// Window applied to a block of samples before it is transformed
+enum class FftWindow
+{
+	RECTANGULAR,
+	HANN,
+	HAMMING,
+	BLACKMAN_HARRIS,
+	FLAT_TOP,
+	MAX
+};
+
+extern std::string fftWindow2String(FftWindow window);
+
+// Fills pOut[0, n) with the window, scaled so a full scale sine on a bin centre comes out at
+// magnitude 1 whichever window is used. The scale is 2 / sum of the window.
+extern void makeFftWindow(FftWindow window, float* pOut, Uint32 n);
+
+// Forward FFT of real input of one power-of-two size.
+//
+// The N real samples are transformed as N/2 complex ones, even samples as the real part and
+// odd samples as the imaginary part, with an iterative radix-2 FFT and then split into the
+// N/2 + 1 bins of the real spectrum. Bit reversal and every twiddle factor are computed
+// once when the plan is made, each butterfly stage reads its twiddles contiguously, and
+// forward() allocates nothing. Results are split into real and imaginary arrays so the
+// stages and the magnitude conversion run four bins at a time with SSE2.
+class RealFft
+{
+public:
+	static constexpr Uint32 MIN_SIZE = 16;
+	static constexpr Uint32 MAX_SIZE = 1 << 16;
+
+	// size must be a power of two in [MIN_SIZE, MAX_SIZE]
+	explicit RealFft(Uint32 size, SimdLevel level = detectSimdLevel());
+
+	// Shared plan for the size, made on first use and kept for the life of the program.
+	// Safe to call from any thread, forward() only reads the plan so threads can share it.
+	static const RealFft& plan(Uint32 size);
+
+	INLINE Uint32 size() const { return m_size; }
+	INLINE Uint32 bins() const { return m_size / 2 + 1; }
+	INLINE SimdLevel getSimdLevel() const { return m_simdLevel; }
+
+	// pIn holds size() samples, pRe and pIm get bins() values each. pScratch holds size()
+	// floats, the caller owns it so one plan serves several threads.
+	void forward(const float* pIn, float* pRe, float* pIm, float* pScratch) const;
+
+	// Heap bytes held by the plan
+	size_t memoryUsage() const;
+private:
+	Uint32					m_size{};
+	Uint32					m_half{};			// Complex points, m_size / 2
+	SimdLevel				m_simdLevel{};
+	std::vector<Uint32>		m_bitReverse;		// m_half entries
+	std::vector<float>		m_stageCos;			// Stage of span h uses [h - 1, 2h - 1)
+	std::vector<float>		m_stageSin;
+	std::vector<float>		m_splitCos;			// e^(-2 pi i k / N), k in [0, N / 2)
+	std::vector<float>		m_splitSin;
+};
+
+// pDb[i] = 10 * log10(max((re^2 + im^2) * scale, floorPower)). The SSE2 path takes log2
+// from the float's exponent and a polynomial on its mantissa, good to about 0.001 dB.
+extern void powerToDb(const float* pRe, const float* pIm, float* pDb, Uint32 count, float scale, float floorPower,
+	SimdLevel level = detectSimdLevel());
@@ -0,0 +1,89 @@
+#include "framePacer.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <thread>
+
+void FramePacer::start(double framesPerSecond, bool bVsync)
+{
+	m_targetFps = std::max(framesPerSecond, 1.0);
+	m_bVsync = bVsync;
+	m_period = (Uint64)(SDL_GetPerformanceFrequency() / m_targetFps);
+	m_start = m_lastFrameEnd = m_windowStart = SDL_GetPerformanceCounter();
+	m_deadline = m_start + m_period;
+	m_frames = m_missed = m_windowFrames = 0;
+	m_windowFps = 0;
+}
+
+void FramePacer::wait()
+{
+	const Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (m_bVsync)
+	{
+		// Present already waited for the display
+		if (now - m_lastFrameEnd > m_period + m_period / 2)
+		{
+			++m_missed;
+		}
+	}
+	else if (now > m_deadline)
+	{
+		++m_missed;
+		if (now - m_deadline > m_period)
+		{
+			m_deadline = now;
+		}
+	}
+	else
+	{
+		const Uint64 spinTicks = (Uint64)(SPIN_MS * frequency / 1000.0);
+		while (m_deadline - now > spinTicks)
+		{
+			SDL_Delay((Uint32)((m_deadline - now - spinTicks) * 1000 / frequency));
+			now = SDL_GetPerformanceCounter();
+			if (now >= m_deadline)
+			{
+				break;
+			}
+		}
+		while (now < m_deadline)
+		{
+			std::this_thread::yield();
+			now = SDL_GetPerformanceCounter();
+		}
+	}
+	m_deadline += m_period;
+	m_lastFrameEnd = now;
+	++m_frames;
+
+	++m_windowFrames;
+	if ((now - m_windowStart) * 1000.0 / frequency >= FPS_WINDOW_MS)
+	{
+		m_windowFps = m_windowFrames * (double)frequency / (now - m_windowStart);
+		m_windowStart = now;
+		m_windowFrames = 0;
+	}
+}
+
+double FramePacer::averageFps() const
+{
+	const Uint64 elapsed = m_lastFrameEnd - m_start;
+	return elapsed > 0 ? m_frames * (double)SDL_GetPerformanceFrequency() / elapsed : 0.0;
+}
+
+void FramePacer::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "FramePacer: \n");
+	if (m_bVsync)
+	{
+		Logger::LOG_MSG(prefix, "    Target             : ", m_targetFps, " fps, vsync\n");
+	}
+	else
+	{
+		Logger::LOG_MSG(prefix, "    Target             : ", m_targetFps, " fps, sleeps then spins the last ", SPIN_MS, " ms\n");
+	}
+	Logger::LOG_MSG(prefix, "    Achieved           : ", achievedFps(), " fps over the last second, ", averageFps(), " fps on average\n");
+	Logger::LOG_MSG(prefix, "    Frames             : ", m_frames, ", ", m_missed, " missed\n");
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <SDL.h>
+#include "constants.h"
+
+// Paces the frame loop on SDL_GetPerformanceCounter().
+//
+// Frame n is due at start + n * period, an absolute deadline, so oversleeping one frame is
+// taken back by the next instead of adding up. wait() sleeps with SDL_Delay() until
+// SPIN_MS before the deadline and spins the rest, SDL_Delay() can be late by a millisecond
+// or more. A frame whose work runs past its deadline is a miss, and when it is late by more
+// than a whole period the deadlines start over from now rather than rushing frames out to
+// catch up.
+//
+// With vsync, SDL_RenderPresent() waits for the display and wait() only keeps count, a frame
+// that took longer than 1.5 refresh periods missed a refresh.
+class FramePacer
+{
+public:
+	static constexpr double SPIN_MS = 2.0;
+	static constexpr double FPS_WINDOW_MS = 1000.0;		// Achieved FPS is measured over this
+
+	// Paces at framesPerSecond, or only measures against it when bVsync
+	void start(double framesPerSecond, bool bVsync);
+
+	// End of the frame's work, returns once the next frame is due
+	void wait();
+
+	INLINE double targetFps() const { return m_targetFps; }
+	INLINE bool isVsync() const { return m_bVsync; }
+	INLINE Uint64 frameCount() const { return m_frames; }
+	INLINE Uint64 missedFrames() const { return m_missed; }
+
+	// Over the last FPS_WINDOW_MS, and since start()
+	INLINE double achievedFps() const { return m_windowFps; }
+	double averageFps() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	double			m_targetFps{};
+	bool			m_bVsync{};
+	Uint64			m_period{};				// Ticks
+	Uint64			m_start{};
+	Uint64			m_deadline{};			// Of the current frame
+	Uint64			m_lastFrameEnd{};
+	Uint64			m_frames{};
+	Uint64			m_missed{};
+
+	Uint64			m_windowStart{};
+	Uint64			m_windowFrames{};
+	double			m_windowFps{};
+};
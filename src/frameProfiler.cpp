@@ -0,0 +1,118 @@
+#include "frameProfiler.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <fstream>
+
+std::string framePhase2String(FramePhase phase)
+{
+	switch (phase)
+	{
+		case FramePhase::INPUT:		return "Input";
+		case FramePhase::UPDATE:	return "Update";
+		case FramePhase::GRID:		return "Grid";
+		case FramePhase::TRACE:		return "Trace";
+		case FramePhase::PRESENT:	return "Present";
+		case FramePhase::FRAME:		return "Frame";
+		default:					return "Unknown";
+	}
+}
+
+void FrameProfiler::beginFrame()
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+	if (m_frameStart != 0)
+	{
+		// The previous frame ends where this one starts
+		m_current[(int)FramePhase::FRAME] = now - m_frameStart;
+		const double msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+		std::array<float, PHASE_COUNT>& slot = m_ring[m_frames % RING_FRAMES];
+		for (int p = 0; p < PHASE_COUNT; ++p)
+		{
+			slot[p] = (float)(m_current[p] * msPerTick);
+		}
+		++m_frames;
+	}
+	m_current.fill(0);
+	m_frameStart = now;
+}
+
+FrameProfiler::PhaseStats FrameProfiler::stats(FramePhase phase) const
+{
+	PhaseStats stats;
+	const Uint32 count = windowSize();
+	if (count == 0)
+	{
+		return stats;
+	}
+	std::vector<float> times(count);
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		times[i] = m_ring[i][(int)phase];
+	}
+	std::sort(times.begin(), times.end());
+	for (float t : times)
+	{
+		stats.mean += t;
+	}
+	stats.mean /= count;
+	stats.p50 = times[(count - 1) / 2];
+	stats.p99 = times[(size_t)((count - 1) * 0.99)];
+	stats.max = times.back();
+	return stats;
+}
+
+void FrameProfiler::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "FrameProfiler: \n");
+	Logger::LOG_MSG(prefix, "    Frames             : ", m_frames, ", last ", windowSize(), " below, in ms\n");
+
+	double work = 0;
+	PhaseStats phases[PHASE_COUNT];
+	for (int p = 0; p < PHASE_COUNT; ++p)
+	{
+		phases[p] = stats((FramePhase)p);
+		work += p == (int)FramePhase::FRAME ? 0.0 : phases[p].mean;
+	}
+	for (int p = 0; p < PHASE_COUNT; ++p)
+	{
+		std::string name = framePhase2String((FramePhase)p);
+		name.resize(19, ' ');
+		Logger::LOG_MSG(prefix, "    ", name, ": mean ", phases[p].mean, ", p50 ", phases[p].p50, ", p99 ", phases[p].p99, ", max ", phases[p].max);
+		if (p != (int)FramePhase::FRAME && work > 0)
+		{
+			Logger::LOG_MSG(", ", 100.0 * phases[p].mean / work, " % of the work");
+		}
+		Logger::LOG_MSG('\n');
+	}
+}
+
+bool FrameProfiler::writeCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	file << "frame";
+	for (int p = 0; p < PHASE_COUNT; ++p)
+	{
+		file << ',' << framePhase2String((FramePhase)p);
+	}
+	file << '\n';
+
+	const Uint32 count = windowSize();
+	for (Uint64 frame = m_frames - count; frame < m_frames; ++frame)
+	{
+		file << frame;
+		for (float ms : m_ring[frame % RING_FRAMES])
+		{
+			file << ',' << ms;
+		}
+		file << '\n';
+	}
+	if (!file)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to write ", path, '\n');
+		return false;
+	}
+	ns_Util::Logger::LOG_MSG("Wrote ", count, " frame times to ", path, '\n');
+	return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+
+// Parts of a frame of IO_Engine::loop(). Grid and trace are the draw calls that queue the
+// work, SDL may batch them and only send them to the GPU in present.
+enum class FramePhase
+{
+	INPUT,
+	UPDATE,
+	GRID,
+	TRACE,
+	PRESENT,
+	FRAME,		// Start of one frame to the start of the next, sleeping included
+	MAX
+};
+
+extern std::string framePhase2String(FramePhase phase);
+
+// Keeps the time of every phase of the last RING_FRAMES frames. Percentiles are worked out
+// over that window when asked for, recording a phase is two counter reads and a store.
+class FrameProfiler
+{
+public:
+	static constexpr Uint32 RING_FRAMES = 1024;
+	static constexpr int PHASE_COUNT = (int)FramePhase::MAX;
+
+	struct PhaseStats
+	{
+		double	mean{};			// ms
+		double	p50{};
+		double	p99{};
+		double	max{};
+	};
+
+	FrameProfiler() : m_ring(RING_FRAMES) {}
+
+	// Closes the previous frame and starts the next one, phases recorded after it belong to it
+	void beginFrame();
+
+	INLINE void record(FramePhase phase, Uint64 ticks) { m_current[(int)phase] += ticks; }
+
+	INLINE Uint64 frameCount() const { return m_frames; }
+
+	// Over the frames in the ring
+	PhaseStats stats(FramePhase phase) const;
+
+	void print(const std::string& prefix = "") const;
+
+	// The ring as CSV, oldest frame first, one column per phase in ms
+	bool writeCsv(const std::string& path) const;
+private:
+	Uint32 windowSize() const { return (Uint32)std::min<Uint64>(m_frames, RING_FRAMES); }
+
+	std::vector<std::array<float, PHASE_COUNT>>	m_ring;			// ms, frame n in slot n % RING_FRAMES
+	std::array<Uint64, PHASE_COUNT>				m_current{};	// Ticks of the frame being recorded
+	Uint64										m_frameStart{};
+	Uint64										m_frames{};
+};
+
+// Records the time from construction to destruction as phase
+class ScopedPhaseTimer
+{
+public:
+	ScopedPhaseTimer(FrameProfiler& profiler, FramePhase phase)
+		: m_profiler(profiler), m_phase(phase), m_start(SDL_GetPerformanceCounter()) {}
+	~ScopedPhaseTimer() { m_profiler.record(m_phase, SDL_GetPerformanceCounter() - m_start); }
+
+	ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+	ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+private:
+	FrameProfiler&	m_profiler;
+	FramePhase		m_phase;
+	Uint64			m_start;
+};
@@ -0,0 +1,133 @@
+#include "frameRecorder.h"
+#include "oscilloscope.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// Byte order the PNG encoder takes as it is
+constexpr Uint32 FRAME_FORMAT = SDL_PIXELFORMAT_RGBA32;
+
+std::string framePath(const std::string& prefix, Uint64 frame)
+{
+	char number[24];
+	std::snprintf(number, sizeof(number), "%06llu", (unsigned long long)frame);
+	return prefix + number + ".png";
+}
+}
+
+bool FrameRecorder::run()
+{
+	SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormat(0, m_settings.width, m_settings.height, SDL_BITSPERPIXEL(FRAME_FORMAT), FRAME_FORMAT);
+	if (!pSurface)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR("Failed to create the frame surface");
+		return false;
+	}
+	SDL_Renderer* pRenderer = SDL_CreateSoftwareRenderer(pSurface);
+	if (!pRenderer)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR("Failed to create the software renderer");
+		SDL_FreeSurface(pSurface);
+		return false;
+	}
+
+	Oscilloscope scope(m_settings.width, m_settings.height, NUM_OF_COLUMNS);
+	scope.setAudioFile(m_settings.audioFile, m_settings.rawLayout);
+	bool bOk = scope.initOffline() && m_encoders.start(m_settings.encoders);
+	SoundWavePlayer& player = scope.getSoundWavePlayer();
+	player.setWaveForm(m_settings.waveForm);
+	player.setFrequency(m_settings.frequency);
+
+	const Uint32 blockBytes = player.getDeviceSpecs()->size;
+	const Uint32 blockFrames = player.getDeviceSpecs()->samples;
+	std::vector<Uint8> audio(blockBytes);
+	const std::vector<SDL_Event> noEvents;
+	const Uint64 msPerFrame = (Uint64)(1000 / std::max(m_settings.framesPerSecond, 1));
+	const size_t rowBytes = (size_t)pSurface->w * pSurface->format->BytesPerPixel;
+	m_frames = m_silentBlocks = m_audioTicks = m_drawTicks = m_copyTicks = 0;
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (Uint64 frame = 0; bOk && frame < (Uint64)m_settings.frameCount; ++frame)
+	{
+		// Whole device blocks, like the device asks for them, until the audio catches up
+		// with the end of this frame
+		const Uint64 audioEnd = (frame + 1) * player.getSampleRate() / std::max(m_settings.framesPerSecond, 1);
+		const Uint64 audioStart = SDL_GetPerformanceCounter();
+		while (player.getAudioPosition() < audioEnd && blockBytes > 0)
+		{
+			const Uint64 position = player.getAudioPosition();
+			SDLAudioCallback(&player, audio.data(), (int)blockBytes);
+
+			// The file kernel played the whole block as silence and counted the underrun, the
+			// file has ended or its decoder is stuck or behind. Move over the silence like a
+			// device would instead of calling it again for a position that does not move.
+			if (player.getAudioPosition() == position)
+			{
+				player.incrementAudioPosition(blockFrames);
+				++m_silentBlocks;
+			}
+		}
+		const Uint64 drawStart = SDL_GetPerformanceCounter();
+
+		scope.update(msPerFrame, noEvents);
+		SDL_SetRenderDrawColor(pRenderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+		SDL_RenderClear(pRenderer);
+		scope.draw(pRenderer);
+		SDL_RenderFlush(pRenderer);
+		const Uint64 copyStart = SDL_GetPerformanceCounter();
+
+		PngEncoderPool::Frame* pFrame = m_encoders.acquire();
+		pFrame->width = pSurface->w;
+		pFrame->height = pSurface->h;
+		pFrame->pitch = (int)rowBytes;
+		pFrame->format = FRAME_FORMAT;
+		pFrame->path = framePath(m_settings.prefix, frame);
+		pFrame->pixels.resize(rowBytes * pSurface->h);
+		SDL_LockSurface(pSurface);
+		for (int y = 0; y < pSurface->h; ++y)
+		{
+			memcpy(pFrame->pixels.data() + rowBytes * y, (const Uint8*)pSurface->pixels + (size_t)pSurface->pitch * y, rowBytes);
+		}
+		SDL_UnlockSurface(pSurface);
+		m_encoders.submit(pFrame);
+		const Uint64 copyEnd = SDL_GetPerformanceCounter();
+
+		m_audioTicks += drawStart - audioStart;
+		m_drawTicks += copyStart - drawStart;
+		m_copyTicks += copyEnd - copyStart;
+		++m_frames;
+	}
+	m_encoders.finish();
+	m_totalTicks = SDL_GetPerformanceCounter() - start;
+	bOk = bOk && m_encoders.failedFrames() == 0;
+
+	scope.stop();
+	SDL_DestroyRenderer(pRenderer);
+	SDL_FreeSurface(pSurface);
+	return bOk;
+}
+
+double FrameRecorder::framesPerSecond() const
+{
+	return m_totalTicks > 0 ? (double)m_encoders.encodedFrames() * SDL_GetPerformanceFrequency() / m_totalTicks : 0.0;
+}
+
+void FrameRecorder::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	const double msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+	const double frames = (double)std::max<Uint64>(m_frames, 1);
+	Logger::LOG_MSG(prefix, "FrameRecorder: \n");
+	Logger::LOG_MSG(prefix, "    Frames             : ", m_frames, " of ", m_settings.width, 'x', m_settings.height, " to ", framePath(m_settings.prefix, 0), " ...\n");
+	Logger::LOG_MSG(prefix, "    Audio(per frame)   : ", m_audioTicks * msPerTick / frames, " ms\n");
+	Logger::LOG_MSG(prefix, "    Silent blocks      : ", m_silentBlocks, ", the audio file had no frames ready\n");
+	Logger::LOG_MSG(prefix, "    Draw(per frame)    : ", m_drawTicks * msPerTick / frames, " ms\n");
+	Logger::LOG_MSG(prefix, "    Copy(per frame)    : ", m_copyTicks * msPerTick / frames, " ms, waits for a buffer included\n");
+	Logger::LOG_MSG(prefix, "    Pipeline           : ", m_totalTicks * msPerTick, " ms, ", framesPerSecond(), " frames/s written\n");
+	m_encoders.print(prefix + "          ");
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <SDL.h>
+#include "constants.h"
+#include "soundWave.h"
+#include "wavFile.h"
+#include "pngEncoderPool.h"
+
+// Renders scope frames to a PNG sequence without a display or an audio device.
+//
+// Oscilloscope::draw() goes through SDL_CreateSoftwareRenderer() into an offscreen surface.
+// The audio callback is driven from here, a frame period of audio per frame at a simulated
+// frame rate, so the traces look like they would live. Every frame is copied into a buffer
+// of a PngEncoderPool and the next one is drawn while the workers encode.
+class FrameRecorder
+{
+public:
+	struct Settings
+	{
+		std::string		prefix;							// Frame n goes to <prefix>000n.png
+		int				frameCount{ 60 };
+		int				framesPerSecond{ 60 };			// Sets how much audio each frame moves on
+		int				encoders{};						// 0 uses one per core but the renderer's
+		int				width{ WINDOW_WIDTH };
+		int				height{ WINDOW_HEIGHT };
+		WaveForm		waveForm{ WAVEFORM };
+		int				frequency{ FREQUENCY };
+		std::string		audioFile;						// Drawn instead of the tone when set
+		PcmLayout		rawLayout;
+	};
+
+	explicit FrameRecorder(const Settings& settings) : m_settings(settings) {}
+
+	// Renders and writes every frame, false when the renderer cannot be set up or a frame
+	// failed to write
+	bool run();
+
+	// Frames written per second, from the first frame drawn to the last one written
+	double framesPerSecond() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	Settings		m_settings;
+	PngEncoderPool	m_encoders;
+	Uint64			m_frames{};
+	Uint64			m_silentBlocks{};		// Audio callbacks that did not move the audio position
+
+	// SDL_GetPerformanceCounter() ticks
+	Uint64			m_audioTicks{};			// Audio callbacks
+	Uint64			m_drawTicks{};			// Oscilloscope::update() and draw()
+	Uint64			m_copyTicks{};			// Into the encoder's buffer, waiting for one included
+	Uint64			m_totalTicks{};
+};
@@ -33,10 +33,16 @@ void IO_Engine::update(uint64_t elapsedTimeInMs)
 
 void IO_Engine::render()
 {
-	SDL_RenderClear(m_pRenderer);
-
-	m_oscilloscope.draw(m_pRenderer);
-
+	{
+		ScopedPhaseTimer timer(m_profiler, FramePhase::GRID);
+		SDL_RenderClear(m_pRenderer);
+		m_oscilloscope.drawGrid(m_pRenderer);
+	}
+	{
+		ScopedPhaseTimer timer(m_profiler, FramePhase::TRACE);
+		m_oscilloscope.drawTraces(m_pRenderer);
+	}
+	ScopedPhaseTimer timer(m_profiler, FramePhase::PRESENT);
 	SDL_RenderPresent(m_pRenderer);
 }
 
@@ -45,7 +51,7 @@ void IO_Engine::print() const
 	using ns_Util::Logger;
 	Logger::LOG_MSG("IO_Engine: \n");
 	Logger::LOG_MSG("    Window Name      : ", m_sWindowName, ", Height = ", m_height, ", Width = ", m_width, '\n');
-	Logger::LOG_MSG("    Refresh Interval : ", m_refreshIntervalInMs, " ms\n");
+	Logger::LOG_MSG("    Frame Rate       : ", m_bVsync ? "Vsync at " : "", m_bVsync ? m_refreshRate : m_framesPerSecond, " fps\n");
 	Logger::LOG_MSG("    SDL Window is    : ", m_pWindow ? "Initialized\n" : "Uninitialized\n");
 	Logger::LOG_MSG("    SDL Rendered is  : ", m_pRenderer ? "Initialized\n" : "Uninitialized\n");
 	m_oscilloscope.print("          ");
@@ -62,13 +68,29 @@ bool IO_Engine::init()
 		return false;
 	}
 
-	m_pRenderer = SDL_CreateRenderer(m_pWindow, -1, SDL_RENDERER_ACCELERATED);
+	m_pRenderer = SDL_CreateRenderer(m_pWindow, -1, SDL_RENDERER_ACCELERATED | (m_bVsync ? SDL_RENDERER_PRESENTVSYNC : 0));
 	if (!m_pRenderer)
 	{
 		ns_Util::Logger::LOG_SDL_ERROR("Failed to create renderer");
 		return false;
 	}
 
+	SDL_DisplayMode mode{};
+	if (SDL_GetWindowDisplayMode(m_pWindow, &mode) == 0)
+	{
+		m_refreshRate = mode.refresh_rate;
+	}
+	if (m_bVsync)
+	{
+		// The driver may not do vsync, the loop paces itself then
+		SDL_RendererInfo info{};
+		if (SDL_GetRendererInfo(m_pRenderer, &info) != 0 || !(info.flags & SDL_RENDERER_PRESENTVSYNC) || m_refreshRate <= 0)
+		{
+			ns_Util::Logger::LOG_ERROR("Vsync is not available, pacing at ", m_framesPerSecond, " fps instead\n");
+			m_bVsync = false;
+		}
+	}
+
 	if (!m_oscilloscope.init())
 	{
 		ns_Util::Logger::LOG_SDL_ERROR("Failed to init Oscilloscope.");
@@ -82,20 +104,31 @@ void IO_Engine::loop()
 	uint64_t lastTimeUpdate = SDL_GetTicks64();
 	uint64_t currTimeUpdate = 0;
 	uint64_t elapsedTime = 0;
+	m_pacer.start(m_bVsync ? m_refreshRate : m_framesPerSecond, m_bVsync);
 	while (m_bRunning)
 	{
 		currTimeUpdate = SDL_GetTicks64();
 		elapsedTime = currTimeUpdate - lastTimeUpdate;
 		lastTimeUpdate = currTimeUpdate;
+		m_profiler.beginFrame();
 
-		handleInput();
-		update(elapsedTime);
-		render();
-
-		if (elapsedTime < m_refreshIntervalInMs)
 		{
-			SDL_Delay(Uint32(m_refreshIntervalInMs - elapsedTime));
+			ScopedPhaseTimer timer(m_profiler, FramePhase::INPUT);
+			handleInput();
+		}
+		{
+			ScopedPhaseTimer timer(m_profiler, FramePhase::UPDATE);
+			update(elapsedTime);
 		}
+		render();
+
+		m_pacer.wait();
+	}
+	m_pacer.print();
+	m_profiler.print();
+	if (!m_frameLogPath.empty())
+	{
+		m_profiler.writeCsv(m_frameLogPath);
 	}
 	stop();
 }
@@ -113,6 +146,12 @@ void IO_Engine::handleInput()
 		}
 		else
 		{
+			if (sdlEvent.type == SDL_KEYDOWN && sdlEvent.key.keysym.scancode == SDL_SCANCODE_F)
+			{
+				m_pacer.print();
+				m_profiler.print();
+				m_profiler.writeCsv(m_frameLogPath.empty() ? "frame_times.csv" : m_frameLogPath);
+			}
 			m_sdlEvents.push_back(sdlEvent);
 		}
 	}
@@ -6,6 +6,8 @@
 #include <vector>
 
 #include "oscilloscope.h"
+#include "frameProfiler.h"
+#include "framePacer.h"
 
 #undef main
 
@@ -20,7 +22,20 @@ public:
 	void render();
 	void stop();
 
+	// Plays the file instead of the generated tone, set before start()
+	INLINE void setAudioFile(const std::string& path, const PcmLayout& rawLayout = PcmLayout{}) { m_oscilloscope.setAudioFile(path, rawLayout); }
+
+	// Where F and exit write the frame times, frame_times.csv for F only when not set
+	INLINE void setFrameLog(const std::string& path) { m_frameLogPath = path; }
+
+	// Frame rate the loop is paced at, or wait for the display's refresh in present instead,
+	// set before start()
+	INLINE void setFrameRate(int framesPerSecond) { m_framesPerSecond = framesPerSecond; }
+	INLINE void setVsync(bool bVsync) { m_bVsync = bVsync; }
+
 	INLINE std::vector<SDL_Event>& getEvents() { return m_sdlEvents; }
+	INLINE const FrameProfiler& getProfiler() const { return m_profiler; }
+	INLINE const FramePacer& getPacer() const { return m_pacer; }
 
 	void print() const;
 private:
@@ -40,10 +55,15 @@ private:
 
 	std::vector<SDL_Event>	m_sdlEvents;
 
-	const int				m_framePerSecond{ 60 };
-	const int				m_refreshIntervalInMs{ 1000 / m_framePerSecond };
+	int						m_framesPerSecond{ 60 };
+	bool					m_bVsync{ false };
+	int						m_refreshRate{};		// Of the window's display, 0 when unknown
 
 	bool					m_bRunning{ false };
 
 	Oscilloscope			m_oscilloscope;
+
+	FrameProfiler			m_profiler;
+	FramePacer				m_pacer;
+	std::string				m_frameLogPath;
 };
\ No newline at end of file
@@ -1,9 +1,39 @@
 #include "ioEngine.h"
+#include "appOptions.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	AppOptions options;
+	if (!options.parse(argc, argv))
+	{
+		AppOptions::printUsage(argv[0]);
+		return options.bShowHelp ? 0 : 1;
+	}
+
+	if (!options.render.path.empty())
+	{
+		OfflineRenderer renderer(options.render);
+		const bool bRendered = renderer.run();
+		renderer.print();
+		return bRendered ? 0 : 1;
+	}
+
+	if (!options.frames.prefix.empty())
+	{
+		options.frames.audioFile = options.audioFile;
+		options.frames.rawLayout = options.rawLayout;
+		FrameRecorder recorder(options.frames);
+		const bool bRecorded = recorder.run();
+		recorder.print();
+		return bRecorded ? 0 : 1;
+	}
+
 	IO_Engine engine(WINDOW_NAME, WINDOW_WIDTH, WINDOW_HEIGHT);
+	engine.setAudioFile(options.audioFile, options.rawLayout);
+	engine.setFrameLog(options.frameLog);
+	engine.setFrameRate(options.framesPerSecond);
+	engine.setVsync(options.bVsync);
 	engine.start();
 
 	return 0;
-}
\ No newline at end of file
+}
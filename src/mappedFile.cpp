@@ -0,0 +1,175 @@
+#include "mappedFile.h"
+#include "logger.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to open ", path, ", error ", GetLastError(), '\n');
+		return false;
+	}
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+	{
+		ns_Util::Logger::LOG_ERROR("Cannot map ", path, ", it is empty or its size is unknown\n");
+		CloseHandle(hFile);
+		return false;
+	}
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!pView)
+	{
+		// A 32 bit build runs out of address space for files of a few GB
+		ns_Util::Logger::LOG_ERROR("Failed to map ", path, ", error ", GetLastError(), '\n');
+		if (hMapping)
+		{
+			CloseHandle(hMapping);
+		}
+		CloseHandle(hFile);
+		return false;
+	}
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_pData = static_cast<const Uint8*>(pView);
+	m_size = (Uint64)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+	if (m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+	if (m_hFile)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = nullptr;
+	}
+	m_size = 0;
+}
+
+Uint64 MappedFile::pageSize()
+{
+	SYSTEM_INFO info{};
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+}
+#else
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to open ", path, '\n');
+		return false;
+	}
+	struct stat info{};
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		ns_Util::Logger::LOG_ERROR("Cannot map ", path, ", it is empty or its size is unknown\n");
+		::close(fd);
+		return false;
+	}
+	void* pView = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (pView == MAP_FAILED)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to map ", path, '\n');
+		::close(fd);
+		return false;
+	}
+	// Read ahead aggressively and drop pages behind the reader early
+	madvise(pView, (size_t)info.st_size, MADV_SEQUENTIAL);
+	m_fd = fd;
+	m_pData = static_cast<const Uint8*>(pView);
+	m_size = (Uint64)info.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_pData)
+	{
+		munmap(const_cast<Uint8*>(m_pData), (size_t)m_size);
+		m_pData = nullptr;
+	}
+	if (m_fd >= 0)
+	{
+		::close(m_fd);
+		m_fd = -1;
+	}
+	m_size = 0;
+}
+
+Uint64 MappedFile::pageSize()
+{
+	return (Uint64)sysconf(_SC_PAGESIZE);
+}
+#endif
+
+void MappedFile::willNeed(Uint64 offset, Uint64 length) const
+{
+	if (!m_pData || offset >= m_size)
+	{
+		return;
+	}
+	// Whole pages, the first one may start before offset
+	const Uint64 page = pageSize();
+	const Uint64 begin = offset / page * page;
+	const Uint64 end = std::min(offset + length, m_size);
+	if (end <= begin)
+	{
+		return;
+	}
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range{ const_cast<Uint8*>(m_pData + (size_t)begin), (SIZE_T)(end - begin) };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise(const_cast<Uint8*>(m_pData + (size_t)begin), (size_t)(end - begin), MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::release(Uint64 offset, Uint64 length) const
+{
+	if (!m_pData || offset >= m_size)
+	{
+		return;
+	}
+	// Only pages that lie completely inside the range, the neighbours may still be in use
+	const Uint64 page = pageSize();
+	const Uint64 begin = (offset + page - 1) / page * page;
+	const Uint64 end = std::min(offset + length, m_size) / page * page;
+	if (end <= begin)
+	{
+		return;
+	}
+#ifdef _WIN32
+	// Unlocking pages that are not locked takes them out of the working set
+	VirtualUnlock(const_cast<Uint8*>(m_pData + (size_t)begin), (SIZE_T)(end - begin));
+#else
+	madvise(const_cast<Uint8*>(m_pData + (size_t)begin), (size_t)(end - begin), MADV_DONTNEED);
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include "constants.h"
+
+// Read only memory mapping of a whole file. Mapping is constant time whatever the file size,
+// pages are read in when first touched. willNeed() and release() steer which part of the
+// file stays resident, so a long sequential read does not grow the process.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	INLINE bool isOpen() const { return m_pData != nullptr; }
+	INLINE const Uint8* data() const { return m_pData; }
+	INLINE Uint64 size() const { return m_size; }
+
+	// Starts reading [offset, offset + length) in ahead of use
+	void willNeed(Uint64 offset, Uint64 length) const;
+
+	// Drops the pages inside [offset, offset + length) from the process, they are read in
+	// again from the file if touched later
+	void release(Uint64 offset, Uint64 length) const;
+
+	static Uint64 pageSize();
+private:
+	const Uint8*	m_pData{};
+	Uint64			m_size{};
+#ifdef _WIN32
+	void*			m_hFile{};
+	void*			m_hMapping{};
+#else
+	int				m_fd{ -1 };
+#endif
+};
@@ -0,0 +1,195 @@
+#include "minMaxDecimator.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace
+{
+template <typename T>
+INLINE void minMaxScalar(const T* p, Uint32 n, T& lo, T& hi)
+{
+	for (Uint32 i = 0; i < n; ++i)
+	{
+		lo = std::min(lo, p[i]);
+		hi = std::max(hi, p[i]);
+	}
+}
+
+#if OSC_X86
+// SSE2 only has unsigned byte and signed word min/max. Signed bytes and unsigned words are
+// moved into the other range by flipping the top bit, which keeps their order, and 32 bit
+// integers compare and blend.
+template <typename T>
+OSC_TARGET_SSE2 INLINE __m128i flipSse2(__m128i v)
+{
+	if constexpr (std::is_same_v<T, Sint8>)
+	{
+		return _mm_xor_si128(v, _mm_set1_epi8((char)0x80));
+	}
+	else if constexpr (std::is_same_v<T, Uint16>)
+	{
+		return _mm_xor_si128(v, _mm_set1_epi16((short)0x8000));
+	}
+	else
+	{
+		return v;
+	}
+}
+
+template <typename T>
+OSC_TARGET_SSE2 INLINE __m128i minSse2(__m128i a, __m128i b)
+{
+	if constexpr (sizeof(T) == 1)
+	{
+		return _mm_min_epu8(a, b);
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		return _mm_min_epi16(a, b);
+	}
+	else
+	{
+		const __m128i aGreater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(aGreater, b), _mm_andnot_si128(aGreater, a));
+	}
+}
+
+template <typename T>
+OSC_TARGET_SSE2 INLINE __m128i maxSse2(__m128i a, __m128i b)
+{
+	if constexpr (sizeof(T) == 1)
+	{
+		return _mm_max_epu8(a, b);
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		return _mm_max_epi16(a, b);
+	}
+	else
+	{
+		const __m128i aGreater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(aGreater, a), _mm_andnot_si128(aGreater, b));
+	}
+}
+
+template <typename T>
+OSC_TARGET_SSE2 void minMaxSse2(const T* p, Uint32 n, T& lo, T& hi)
+{
+	constexpr Uint32 LANES = 16 / sizeof(T);
+	if (n < LANES)
+	{
+		minMaxScalar(p, n, lo, hi);
+		return;
+	}
+
+	alignas(16) T lanesLo[LANES];
+	alignas(16) T lanesHi[LANES];
+	Uint32 i = LANES;
+	if constexpr (std::is_same_v<T, float>)
+	{
+		__m128 vLo = _mm_loadu_ps(p);
+		__m128 vHi = vLo;
+		for (; i + LANES <= n; i += LANES)
+		{
+			const __m128 v = _mm_loadu_ps(p + i);
+			vLo = _mm_min_ps(vLo, v);
+			vHi = _mm_max_ps(vHi, v);
+		}
+		_mm_store_ps(lanesLo, vLo);
+		_mm_store_ps(lanesHi, vHi);
+	}
+	else
+	{
+		__m128i vLo = flipSse2<T>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		__m128i vHi = vLo;
+		for (; i + LANES <= n; i += LANES)
+		{
+			const __m128i v = flipSse2<T>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+			vLo = minSse2<T>(vLo, v);
+			vHi = maxSse2<T>(vHi, v);
+		}
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanesLo), flipSse2<T>(vLo));
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanesHi), flipSse2<T>(vHi));
+	}
+
+	for (Uint32 l = 0; l < LANES; ++l)
+	{
+		lo = std::min(lo, lanesLo[l]);
+		hi = std::max(hi, lanesHi[l]);
+	}
+	minMaxScalar(p + i, n - i, lo, hi);
+}
+#endif // OSC_X86
+
+template <typename T>
+void decimate(const T* pSamples, Uint32 count, MinMaxColumn* pColumns, Uint32 columns, bool bSse2)
+{
+	Uint32 begin = 0;
+	for (Uint32 c = 0; c < columns; ++c)
+	{
+		const Uint32 next = (Uint32)(((Uint64)(c + 1) * count) / columns);
+		const Uint32 end = std::max(next, std::min(begin + 1, count));
+
+		T lo = pSamples[begin];
+		T hi = lo;
+#if OSC_X86
+		if (bSse2)
+		{
+			minMaxSse2(pSamples + begin, end - begin, lo, hi);
+		}
+		else
+#endif
+		{
+			(void)bSse2;
+			minMaxScalar(pSamples + begin, end - begin, lo, hi);
+		}
+		pColumns[c].min = static_cast<float>(lo);
+		pColumns[c].max = static_cast<float>(hi);
+
+		// With fewer samples than columns a sample is repeated, it is never skipped
+		begin = std::max(begin, next);
+	}
+}
+}
+
+bool decimateMinMax(const void* pSamples, SDL_AudioFormat format, Uint32 count,
+	MinMaxColumn* pColumns, Uint32 columns, SimdLevel level)
+{
+	if (count == 0 || columns == 0)
+	{
+		return true;
+	}
+
+	const bool bSse2 = OSC_X86 && level >= SimdLevel::SSE2;
+	switch (format)
+	{
+		case AUDIO_S8:
+			decimate(static_cast<const Sint8*>(pSamples), count, pColumns, columns, bSse2);
+			break;
+
+		case AUDIO_U8:
+			decimate(static_cast<const Uint8*>(pSamples), count, pColumns, columns, bSse2);
+			break;
+
+		case AUDIO_S16:
+			decimate(static_cast<const Sint16*>(pSamples), count, pColumns, columns, bSse2);
+			break;
+
+		case AUDIO_U16:
+			decimate(static_cast<const Uint16*>(pSamples), count, pColumns, columns, bSse2);
+			break;
+
+		case AUDIO_S32:
+			decimate(static_cast<const Sint32*>(pSamples), count, pColumns, columns, bSse2);
+			break;
+
+		case AUDIO_F32:
+			decimate(static_cast<const float*>(pSamples), count, pColumns, columns, bSse2);
+			break;
+
+		default:
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <SDL_audio.h>
+#include "constants.h"
+#include "waveKernels.h"
+
+// Lowest and highest sample that fell into one pixel column
+struct MinMaxColumn
+{
+	float	min{};
+	float	max{};
+};
+
+// Reduces count samples in the given format to columns min/max pairs. Column c covers
+// samples [c * count / columns, (c + 1) * count / columns), at least one sample, so every
+// sample is in a column and a one sample glitch still shows up. Returns false for a
+// format the player does not support.
+extern bool decimateMinMax(const void* pSamples, SDL_AudioFormat format, Uint32 count,
+	MinMaxColumn* pColumns, Uint32 columns, SimdLevel level = detectSimdLevel());
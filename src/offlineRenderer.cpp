@@ -0,0 +1,124 @@
+#include "offlineRenderer.h"
+#include "SoundWavePlayer.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Peak the kernels convert sin * gain + offset to, the player's display height is twice the
+// offset so unsigned formats are centred. S32 stays below 2^31, the kernels go through float.
+float fullScale(SDL_AudioFormat format)
+{
+	switch (format)
+	{
+		case AUDIO_S8:
+		case AUDIO_U8:	return 127.0f;
+		case AUDIO_S16:
+		case AUDIO_U16:	return 32767.0f;
+		case AUDIO_S32:	return 2147483520.0f;
+		default:		return 1.0f;
+	}
+}
+
+int midScale(SDL_AudioFormat format)
+{
+	switch (format)
+	{
+		case AUDIO_U8:	return 0x80;
+		case AUDIO_U16:	return 0x8000;
+		default:		return 0;
+	}
+}
+
+INLINE double ticksToSeconds(Uint64 ticks)
+{
+	return (double)ticks / SDL_GetPerformanceFrequency();
+}
+}
+
+bool OfflineRenderer::run()
+{
+	const PcmLayout& layout = m_settings.layout;
+	const int channels = layout.channels;
+	if (!layout.valid() || !(channels == MONO || channels == STEREO || channels == QUAD || channels == HEXA))
+	{
+		ns_Util::Logger::LOG_ERROR("Cannot render ", layout.toString(), ", the player generates 1, 2, 4 or 6 channels\n");
+		return false;
+	}
+
+	// The amplitude is an int, the level goes in as the volume so S32 full scale fits
+	SoundWavePlayer player(m_settings.frequency, 1, PHASE, m_settings.waveForm,
+		layout.sampleRate, layout.format, (Uint8)channels, m_settings.blockFrames, SDLAudioCallback,
+		WINDOW_WIDTH, 2 * midScale(layout.format));
+	player.setVolume(std::clamp(m_settings.level, 0.0f, 1.0f) * fullScale(layout.format));
+
+	SDL_AudioSpec spec;
+	SDL_zero(spec);
+	spec.freq = layout.sampleRate;
+	spec.format = layout.format;
+	spec.channels = (Uint8)channels;
+	spec.samples = m_settings.blockFrames;
+	if (!player.initOffline(spec))
+	{
+		return false;
+	}
+
+	PcmWriter writer;
+	if (!writer.open(m_settings.path, layout))
+	{
+		return false;
+	}
+
+	// The callback renders in device format, S32 for a packed 24 bit file
+	const Uint32 frameBytes = SDL_AUDIO_BITSIZE(layout.format) / 8 * channels;
+	std::vector<Uint8> block((size_t)m_settings.blockFrames * frameBytes);
+	const Uint64 total = (Uint64)std::llround(std::max(m_settings.seconds, 0.0) * layout.sampleRate);
+	m_frames = m_renderTicks = m_writeTicks = 0;
+
+	while (m_frames < total)
+	{
+		const Uint32 frames = (Uint32)std::min<Uint64>(m_settings.blockFrames, total - m_frames);
+		const Uint64 start = SDL_GetPerformanceCounter();
+		SDLAudioCallback(&player, block.data(), (int)(frames * frameBytes));
+		const Uint64 rendered = SDL_GetPerformanceCounter();
+		if (!writer.write(block.data(), frames))
+		{
+			writer.close();
+			return false;
+		}
+		m_renderTicks += rendered - start;
+		m_writeTicks += SDL_GetPerformanceCounter() - rendered;
+		m_frames += frames;
+	}
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const bool bClosed = writer.close();
+	m_writeTicks += SDL_GetPerformanceCounter() - start;
+	m_bytes = writer.bytesWritten();
+	return bClosed;
+}
+
+double OfflineRenderer::samplesPerSecond() const
+{
+	return m_renderTicks > 0 ? (double)m_frames * m_settings.layout.channels / ticksToSeconds(m_renderTicks) : 0.0;
+}
+
+void OfflineRenderer::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	const double renderSeconds = ticksToSeconds(m_renderTicks);
+	const double writeSeconds = ticksToSeconds(m_writeTicks);
+	const double audioSeconds = m_settings.layout.sampleRate > 0 ? (double)m_frames / m_settings.layout.sampleRate : 0.0;
+	Logger::LOG_MSG(prefix, "OfflineRenderer: \n");
+	Logger::LOG_MSG(prefix, "    File               : ", m_settings.path, ", ", m_settings.layout.toString(), '\n');
+	Logger::LOG_MSG(prefix, "    Tone               : ", waveForm2String(m_settings.waveForm), " at ", m_settings.frequency, " Hz, level ", m_settings.level, '\n');
+	Logger::LOG_MSG(prefix, "    Rendered           : ", m_frames, " frames, ", audioSeconds, " s, ", m_bytes, " bytes\n");
+	Logger::LOG_MSG(prefix, "    Generate           : ", renderSeconds, " s, ", samplesPerSecond(), " samples/s, ",
+		renderSeconds > 0 ? audioSeconds / renderSeconds : 0.0, "x realtime\n");
+	Logger::LOG_MSG(prefix, "    Write              : ", writeSeconds, " s, ", writeSeconds > 0 ? m_bytes / writeSeconds / (1 << 20) : 0.0, " MB/s\n");
+	Logger::LOG_MSG(prefix, "    Total              : ", renderSeconds + writeSeconds, " s, ",
+		renderSeconds + writeSeconds > 0 ? audioSeconds / (renderSeconds + writeSeconds) : 0.0, "x realtime\n");
+}
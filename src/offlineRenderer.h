@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <SDL.h>
+#include "constants.h"
+#include "soundWave.h"
+#include "wavFile.h"
+
+// Renders the generated tone to a file as fast as the CPU allows, without a window or an
+// audio device. A SoundWavePlayer set up by initOffline() is driven through the same
+// callback and kernels the device would call, a block at a time, and every block goes
+// straight to a PcmWriter.
+class OfflineRenderer
+{
+public:
+	struct Settings
+	{
+		std::string		path;						// .wav, .raw or .pcm
+		PcmLayout		layout;						// S24 renders as S32 and is packed on write
+		double			seconds{ 10.0 };
+		WaveForm		waveForm{ WAVEFORM };
+		int				frequency{ FREQUENCY };
+		float			level{ 0.5f };				// Peak, as a fraction of full scale
+		Uint16			blockFrames{ 4096 };		// Frames per callback
+	};
+
+	explicit OfflineRenderer(const Settings& settings) : m_settings(settings) {}
+
+	// Renders the whole file, false when the layout is not one the player generates or the
+	// file cannot be written
+	bool run();
+
+	INLINE Uint64 framesRendered() const { return m_frames; }
+
+	// Generated samples, every channel counted, per second of callback time
+	double samplesPerSecond() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	Settings		m_settings;
+	Uint64			m_frames{};
+	Uint64			m_bytes{};
+	Uint64			m_renderTicks{};		// SDL_GetPerformanceCounter() ticks in the callback
+	Uint64			m_writeTicks{};			// and in PcmWriter
+};
@@ -0,0 +1,1462 @@
+#include "oggVorbis.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+constexpr Uint8 PAGE_CONTINUED = 0x01;
+constexpr Uint8 PAGE_END_OF_STREAM = 0x04;
+constexpr size_t PAGE_HEADER_BYTES = 27;
+constexpr long LENGTH_SCAN_BYTES = 1 << 16;		// Pages are at most 65307 bytes, the last one starts in here
+
+constexpr double PI = 3.14159265358979323846;
+
+INLINE Uint32 readLE32(const Uint8* p) { return (Uint32)p[0] | (Uint32)p[1] << 8 | (Uint32)p[2] << 16 | (Uint32)p[3] << 24; }
+INLINE Uint64 readLE64(const Uint8* p) { return (Uint64)readLE32(p) | (Uint64)readLE32(p + 4) << 32; }
+
+// Bits needed for x, 0 for 0
+INLINE int ilog(Uint32 x)
+{
+	int bits = 0;
+	for (; x != 0; x >>= 1)
+	{
+		++bits;
+	}
+	return bits;
+}
+
+INLINE Uint32 bitReverse(Uint32 x)
+{
+	x = ((x & 0xAAAAAAAAu) >> 1) | ((x & 0x55555555u) << 1);
+	x = ((x & 0xCCCCCCCCu) >> 2) | ((x & 0x33333333u) << 2);
+	x = ((x & 0xF0F0F0F0u) >> 4) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x & 0xFF00FF00u) >> 8) | ((x & 0x00FF00FFu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+// The 32 bit float format of codebook lookup tables
+INLINE float unpackFloat(Uint32 x)
+{
+	const int mantissa = (int)(x & 0x1FFFFF);
+	const int exponent = (int)((x & 0x7FE00000) >> 21);
+	return (float)std::ldexp((x & 0x80000000) ? -mantissa : mantissa, exponent - 788);
+}
+
+// Largest r with r^dimensions <= entries, the values per dimension of a type 1 lookup table
+int lookup1Values(int entries, int dimensions)
+{
+	int r = (int)std::floor(std::pow((double)entries, 1.0 / dimensions));
+	const auto fits = [&](int v)
+	{
+		double p = 1.0;
+		for (int i = 0; i < dimensions; ++i)
+		{
+			p *= v;
+		}
+		return p <= entries;
+	};
+	while (fits(r + 1))
+	{
+		++r;
+	}
+	while (r > 0 && !fits(r))
+	{
+		--r;
+	}
+	return r;
+}
+
+// Floor 1 amplitude of x on the line through (x0, y0) and (x1, y1)
+INLINE int renderPoint(int x0, int y0, int x1, int y1, int x)
+{
+	const int dy = y1 - y0;
+	const int offset = std::abs(dy) * (x - x0) / (x1 - x0);
+	return dy < 0 ? y0 - offset : y0 + offset;
+}
+
+// Floor 1 amplitudes in steps of about 0.55 dB, from -140 dB to 0 dB
+struct InverseDbTable
+{
+	float	values[256];
+
+	InverseDbTable()
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			values[i] = (float)std::pow(1.0649863e-07, (255 - i) / 255.0);
+		}
+	}
+};
+const InverseDbTable s_inverseDb;
+
+// Multiplies pVector[x0, min(x1, limit)) by the floor 1 line from (x0, y0) to (x1, y1), drawn
+// with the integer steps the specification gives
+void renderLine(int x0, int y0, int x1, int y1, float* pVector, int limit)
+{
+	const int dy = y1 - y0;
+	const int adx = x1 - x0;
+	if (adx <= 0)
+	{
+		return;
+	}
+	const int base = dy / adx;
+	const int sy = dy < 0 ? base - 1 : base + 1;
+	const int ady = std::abs(dy) - std::abs(base) * adx;
+	const int end = std::min(x1, limit);
+	int y = y0;
+	int err = 0;
+	if (x0 < limit)
+	{
+		pVector[x0] *= s_inverseDb.values[std::clamp(y, 0, 255)];
+	}
+	for (int x = x0 + 1; x < end; ++x)
+	{
+		err += ady;
+		if (err >= adx)
+		{
+			err -= adx;
+			y += sy;
+		}
+		else
+		{
+			y += base;
+		}
+		pVector[x] *= s_inverseDb.values[std::clamp(y, 0, 255)];
+	}
+}
+}
+
+// Bits of one packet, least significant bit of each byte first. Reads past the end give 0
+// and set eop().
+class OggVorbisFile::BitReader
+{
+public:
+	BitReader(const Uint8* p, size_t bytes) : m_p(p), m_bytes(bytes) {}
+
+	// Up to 24 bits without consuming them
+	INLINE Uint32 peek(int count) const
+	{
+		const size_t byte = m_pos >> 3;
+		Uint32 v = 0;
+		for (size_t i = 0; i < 4 && byte + i < m_bytes; ++i)
+		{
+			v |= (Uint32)m_p[byte + i] << (8 * i);
+		}
+		return (v >> (m_pos & 7)) & ((1u << count) - 1);
+	}
+
+	INLINE void skip(int count) { m_pos += count; }
+
+	// Up to 32 bits
+	INLINE Uint32 read(int count)
+	{
+		if (count > 24)
+		{
+			const Uint32 low = read(16);
+			return low | read(count - 16) << 16;
+		}
+		const Uint32 v = peek(count);
+		skip(count);
+		return eop() ? 0 : v;
+	}
+
+	INLINE bool eop() const { return m_pos > m_bytes * 8; }
+private:
+	const Uint8*	m_p{};
+	size_t			m_bytes{};
+	size_t			m_pos{};
+};
+
+int OggVorbisFile::Codebook::decode(BitReader& reader) const
+{
+	const Uint32 bits = reader.peek(FAST_BITS);
+	const int entry = fastEntry[bits];
+	if (entry >= 0)
+	{
+		reader.skip(fastLength[bits]);
+		return reader.eop() ? -1 : entry;
+	}
+
+	// Longer codewords walk the tree a bit at a time
+	Sint32 node = 0;
+	for (int depth = 0; depth < 32; ++depth)
+	{
+		const Sint32 child = tree[(size_t)node * 2 + reader.read(1)];
+		if (reader.eop() || child == 0)
+		{
+			return -1;
+		}
+		if (child < 0)
+		{
+			return ~child;
+		}
+		node = child;
+	}
+	return -1;
+}
+
+bool OggVorbisFile::open(const std::string& path)
+{
+	close();
+	m_pFile = std::fopen(path.c_str(), "rb");
+	if (!m_pFile)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to open ", path, '\n');
+		return false;
+	}
+	m_path = path;
+
+	// The first page starts the stream, pages of other streams multiplexed with it are skipped
+	Uint8 header[PAGE_HEADER_BYTES];
+	if (std::fread(header, 1, sizeof(header), m_pFile) != sizeof(header) || memcmp(header, "OggS", 4) != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(path, " is not an Ogg file\n");
+		close();
+		return false;
+	}
+	m_serial = readLE32(header + 14);
+	if (!seekTo(0, 0, 0) || !readIdentification() || !readSetup())
+	{
+		close();
+		return false;
+	}
+
+	// Audio starts with the packet after the setup header
+	m_audioPage = m_pageOffset;
+	m_audioSegment = m_segment;
+	m_audioBodyPos = m_bodyPos;
+	readLength();
+	if (!rewind())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void OggVorbisFile::close()
+{
+	if (m_pFile)
+	{
+		std::fclose(m_pFile);
+		m_pFile = nullptr;
+	}
+	m_channels = m_sampleRate = 0;
+	m_lengthInFrames = 0;
+	m_codebooks.clear();
+	m_floors.clear();
+	m_residues.clear();
+	m_mappings.clear();
+	m_modes.clear();
+	m_out.clear();
+	m_outPos = 0;
+	m_corruptPackets = 0;
+}
+
+Uint32 OggVorbisFile::read(float* pFrames, Uint32 frames)
+{
+	if (!m_pFile || m_channels == 0)
+	{
+		return 0;
+	}
+	Uint32 done = 0;
+	while (done < frames)
+	{
+		const size_t available = m_out.size() / m_channels - m_outPos;
+		if (available == 0)
+		{
+			m_out.clear();
+			m_outPos = 0;
+			if (!decodeMore())
+			{
+				break;
+			}
+			continue;
+		}
+		const Uint32 count = (Uint32)std::min<size_t>(frames - done, available);
+		memcpy(pFrames + (size_t)done * m_channels, m_out.data() + m_outPos * m_channels, (size_t)count * m_channels * sizeof(float));
+		m_outPos += count;
+		done += count;
+	}
+	return done;
+}
+
+bool OggVorbisFile::rewind()
+{
+	if (!m_pFile || !seekTo(m_audioPage, m_audioSegment, m_audioBodyPos))
+	{
+		return false;
+	}
+	m_previousN = 0;
+	m_bPositionKnown = false;
+	m_bEndOfStream = false;
+	m_position = 0;
+	m_out.clear();
+	m_outPos = 0;
+	return true;
+}
+
+bool OggVorbisFile::readPage()
+{
+	for (;;)
+	{
+		const long offset = std::ftell(m_pFile);
+		Uint8 header[PAGE_HEADER_BYTES];
+		if (std::fread(header, 1, sizeof(header), m_pFile) != sizeof(header))
+		{
+			return false;
+		}
+		if (memcmp(header, "OggS", 4) != 0)
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a broken Ogg page at byte ", offset, '\n');
+			return false;
+		}
+		const int segmentCount = header[26];
+		if (std::fread(m_segments, 1, segmentCount, m_pFile) != (size_t)segmentCount)
+		{
+			return false;
+		}
+		size_t bodyBytes = 0;
+		for (int i = 0; i < segmentCount; ++i)
+		{
+			bodyBytes += m_segments[i];
+		}
+		m_body.resize(bodyBytes);
+		if (std::fread(m_body.data(), 1, bodyBytes, m_pFile) != bodyBytes)
+		{
+			return false;
+		}
+		if (readLE32(header + 14) != m_serial)
+		{
+			continue;
+		}
+
+		m_pageOffset = offset;
+		m_pageFlags = header[5];
+		m_pageGranule = (Sint64)readLE64(header + 6);
+		m_segmentCount = segmentCount;
+		m_segment = 0;
+		m_bodyPos = 0;
+		m_lastCompleted = -1;
+		for (int i = 0; i < segmentCount; ++i)
+		{
+			if (m_segments[i] < 255)
+			{
+				m_lastCompleted = i;
+			}
+		}
+		return true;
+	}
+}
+
+bool OggVorbisFile::nextPacket(Sint64& granule, bool& bEndOfStream)
+{
+	m_packet.clear();
+	bool bPartial = false;
+	for (;;)
+	{
+		if (m_segment >= m_segmentCount)
+		{
+			if ((m_pageFlags & PAGE_END_OF_STREAM) || !readPage())
+			{
+				return false;
+			}
+			const bool bContinued = (m_pageFlags & PAGE_CONTINUED) != 0;
+			if (bPartial && !bContinued)
+			{
+				// The pages that held the rest of the packet are gone
+				m_packet.clear();
+				bPartial = false;
+			}
+			if (!bContinued)
+			{
+				m_bSkipContinued = false;
+			}
+			else if (!bPartial)
+			{
+				m_bSkipContinued = true;
+			}
+			continue;
+		}
+
+		const Uint8 size = m_segments[m_segment];
+		m_packet.insert(m_packet.end(), m_body.begin() + m_bodyPos, m_body.begin() + m_bodyPos + size);
+		m_bodyPos += size;
+		const int segment = m_segment++;
+		if (size == 255)
+		{
+			bPartial = true;
+			continue;
+		}
+		if (m_bSkipContinued)
+		{
+			m_bSkipContinued = false;
+			m_packet.clear();
+			bPartial = false;
+			continue;
+		}
+		granule = segment == m_lastCompleted ? m_pageGranule : -1;
+		bEndOfStream = granule != -1 && (m_pageFlags & PAGE_END_OF_STREAM) != 0;
+		return true;
+	}
+}
+
+bool OggVorbisFile::seekTo(long pageOffset, int segment, size_t bodyPos)
+{
+	if (std::fseek(m_pFile, pageOffset, SEEK_SET) != 0 || !readPage())
+	{
+		return false;
+	}
+	m_segment = segment;
+	m_bodyPos = bodyPos;
+	m_bSkipContinued = segment == 0 && (m_pageFlags & PAGE_CONTINUED) != 0;
+	return true;
+}
+
+void OggVorbisFile::readLength()
+{
+	// Granule position of the last page of the stream
+	m_lengthInFrames = 0;
+	const long resume = std::ftell(m_pFile);
+	if (std::fseek(m_pFile, 0, SEEK_END) != 0)
+	{
+		return;
+	}
+	const long size = std::ftell(m_pFile);
+	const long start = std::max(0L, size - LENGTH_SCAN_BYTES);
+	std::vector<Uint8> tail((size_t)(size - start));
+	if (std::fseek(m_pFile, start, SEEK_SET) == 0 && std::fread(tail.data(), 1, tail.size(), m_pFile) == tail.size())
+	{
+		for (size_t i = tail.size() >= PAGE_HEADER_BYTES ? tail.size() - PAGE_HEADER_BYTES + 1 : 0; i-- > 0; )
+		{
+			const Uint8* p = tail.data() + i;
+			const Sint64 granule = (Sint64)readLE64(p + 6);
+			if (memcmp(p, "OggS", 4) == 0 && readLE32(p + 14) == m_serial && granule > 0)
+			{
+				m_lengthInFrames = (Uint64)granule;
+				break;
+			}
+		}
+	}
+	std::fseek(m_pFile, resume, SEEK_SET);
+}
+
+bool OggVorbisFile::readIdentification()
+{
+	Sint64 granule = 0;
+	bool bEnd = false;
+	if (!nextPacket(granule, bEnd) || m_packet.size() < 30 || m_packet[0] != 1 || memcmp(m_packet.data() + 1, "vorbis", 6) != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " is not an Ogg Vorbis file\n");
+		return false;
+	}
+	BitReader reader(m_packet.data() + 7, m_packet.size() - 7);
+	const Uint32 version = reader.read(32);
+	m_channels = (int)reader.read(8);
+	m_sampleRate = (int)reader.read(32);
+	reader.read(32);		// Bitrates
+	reader.read(32);
+	reader.read(32);
+	const int shortBits = (int)reader.read(4);
+	const int longBits = (int)reader.read(4);
+	const bool bFraming = reader.read(1) != 0;
+	if (version != 0 || m_channels == 0 || m_sampleRate <= 0 || shortBits < 6 || longBits > 13 || shortBits > longBits || !bFraming)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis identification header\n");
+		return false;
+	}
+	m_blockSize[0] = 1 << shortBits;
+	m_blockSize[1] = 1 << longBits;
+
+	// The comment header carries nothing the decoder needs
+	if (!nextPacket(granule, bEnd) || m_packet.empty() || m_packet[0] != 3)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has no Vorbis comment header\n");
+		return false;
+	}
+	return true;
+}
+
+bool OggVorbisFile::readSetup()
+{
+	Sint64 granule = 0;
+	bool bEnd = false;
+	if (!nextPacket(granule, bEnd) || m_packet.size() < 7 || m_packet[0] != 5 || memcmp(m_packet.data() + 1, "vorbis", 6) != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has no Vorbis setup header\n");
+		return false;
+	}
+	BitReader reader(m_packet.data() + 7, m_packet.size() - 7);
+
+	m_codebooks.resize(reader.read(8) + 1);
+	for (Codebook& book : m_codebooks)
+	{
+		if (!readCodebook(reader, book))
+		{
+			return false;
+		}
+	}
+
+	// Time domain transforms are placeholders, always 0
+	for (int i = 0, count = (int)reader.read(6) + 1; i < count; ++i)
+	{
+		if (reader.read(16) != 0)
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis setup header\n");
+			return false;
+		}
+	}
+
+	m_floors.resize(reader.read(6) + 1);
+	for (Floor& floor : m_floors)
+	{
+		if (!readFloor(reader, floor))
+		{
+			return false;
+		}
+	}
+	m_residues.resize(reader.read(6) + 1);
+	for (Residue& residue : m_residues)
+	{
+		if (!readResidue(reader, residue))
+		{
+			return false;
+		}
+	}
+	m_mappings.resize(reader.read(6) + 1);
+	for (Mapping& mapping : m_mappings)
+	{
+		if (!readMapping(reader, mapping))
+		{
+			return false;
+		}
+	}
+	m_modes.resize(reader.read(6) + 1);
+	for (Mode& mode : m_modes)
+	{
+		mode.bLong = reader.read(1) != 0;
+		const Uint32 windowType = reader.read(16);
+		const Uint32 transformType = reader.read(16);
+		mode.mapping = (int)reader.read(8);
+		if (windowType != 0 || transformType != 0 || mode.mapping >= (int)m_mappings.size())
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis mode\n");
+			return false;
+		}
+	}
+	if (reader.read(1) != 1 || reader.eop())
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a truncated Vorbis setup header\n");
+		return false;
+	}
+
+	makeTransform(m_blockSize[0], m_transforms[0]);
+	makeTransform(m_blockSize[1], m_transforms[1]);
+	const size_t half = (size_t)m_blockSize[1] / 2;
+	m_vectors.assign(m_channels, std::vector<float>(half));
+	m_overlap.assign(m_channels, std::vector<float>(half));
+	m_floorY.assign(m_channels, std::vector<int>(MAX_FLOOR_VALUES));
+	m_vectorPointers.resize(m_channels);
+	m_bFloorUsed.resize(m_channels);
+	m_bDecode.resize(m_channels);
+	m_interleaved.resize(half * m_channels);
+	m_fftRe.resize(half / 2);
+	m_fftIm.resize(half / 2);
+	m_dct.resize(half);
+	m_pcm.resize((size_t)m_blockSize[1]);
+	return true;
+}
+
+bool OggVorbisFile::readCodebook(BitReader& reader, Codebook& book)
+{
+	if (reader.read(24) != 0x564342)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis codebook\n");
+		return false;
+	}
+	book.dimensions = (int)reader.read(16);
+	book.entries = (int)reader.read(24);
+	book.lengths.assign(book.entries, 0);
+	if (reader.read(1) == 0)
+	{
+		const bool bSparse = reader.read(1) != 0;
+		for (Uint8& length : book.lengths)
+		{
+			if (!bSparse || reader.read(1) != 0)
+			{
+				length = (Uint8)(reader.read(5) + 1);
+			}
+		}
+	}
+	else
+	{
+		// Ordered, runs of entries with lengths counting up
+		int length = (int)reader.read(5) + 1;
+		for (int entry = 0; entry < book.entries; ++length)
+		{
+			const int run = (int)reader.read(ilog((Uint32)(book.entries - entry)));
+			if (length > 32 || entry + run > book.entries)
+			{
+				ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis codebook\n");
+				return false;
+			}
+			std::fill(book.lengths.begin() + entry, book.lengths.begin() + entry + run, (Uint8)length);
+			entry += run;
+		}
+	}
+
+	const Uint32 lookupType = reader.read(4);
+	if ((lookupType == 1 || lookupType == 2) && book.dimensions == 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis codebook\n");
+		return false;
+	}
+	if (lookupType == 1 || lookupType == 2)
+	{
+		const float minimum = unpackFloat(reader.read(32));
+		const float delta = unpackFloat(reader.read(32));
+		const int valueBits = (int)reader.read(4) + 1;
+		const bool bSequence = reader.read(1) != 0;
+		const int lookupValues = lookupType == 1 ? lookup1Values(book.entries, book.dimensions) : book.entries * book.dimensions;
+		std::vector<Uint32> multiplicands(lookupValues);
+		for (Uint32& m : multiplicands)
+		{
+			m = reader.read(valueBits);
+		}
+		if (reader.eop())
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a truncated Vorbis codebook\n");
+			return false;
+		}
+
+		// Every entry's vector up front, decoding only copies them
+		book.values.resize((size_t)book.entries * book.dimensions);
+		for (int entry = 0; entry < book.entries; ++entry)
+		{
+			float last = 0.0f;
+			Uint32 divisor = 1;
+			for (int i = 0; i < book.dimensions; ++i)
+			{
+				const Uint32 offset = lookupType == 1 ? (entry / divisor) % lookupValues : (Uint32)(entry * book.dimensions + i);
+				const float value = multiplicands[offset] * delta + minimum + last;
+				book.values[(size_t)entry * book.dimensions + i] = value;
+				if (bSequence)
+				{
+					last = value;
+				}
+				divisor *= lookupValues;
+			}
+		}
+	}
+	else if (lookupType != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a Vorbis codebook of unknown lookup type ", lookupType, '\n');
+		return false;
+	}
+	if (reader.eop())
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a truncated Vorbis codebook\n");
+		return false;
+	}
+
+	// Codewords go to the entries in order, each taking the lowest free one of its length
+	std::vector<Uint32> codes(book.entries);
+	Uint32 available[33] = {};
+	int used = 0;
+	for (int entry = 0; entry < book.entries; ++entry)
+	{
+		const int length = book.lengths[entry];
+		if (length == 0)
+		{
+			continue;
+		}
+		if (used++ == 0)
+		{
+			codes[entry] = 0;
+			for (int i = 1; i <= length; ++i)
+			{
+				available[i] = 1u << (32 - i);
+			}
+			continue;
+		}
+		int z = length;
+		while (z > 0 && available[z] == 0)
+		{
+			--z;
+		}
+		if (z == 0)
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has an overfull Vorbis codebook\n");
+			return false;
+		}
+		const Uint32 code = available[z];
+		available[z] = 0;
+		codes[entry] = bitReverse(code);
+		for (int y = length; y > z; --y)
+		{
+			available[y] = code + (1u << (32 - y));
+		}
+	}
+
+	// The stream holds codewords first bit first, which bitReverse() turned into low bits first
+	book.fastEntry.assign((size_t)1 << FAST_BITS, -1);
+	book.fastLength.assign((size_t)1 << FAST_BITS, 0);
+	book.tree.assign(2, 0);
+	for (int entry = 0; entry < book.entries; ++entry)
+	{
+		const int length = book.lengths[entry];
+		if (length == 0)
+		{
+			continue;
+		}
+		if (used == 1)
+		{
+			// A lone entry takes every codeword of its length
+			std::fill(book.fastEntry.begin(), book.fastEntry.end(), (Sint32)entry);
+			std::fill(book.fastLength.begin(), book.fastLength.end(), (Uint8)length);
+			break;
+		}
+		if (length <= FAST_BITS)
+		{
+			for (Uint32 i = codes[entry]; i < (1u << FAST_BITS); i += 1u << length)
+			{
+				book.fastEntry[i] = (Sint32)entry;
+				book.fastLength[i] = (Uint8)length;
+			}
+			continue;
+		}
+		Sint32 node = 0;
+		for (int bit = 0; bit < length; ++bit)
+		{
+			Sint32& child = book.tree[(size_t)node * 2 + ((codes[entry] >> bit) & 1)];
+			if (bit == length - 1)
+			{
+				child = ~entry;
+			}
+			else
+			{
+				if (child == 0)
+				{
+					child = (Sint32)(book.tree.size() / 2);
+					book.tree.resize(book.tree.size() + 2, 0);
+				}
+				else if (child < 0)
+				{
+					ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis codebook\n");
+					return false;
+				}
+				node = book.tree[(size_t)node * 2 + ((codes[entry] >> bit) & 1)];
+			}
+		}
+	}
+	return true;
+}
+
+bool OggVorbisFile::readFloor(BitReader& reader, Floor& floor)
+{
+	const Uint32 type = reader.read(16);
+	if (type != 1)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " uses Vorbis floor type ", type, ", only floor 1 is supported\n");
+		return false;
+	}
+	floor.partitions = (int)reader.read(5);
+	int classes = 0;
+	for (int i = 0; i < floor.partitions; ++i)
+	{
+		floor.partitionClass[i] = (Uint8)reader.read(4);
+		classes = std::max(classes, floor.partitionClass[i] + 1);
+	}
+	const int bookCount = (int)m_codebooks.size();
+	for (int c = 0; c < classes; ++c)
+	{
+		floor.classDimensions[c] = (Uint8)(reader.read(3) + 1);
+		floor.classSubclasses[c] = (Uint8)reader.read(2);
+		if (floor.classSubclasses[c] != 0)
+		{
+			floor.classMasterbook[c] = (Uint8)reader.read(8);
+			if (floor.classMasterbook[c] >= bookCount)
+			{
+				ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis floor\n");
+				return false;
+			}
+		}
+		for (int j = 0; j < (1 << floor.classSubclasses[c]); ++j)
+		{
+			floor.subclassBooks[c][j] = (Sint16)((int)reader.read(8) - 1);
+			if (floor.subclassBooks[c][j] >= bookCount)
+			{
+				ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis floor\n");
+				return false;
+			}
+		}
+	}
+	floor.multiplier = (int)reader.read(2) + 1;
+	const int rangeBits = (int)reader.read(4);
+	floor.x[0] = 0;
+	floor.x[1] = 1 << rangeBits;
+	floor.values = 2;
+	for (int i = 0; i < floor.partitions; ++i)
+	{
+		const int c = floor.partitionClass[i];
+		for (int j = 0; j < floor.classDimensions[c]; ++j)
+		{
+			if (floor.values == MAX_FLOOR_VALUES)
+			{
+				ns_Util::Logger::LOG_ERROR(m_path, " has a Vorbis floor of more than ", MAX_FLOOR_VALUES, " points\n");
+				return false;
+			}
+			floor.x[floor.values++] = (int)reader.read(rangeBits);
+		}
+	}
+
+	for (int i = 0; i < floor.values; ++i)
+	{
+		floor.sorted[i] = (Uint8)i;
+	}
+	std::sort(floor.sorted, floor.sorted + floor.values, [&](Uint8 a, Uint8 b) { return floor.x[a] < floor.x[b]; });
+	for (int i = 2; i < floor.values; ++i)
+	{
+		int low = 0;
+		int high = 1;
+		for (int j = 0; j < i; ++j)
+		{
+			if (floor.x[j] < floor.x[i] && floor.x[j] > floor.x[low])
+			{
+				low = j;
+			}
+			if (floor.x[j] > floor.x[i] && floor.x[j] < floor.x[high])
+			{
+				high = j;
+			}
+		}
+		floor.low[i] = (Uint8)low;
+		floor.high[i] = (Uint8)high;
+	}
+	return true;
+}
+
+bool OggVorbisFile::readResidue(BitReader& reader, Residue& residue)
+{
+	residue.type = (int)reader.read(16);
+	residue.begin = reader.read(24);
+	residue.end = reader.read(24);
+	residue.partitionSize = reader.read(24) + 1;
+	residue.classifications = (int)reader.read(6) + 1;
+	residue.classbook = (int)reader.read(8);
+	const int bookCount = (int)m_codebooks.size();
+	if (residue.type > 2 || residue.classbook >= bookCount)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis residue\n");
+		return false;
+	}
+	Uint8 cascade[64] = {};
+	for (int c = 0; c < residue.classifications; ++c)
+	{
+		const Uint32 low = reader.read(3);
+		const Uint32 high = reader.read(1) != 0 ? reader.read(5) : 0;
+		cascade[c] = (Uint8)(high << 3 | low);
+	}
+	for (int c = 0; c < residue.classifications; ++c)
+	{
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			residue.books[c][pass] = -1;
+			if (cascade[c] & (1 << pass))
+			{
+				residue.books[c][pass] = (Sint16)reader.read(8);
+				if (residue.books[c][pass] >= bookCount || m_codebooks[residue.books[c][pass]].values.empty()
+					|| residue.partitionSize % m_codebooks[residue.books[c][pass]].dimensions != 0)
+				{
+					ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis residue book\n");
+					return false;
+				}
+			}
+		}
+	}
+	const Codebook& classbook = m_codebooks[residue.classbook];
+	if (classbook.dimensions == 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis residue\n");
+		return false;
+	}
+	return true;
+}
+
+bool OggVorbisFile::readMapping(BitReader& reader, Mapping& mapping)
+{
+	if (reader.read(16) != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a Vorbis mapping of unknown type\n");
+		return false;
+	}
+	mapping.submaps = reader.read(1) != 0 ? (int)reader.read(4) + 1 : 1;
+	mapping.couplingSteps = reader.read(1) != 0 ? (int)reader.read(8) + 1 : 0;
+	const int channelBits = ilog((Uint32)m_channels - 1);
+	for (int i = 0; i < mapping.couplingSteps; ++i)
+	{
+		mapping.magnitude[i] = (Uint8)reader.read(channelBits);
+		mapping.angle[i] = (Uint8)reader.read(channelBits);
+		if (mapping.magnitude[i] == mapping.angle[i] || mapping.magnitude[i] >= m_channels || mapping.angle[i] >= m_channels)
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis channel coupling\n");
+			return false;
+		}
+	}
+	if (reader.read(2) != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis mapping\n");
+		return false;
+	}
+	for (int ch = 0; ch < m_channels; ++ch)
+	{
+		mapping.mux[ch] = mapping.submaps > 1 ? (Uint8)reader.read(4) : 0;
+		if (mapping.mux[ch] >= mapping.submaps)
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis mapping\n");
+			return false;
+		}
+	}
+	for (int i = 0; i < mapping.submaps; ++i)
+	{
+		reader.read(8);		// Unused time configuration
+		mapping.submapFloor[i] = (Uint8)reader.read(8);
+		mapping.submapResidue[i] = (Uint8)reader.read(8);
+		if (mapping.submapFloor[i] >= m_floors.size() || mapping.submapResidue[i] >= m_residues.size())
+		{
+			ns_Util::Logger::LOG_ERROR(m_path, " has a bad Vorbis mapping\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void OggVorbisFile::makeTransform(int n, Transform& transform)
+{
+	const int half = n / 2;
+	const int quarter = n / 4;
+	transform.n = n;
+
+	const int bits = ilog((Uint32)quarter) - 1;
+	transform.bitReverse.resize(quarter);
+	for (int i = 0; i < quarter; ++i)
+	{
+		transform.bitReverse[i] = bits > 0 ? bitReverse((Uint32)i) >> (32 - bits) : 0;
+	}
+	transform.stageCos.resize(std::max(quarter - 1, 1));
+	transform.stageSin.resize(std::max(quarter - 1, 1));
+	for (int h = 1; h < quarter; h *= 2)
+	{
+		for (int k = 0; k < h; ++k)
+		{
+			transform.stageCos[h - 1 + k] = (float)std::cos(-PI * k / h);
+			transform.stageSin[h - 1 + k] = (float)std::sin(-PI * k / h);
+		}
+	}
+	transform.preCos.resize(quarter);
+	transform.preSin.resize(quarter);
+	transform.postCos.resize(quarter);
+	transform.postSin.resize(quarter);
+	for (int k = 0; k < quarter; ++k)
+	{
+		transform.preCos[k] = (float)std::cos(-PI * (k + 0.25) / half);
+		transform.preSin[k] = (float)std::sin(-PI * (k + 0.25) / half);
+		transform.postCos[k] = (float)std::cos(-PI * k / half);
+		transform.postSin[k] = (float)std::sin(-PI * k / half);
+	}
+	transform.slope.resize(half);
+	for (int i = 0; i < half; ++i)
+	{
+		const double s = std::sin((i + 0.5) / half * PI / 2);
+		transform.slope[i] = (float)std::sin(PI / 2 * s * s);
+	}
+}
+
+bool OggVorbisFile::decodeMore()
+{
+	// The frames of the first page are held back until its granule position tells how many
+	// of them the encoder padded in front
+	while (!m_bEndOfStream)
+	{
+		Sint64 granule = -1;
+		bool bEnd = false;
+		if (!nextPacket(granule, bEnd))
+		{
+			m_bEndOfStream = true;
+			break;
+		}
+		Uint32 produced = 0;
+		if (!decodePacket(produced))
+		{
+			m_corruptPackets += 1;
+		}
+		m_position += produced;
+		if (granule >= 0)
+		{
+			const size_t frames = m_out.size() / m_channels;
+			if (!m_bPositionKnown && (Uint64)granule < m_position)
+			{
+				const size_t padding = std::min<size_t>((size_t)(m_position - (Uint64)granule), frames);
+				m_out.erase(m_out.begin(), m_out.begin() + padding * m_channels);
+			}
+			else if (bEnd && (Uint64)granule < m_position)
+			{
+				const size_t padding = std::min<size_t>((size_t)(m_position - (Uint64)granule), frames);
+				m_out.resize((frames - padding) * m_channels);
+			}
+			m_position = (Uint64)granule;
+			m_bPositionKnown = true;
+		}
+		m_bEndOfStream = bEnd;
+		if (m_bPositionKnown && m_out.size() / m_channels > m_outPos)
+		{
+			return true;
+		}
+	}
+	return m_out.size() / m_channels > m_outPos;
+}
+
+bool OggVorbisFile::decodePacket(Uint32& produced)
+{
+	produced = 0;
+	if (m_packet.empty())
+	{
+		return true;
+	}
+	BitReader reader(m_packet.data(), m_packet.size());
+	if (reader.read(1) != 0)
+	{
+		return false;
+	}
+	const Uint32 modeIndex = reader.read(ilog((Uint32)m_modes.size() - 1));
+	if (modeIndex >= m_modes.size())
+	{
+		return false;
+	}
+	const Mode& mode = m_modes[modeIndex];
+	const int n = m_blockSize[mode.bLong];
+	const int half = n / 2;
+	bool bPreviousLong = false;
+	bool bNextLong = false;
+	if (mode.bLong)
+	{
+		bPreviousLong = reader.read(1) != 0;
+		bNextLong = reader.read(1) != 0;
+	}
+	if (reader.eop())
+	{
+		return false;
+	}
+	const Mapping& mapping = m_mappings[mode.mapping];
+
+	// Floors, then every channel coupled to one that has audio gets its residue decoded
+	for (int ch = 0; ch < m_channels; ++ch)
+	{
+		const Floor& floor = m_floors[mapping.submapFloor[mapping.mux[ch]]];
+		m_bFloorUsed[ch] = decodeFloor(reader, floor, m_floorY[ch].data());
+		m_bDecode[ch] = m_bFloorUsed[ch];
+		std::fill(m_vectors[ch].begin(), m_vectors[ch].begin() + half, 0.0f);
+	}
+	for (int i = 0; i < mapping.couplingSteps; ++i)
+	{
+		if (m_bDecode[mapping.magnitude[i]] || m_bDecode[mapping.angle[i]])
+		{
+			m_bDecode[mapping.magnitude[i]] = m_bDecode[mapping.angle[i]] = 1;
+		}
+	}
+	for (int submap = 0; submap < mapping.submaps; ++submap)
+	{
+		int count = 0;
+		Uint8 bDecode[256];
+		for (int ch = 0; ch < m_channels; ++ch)
+		{
+			if (mapping.mux[ch] == submap)
+			{
+				m_vectorPointers[count] = m_vectors[ch].data();
+				bDecode[count++] = m_bDecode[ch];
+			}
+		}
+		const Residue& residue = m_residues[mapping.submapResidue[submap]];
+		decodeResidue(reader, residue, m_vectorPointers.data(), bDecode, count, (Uint32)half);
+	}
+
+	// Square polar coupling back to the channels
+	for (int i = mapping.couplingSteps - 1; i >= 0; --i)
+	{
+		float* pMagnitude = m_vectors[mapping.magnitude[i]].data();
+		float* pAngle = m_vectors[mapping.angle[i]].data();
+		for (int j = 0; j < half; ++j)
+		{
+			const float m = pMagnitude[j];
+			const float a = pAngle[j];
+			if (m > 0.0f)
+			{
+				if (a > 0.0f)
+				{
+					pAngle[j] = m - a;
+				}
+				else
+				{
+					pAngle[j] = m;
+					pMagnitude[j] = m + a;
+				}
+			}
+			else
+			{
+				if (a > 0.0f)
+				{
+					pAngle[j] = m + a;
+				}
+				else
+				{
+					pAngle[j] = m;
+					pMagnitude[j] = m - a;
+				}
+			}
+		}
+	}
+
+	// Window edges, short where the block next to a long one is short
+	const Transform& transform = m_transforms[mode.bLong];
+	const int leftN = mode.bLong && !bPreviousLong ? m_blockSize[0] / 2 : half;
+	const int rightN = mode.bLong && !bNextLong ? m_blockSize[0] / 2 : half;
+	const int leftStart = n / 4 - leftN / 2;
+	const int rightStart = 3 * n / 4 - rightN / 2;
+	const float* pLeftSlope = m_transforms[leftN != half ? 0 : mode.bLong].slope.data();
+	const float* pRightSlope = m_transforms[rightN != half ? 0 : mode.bLong].slope.data();
+
+	// The block before overlaps this one from its centre, the frames between the two centres
+	// are done
+	const int previousN = m_previousN;
+	const int frames = previousN > 0 ? previousN / 4 + n / 4 : 0;
+	const int shift = previousN / 4 - n / 4;
+	const size_t first = m_out.size() / m_channels;
+	m_out.resize((first + frames) * m_channels);
+	for (int ch = 0; ch < m_channels; ++ch)
+	{
+		float* pPcm = m_pcm.data();
+		if (m_bFloorUsed[ch])
+		{
+			applyFloor(m_floors[mapping.submapFloor[mapping.mux[ch]]], m_floorY[ch].data(), m_vectors[ch].data(), half);
+			inverseMdct(transform, m_vectors[ch].data(), pPcm);
+			std::fill(pPcm, pPcm + leftStart, 0.0f);
+			for (int i = 0; i < leftN; ++i)
+			{
+				pPcm[leftStart + i] *= pLeftSlope[i];
+			}
+			for (int i = 0; i < rightN; ++i)
+			{
+				pPcm[rightStart + i] *= pRightSlope[rightN - 1 - i];
+			}
+			std::fill(pPcm + rightStart + rightN, pPcm + n, 0.0f);
+		}
+		else
+		{
+			std::fill(pPcm, pPcm + n, 0.0f);
+		}
+
+		const float* pOverlap = m_overlap[ch].data();
+		float* pOut = m_out.data() + first * m_channels + ch;
+		for (int k = 0; k < frames; ++k)
+		{
+			const int c = k - shift;
+			const float previous = k < previousN / 2 ? pOverlap[k] : 0.0f;
+			pOut[(size_t)k * m_channels] = previous + (c >= 0 ? pPcm[c] : 0.0f);
+		}
+		std::copy(pPcm + half, pPcm + n, m_overlap[ch].begin());
+	}
+	m_previousN = n;
+	produced = (Uint32)frames;
+	return true;
+}
+
+bool OggVorbisFile::decodeFloor(BitReader& reader, const Floor& floor, int* pY) const
+{
+	static constexpr int ranges[4] = { 256, 128, 86, 64 };
+	if (reader.read(1) == 0)
+	{
+		return false;
+	}
+	const int bits = ilog((Uint32)ranges[floor.multiplier - 1] - 1);
+	pY[0] = (int)reader.read(bits);
+	pY[1] = (int)reader.read(bits);
+	int offset = 2;
+	for (int i = 0; i < floor.partitions; ++i)
+	{
+		const int c = floor.partitionClass[i];
+		const int dimensions = floor.classDimensions[c];
+		const int subclassBits = floor.classSubclasses[c];
+		const int subclassMask = (1 << subclassBits) - 1;
+		int value = 0;
+		if (subclassBits > 0)
+		{
+			value = m_codebooks[floor.classMasterbook[c]].decode(reader);
+			if (value < 0)
+			{
+				return false;
+			}
+		}
+		for (int j = 0; j < dimensions; ++j)
+		{
+			const int book = floor.subclassBooks[c][value & subclassMask];
+			value >>= subclassBits;
+			pY[offset + j] = 0;
+			if (book >= 0)
+			{
+				pY[offset + j] = m_codebooks[book].decode(reader);
+				if (pY[offset + j] < 0)
+				{
+					return false;
+				}
+			}
+		}
+		offset += dimensions;
+	}
+	return !reader.eop();
+}
+
+void OggVorbisFile::applyFloor(const Floor& floor, const int* pY, float* pVector, int half) const
+{
+	static constexpr int ranges[4] = { 256, 128, 86, 64 };
+	const int range = ranges[floor.multiplier - 1];
+	int finalY[MAX_FLOOR_VALUES];
+	bool bStep2[MAX_FLOOR_VALUES];
+
+	// Each point is coded as an offset from the line between its neighbours
+	finalY[0] = pY[0];
+	finalY[1] = pY[1];
+	bStep2[0] = bStep2[1] = true;
+	for (int i = 2; i < floor.values; ++i)
+	{
+		const int low = floor.low[i];
+		const int high = floor.high[i];
+		const int predicted = renderPoint(floor.x[low], finalY[low], floor.x[high], finalY[high], floor.x[i]);
+		const int value = pY[i];
+		const int highRoom = range - predicted;
+		const int lowRoom = predicted;
+		const int room = std::min(highRoom, lowRoom) * 2;
+		if (value == 0)
+		{
+			bStep2[i] = false;
+			finalY[i] = predicted;
+			continue;
+		}
+		bStep2[low] = bStep2[high] = bStep2[i] = true;
+		if (value >= room)
+		{
+			finalY[i] = highRoom > lowRoom ? value - lowRoom + predicted : predicted - value + highRoom - 1;
+		}
+		else
+		{
+			finalY[i] = (value & 1) ? predicted - (value + 1) / 2 : predicted + value / 2;
+		}
+	}
+
+	// Lines between the points that are used, left to right
+	int lx = 0;
+	int ly = finalY[floor.sorted[0]] * floor.multiplier;
+	for (int i = 1; i < floor.values; ++i)
+	{
+		const int j = floor.sorted[i];
+		if (bStep2[j])
+		{
+			const int hy = finalY[j] * floor.multiplier;
+			const int hx = floor.x[j];
+			renderLine(lx, ly, hx, hy, pVector, half);
+			lx = hx;
+			ly = hy;
+		}
+	}
+	if (lx < half)
+	{
+		renderLine(lx, ly, half, ly, pVector, half);
+	}
+}
+
+bool OggVorbisFile::decodeResidue(BitReader& reader, const Residue& residue, float** ppVectors, const Uint8* pDecode, int count, Uint32 size)
+{
+	// Type 2 is type 1 over the channels interleaved into one vector
+	if (residue.type == 2)
+	{
+		if (std::find(pDecode, pDecode + count, 1) == pDecode + count)
+		{
+			return true;
+		}
+		const Uint32 total = size * count;
+		std::fill(m_interleaved.begin(), m_interleaved.begin() + total, 0.0f);
+		float* pInterleaved = m_interleaved.data();
+		const Uint8 bDecode = 1;
+		Residue single = residue;
+		single.type = 1;
+		const bool bOk = decodeResidue(reader, single, &pInterleaved, &bDecode, 1, total);
+		for (int ch = 0; ch < count; ++ch)
+		{
+			for (Uint32 i = 0; i < size; ++i)
+			{
+				ppVectors[ch][i] = pInterleaved[(size_t)i * count + ch];
+			}
+		}
+		return bOk;
+	}
+
+	const Codebook& classbook = m_codebooks[residue.classbook];
+	const Uint32 begin = std::min(residue.begin, size);
+	const Uint32 end = std::min(residue.end, size);
+	if (end <= begin)
+	{
+		return true;
+	}
+	const int partitions = (int)((end - begin) / residue.partitionSize);
+	const int perWord = classbook.dimensions;
+	const size_t stride = (size_t)partitions + perWord;
+	if (m_classes.size() < stride * count)
+	{
+		m_classes.resize(stride * count);
+	}
+
+	for (int pass = 0; pass < 8; ++pass)
+	{
+		for (int p = 0; p < partitions; )
+		{
+			if (pass == 0)
+			{
+				for (int ch = 0; ch < count; ++ch)
+				{
+					if (!pDecode[ch])
+					{
+						continue;
+					}
+					int word = classbook.decode(reader);
+					if (word < 0)
+					{
+						return false;
+					}
+					for (int i = perWord - 1; i >= 0; --i)
+					{
+						m_classes[ch * stride + p + i] = word % residue.classifications;
+						word /= residue.classifications;
+					}
+				}
+			}
+			for (int i = 0; i < perWord && p < partitions; ++i, ++p)
+			{
+				for (int ch = 0; ch < count; ++ch)
+				{
+					if (!pDecode[ch])
+					{
+						continue;
+					}
+					const int book = residue.books[m_classes[ch * stride + p]][pass];
+					if (book >= 0 && !decodePartition(reader, m_codebooks[book], ppVectors[ch] + begin + (size_t)p * residue.partitionSize,
+						residue.partitionSize, residue.type == 1))
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool OggVorbisFile::decodePartition(BitReader& reader, const Codebook& book, float* pVector, Uint32 size, bool bInterleaved) const
+{
+	const int dimensions = book.dimensions;
+	if (bInterleaved)
+	{
+		for (Uint32 i = 0; i < size; )
+		{
+			const int entry = book.decode(reader);
+			if (entry < 0)
+			{
+				return false;
+			}
+			const float* pValues = book.values.data() + (size_t)entry * dimensions;
+			for (int j = 0; j < dimensions && i < size; ++j)
+			{
+				pVector[i++] += pValues[j];
+			}
+		}
+		return true;
+	}
+
+	// Type 0 spreads each vector across the partition
+	const Uint32 step = size / dimensions;
+	for (Uint32 i = 0; i < step; ++i)
+	{
+		const int entry = book.decode(reader);
+		if (entry < 0)
+		{
+			return false;
+		}
+		const float* pValues = book.values.data() + (size_t)entry * dimensions;
+		for (int j = 0; j < dimensions; ++j)
+		{
+			pVector[i + j * step] += pValues[j];
+		}
+	}
+	return true;
+}
+
+void OggVorbisFile::inverseMdct(const Transform& transform, const float* pCoefficients, float* pOut)
+{
+	// y[n] = sum X[k] cos(2 pi / N (n + 1/2 + N/4)(k + 1/2)) is a DCT-IV of the N/2
+	// coefficients, read forwards and backwards with signs flipped. The DCT-IV is a complex
+	// FFT of N/4 points between two twiddles.
+	const int n = transform.n;
+	const int half = n / 2;
+	const int quarter = n / 4;
+	float* pRe = m_fftRe.data();
+	float* pIm = m_fftIm.data();
+	for (int k = 0; k < quarter; ++k)
+	{
+		const float a = pCoefficients[2 * k];
+		const float b = pCoefficients[half - 1 - 2 * k];
+		const Uint32 j = transform.bitReverse[k];
+		pRe[j] = a * transform.preCos[k] - b * transform.preSin[k];
+		pIm[j] = a * transform.preSin[k] + b * transform.preCos[k];
+	}
+	for (int h = 1; h < quarter; h *= 2)
+	{
+		const float* pCos = transform.stageCos.data() + h - 1;
+		const float* pSin = transform.stageSin.data() + h - 1;
+		for (int start = 0; start < quarter; start += 2 * h)
+		{
+			for (int k = 0; k < h; ++k)
+			{
+				const int a = start + k;
+				const int b = a + h;
+				const float re = pRe[b] * pCos[k] - pIm[b] * pSin[k];
+				const float im = pRe[b] * pSin[k] + pIm[b] * pCos[k];
+				pRe[b] = pRe[a] - re;
+				pIm[b] = pIm[a] - im;
+				pRe[a] += re;
+				pIm[a] += im;
+			}
+		}
+	}
+	float* pDct = m_dct.data();
+	for (int k = 0; k < quarter; ++k)
+	{
+		pDct[2 * k] = pRe[k] * transform.postCos[k] - pIm[k] * transform.postSin[k];
+		pDct[half - 1 - 2 * k] = -(pRe[k] * transform.postSin[k] + pIm[k] * transform.postCos[k]);
+	}
+
+	const int q = half / 2;
+	for (int i = 0; i < q; ++i)
+	{
+		pOut[i] = pDct[i + q];
+	}
+	for (int i = q; i < 3 * q; ++i)
+	{
+		pOut[i] = -pDct[3 * q - 1 - i];
+	}
+	for (int i = 3 * q; i < n; ++i)
+	{
+		pOut[i] = -pDct[i - 3 * q];
+	}
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+
+// Ogg Vorbis file decoded front to back into interleaved float frames.
+//
+// Pages are read from the file one at a time and cut into packets, the file is never loaded
+// as a whole. The three header packets set up the codebooks, floors, residues, mappings and
+// modes. Every audio packet after them is decoded as the Vorbis I specification lays it
+// out: floor 1 curves, residue types 0, 1 and 2, channel coupling, then an inverse MDCT done
+// as a DCT-IV over a complex FFT of a quarter of the block, windowed and overlapped with the
+// block before. Floor 0, which no encoder has written since 2002, is not supported. Granule
+// positions trim the frames the encoder padded at the start and the end of the stream.
+// Channels come out in Vorbis order.
+class OggVorbisFile
+{
+public:
+	OggVorbisFile() = default;
+	~OggVorbisFile() { close(); }
+
+	OggVorbisFile(const OggVorbisFile&) = delete;
+	OggVorbisFile& operator=(const OggVorbisFile&) = delete;
+
+	// Reads the headers, false and an error when the file is not Ogg Vorbis or uses a
+	// feature that is not supported
+	bool open(const std::string& path);
+	void close();
+
+	INLINE int channels() const { return m_channels; }
+	INLINE int sampleRate() const { return m_sampleRate; }
+	INLINE Uint64 lengthInFrames() const { return m_lengthInFrames; }	// From the last page, 0 when unknown
+
+	// Up to frames frames into pFrames, returns how many, 0 at the end of the stream
+	Uint32 read(float* pFrames, Uint32 frames);
+
+	// Back to the first audio packet
+	bool rewind();
+
+	// Audio packets that failed to decode and were left out
+	INLINE Uint64 corruptPackets() const { return m_corruptPackets; }
+private:
+	static constexpr int	FAST_BITS = 10;			// Codewords up to this long decode with one table lookup
+	static constexpr int	MAX_FLOOR_VALUES = 65;
+
+	class BitReader;
+
+	struct Codebook
+	{
+		int						dimensions{};
+		int						entries{};
+		std::vector<Uint8>		lengths;			// Codeword length of each entry, 0 when unused
+		std::vector<Sint32>		fastEntry;			// By the next FAST_BITS bits, -1 when the codeword is longer
+		std::vector<Uint8>		fastLength;
+		std::vector<Sint32>		tree;				// Two children per node, 0 when missing, ~entry for a leaf
+		std::vector<float>		values;				// dimensions floats per entry, empty without a lookup table
+
+		int decode(BitReader& reader) const;		// Entry, -1 at the end of the packet or on a bad codeword
+	};
+
+	struct Floor
+	{
+		int			partitions{};
+		Uint8		partitionClass[31]{};
+		Uint8		classDimensions[16]{};
+		Uint8		classSubclasses[16]{};
+		Uint8		classMasterbook[16]{};
+		Sint16		subclassBooks[16][8]{};			// -1 when the subclass has no book
+		int			multiplier{};
+		int			values{};
+		int			x[MAX_FLOOR_VALUES]{};
+		Uint8		sorted[MAX_FLOOR_VALUES]{};		// Indices of x in increasing order
+		Uint8		low[MAX_FLOOR_VALUES]{};		// Closest x below, among the ones before it
+		Uint8		high[MAX_FLOOR_VALUES]{};		// Closest x above, among the ones before it
+	};
+
+	struct Residue
+	{
+		int			type{};
+		Uint32		begin{};
+		Uint32		end{};
+		Uint32		partitionSize{};
+		int			classifications{};
+		int			classbook{};
+		Sint16		books[64][8]{};					// By classification and pass, -1 when none
+	};
+
+	struct Mapping
+	{
+		int			submaps{};
+		int			couplingSteps{};
+		Uint8		magnitude[256]{};
+		Uint8		angle[256]{};
+		Uint8		mux[256]{};						// Submap of each channel
+		Uint8		submapFloor[16]{};
+		Uint8		submapResidue[16]{};
+	};
+
+	struct Mode
+	{
+		bool		bLong{};
+		int			mapping{};
+	};
+
+	// Inverse MDCT of one block size, n / 2 coefficients to n samples
+	struct Transform
+	{
+		int						n{};
+		std::vector<Uint32>		bitReverse;			// n / 4 entries
+		std::vector<float>		stageCos;			// FFT stage of span h uses [h - 1, 2h - 1)
+		std::vector<float>		stageSin;
+		std::vector<float>		preCos;				// e^(-i pi (k + 1/4) / (n / 2))
+		std::vector<float>		preSin;
+		std::vector<float>		postCos;			// e^(-i pi k / (n / 2))
+		std::vector<float>		postSin;
+		std::vector<float>		slope;				// Rising half of the window, n / 2 entries
+	};
+
+	// Ogg layer
+	bool readPage();
+	bool nextPacket(Sint64& granule, bool& bEndOfStream);
+	bool seekTo(long pageOffset, int segment, size_t bodyPos);
+	void readLength();
+
+	// Headers
+	bool readIdentification();
+	bool readSetup();
+	bool readCodebook(BitReader& reader, Codebook& book);
+	bool readFloor(BitReader& reader, Floor& floor);
+	bool readResidue(BitReader& reader, Residue& residue);
+	bool readMapping(BitReader& reader, Mapping& mapping);
+	void makeTransform(int n, Transform& transform);
+
+	// Audio packets
+	bool decodeMore();
+	bool decodePacket(Uint32& produced);
+	bool decodeFloor(BitReader& reader, const Floor& floor, int* pY) const;
+	void applyFloor(const Floor& floor, const int* pY, float* pVector, int half) const;
+	bool decodeResidue(BitReader& reader, const Residue& residue, float** ppVectors, const Uint8* pDecode, int count, Uint32 size);
+	bool decodePartition(BitReader& reader, const Codebook& book, float* pVector, Uint32 size, bool bInterleaved) const;
+	void inverseMdct(const Transform& transform, const float* pCoefficients, float* pOut);
+private:
+	std::FILE*					m_pFile{};
+	std::string					m_path;
+
+	// Ogg page being read
+	Uint32						m_serial{};
+	long						m_pageOffset{};
+	Uint8						m_pageFlags{};
+	Sint64						m_pageGranule{};
+	Uint8						m_segments[255]{};
+	int							m_segmentCount{};
+	int							m_segment{};			// Next segment to read
+	int							m_lastCompleted{};		// Segment ending the page's last complete packet, -1 when none
+	size_t						m_bodyPos{};
+	std::vector<Uint8>			m_body;
+	std::vector<Uint8>			m_packet;
+	bool						m_bSkipContinued{};		// Drop the packet a page continues, its start was lost
+
+	// First audio packet, for rewind()
+	long						m_audioPage{};
+	int							m_audioSegment{};
+	size_t						m_audioBodyPos{};
+
+	// Identification and setup headers
+	int							m_channels{};
+	int							m_sampleRate{};
+	int							m_blockSize[2]{};
+	Uint64						m_lengthInFrames{};
+	std::vector<Codebook>		m_codebooks;
+	std::vector<Floor>			m_floors;
+	std::vector<Residue>		m_residues;
+	std::vector<Mapping>		m_mappings;
+	std::vector<Mode>			m_modes;
+	Transform					m_transforms[2];
+
+	// Decoder state
+	std::vector<std::vector<float>>	m_vectors;			// Per channel, spectrum of the block
+	std::vector<std::vector<float>>	m_overlap;			// Per channel, right half of the block before
+	std::vector<std::vector<int>>	m_floorY;
+	std::vector<float*>			m_vectorPointers;
+	std::vector<Uint8>			m_bFloorUsed;
+	std::vector<Uint8>			m_bDecode;
+	std::vector<float>			m_interleaved;			// Residue type 2 vector
+	std::vector<int>			m_classes;
+	std::vector<float>			m_fftRe;
+	std::vector<float>			m_fftIm;
+	std::vector<float>			m_dct;
+	std::vector<float>			m_pcm;					// One channel of the block, windowed
+	int							m_previousN{};			// 0 before the first audio packet
+	bool						m_bPositionKnown{};		// A granule position has been seen
+	bool						m_bEndOfStream{};
+	Uint64						m_position{};			// Frame of the stream after the last decoded one
+	Uint64						m_corruptPackets{};
+
+	std::vector<float>			m_out;					// Decoded frames not handed out yet
+	size_t						m_outPos{};				// In frames
+};
@@ -14,6 +14,17 @@ bool Oscilloscope::init()
 	return m_soundWavePlayer.init();
 }
 
+bool Oscilloscope::initOffline()
+{
+	SDL_AudioSpec spec;
+	SDL_zero(spec);
+	spec.freq = SAMPLE_RATE;
+	spec.format = FORMAT;
+	spec.channels = CHANNELS;
+	spec.samples = SAMPLE_COUNT;
+	return m_soundWavePlayer.initOffline(spec);
+}
+
 void Oscilloscope::start()
 {
 	m_soundWavePlayer.start();
@@ -22,16 +33,28 @@ void Oscilloscope::start()
 void Oscilloscope::stop()
 {
 	m_soundWavePlayer.stop();
+	m_grid.releaseTexture();
 }
 
 void Oscilloscope::update(uint64_t elapsedTimeInMs, const std::vector<SDL_Event>& events)
 {
+	m_grid.update(events);
 	m_soundWavePlayer.update(elapsedTimeInMs, events);
 }
 
 void Oscilloscope::draw(SDL_Renderer* pRenderer)
+{
+	drawGrid(pRenderer);
+	drawTraces(pRenderer);
+}
+
+void Oscilloscope::drawGrid(SDL_Renderer* pRenderer)
 {
 	m_grid.draw(pRenderer);
+}
+
+void Oscilloscope::drawTraces(SDL_Renderer* pRenderer)
+{
 	m_soundWavePlayer.draw(pRenderer);
 }
 
@@ -39,5 +62,6 @@ void Oscilloscope::print(const std::string &prefix) const
 {
 	using ns_Util::Logger;
 	Logger::LOG_MSG(prefix, "Oscilloscope: \n");
+	m_grid.print(prefix + "          ");
 	m_soundWavePlayer.print(prefix + "          ");
 }
\ No newline at end of file
@@ -9,12 +9,23 @@ public:
 	Oscilloscope(int w, int h, int numOfCols);
 
 	bool init();
+
+	// No audio device, the audio callback is driven by the caller, see FrameRecorder
+	bool initOffline();
 	void start();
 	void stop();
 	void update(uint64_t elapsedTimeInMs, const std::vector<SDL_Event>& events);
 	void draw(SDL_Renderer *pRenderer);
+
+	// The two halves of draw(), for timing them on their own
+	void drawGrid(SDL_Renderer* pRenderer);
+	void drawTraces(SDL_Renderer* pRenderer);
 	void print(const std::string& prefix = "") const;
 
+	INLINE void setAudioFile(const std::string& path, const PcmLayout& rawLayout) { m_soundWavePlayer.setAudioFile(path, rawLayout); }
+
+	INLINE SoundWavePlayer& getSoundWavePlayer() { return m_soundWavePlayer; }
+
 private:
 	const int			m_width{};
 	const int			m_height{};
@@ -0,0 +1,94 @@
+#include "periodCache.h"
+#include "soundWave.h"
+#include "logger.h"
+
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+// x such that a * x = 1 (mod m), a and m coprime
+Uint32 modularInverse(Uint32 a, Uint32 m)
+{
+	if (m == 1)
+	{
+		return 0;
+	}
+	int64_t t = 0, newT = 1;
+	int64_t r = m, newR = a;
+	while (newR != 0)
+	{
+		const int64_t quotient = r / newR;
+		t -= quotient * newT;
+		std::swap(t, newT);
+		r -= quotient * newR;
+		std::swap(r, newR);
+	}
+	return (Uint32)(t < 0 ? t + m : t);
+}
+}
+
+bool PeriodCache::build(const SoundWave& wave, PeriodConvertFn convert, Uint32 frameBytes, Uint32 sampleBytes, float gain, float yOffset)
+{
+	clear();
+
+	const int fs = wave.getSampleRate();
+	if (fs <= 0 || !convert)
+	{
+		return false;
+	}
+
+	// A negative frequency plays the same samples as fs - |f|, see SoundWave::reEquateValues()
+	const int f = ((wave.getFrequency() % fs) + fs) % fs;
+	const int g = std::gcd(f, fs);
+	const Uint32 p = (Uint32)(fs / g);
+	const Uint32 q = (Uint32)(f / g);
+	if (p > MAX_FRAMES)
+	{
+		return false;
+	}
+
+	SoundWave copy = wave;
+	copy.resetPhase();
+	m_scratch.resize(p);
+	copy.render(m_scratch.data(), p);
+
+	m_frames.resize((size_t)p * frameBytes);
+	m_display.resize((size_t)p * sampleBytes);
+	convert(m_scratch.data(), m_frames.data(), m_display.data(), p, gain, yOffset);
+
+	m_periodFrames = p;
+	m_cycles = q;
+	m_cyclesInverse = modularInverse(q % p, p);
+	m_frameBytes = frameBytes;
+	m_sampleBytes = sampleBytes;
+	return true;
+}
+
+void PeriodCache::clear()
+{
+	m_periodFrames = 0;
+	m_cycles = 0;
+	m_cyclesInverse = 0;
+}
+
+Uint32 PeriodCache::frameForPhase(double phase) const
+{
+	// Frame k of the cache sits at phase (k * q / p) mod 1, so phase j / p is frame j * q^-1 mod p
+	const Uint64 j = (Uint64)std::llround(phase * m_periodFrames) % m_periodFrames;
+	return (Uint32)((j * m_cyclesInverse) % m_periodFrames);
+}
+
+void PeriodCache::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "PeriodCache: \n");
+	if (!valid())
+	{
+		Logger::LOG_MSG(prefix, "    Not in use\n");
+		return;
+	}
+	Logger::LOG_MSG(prefix, "    Period(# of frames) : ", m_periodFrames, ", covering ", m_cycles, " cycles\n");
+	Logger::LOG_MSG(prefix, "    Size(in bytes)      : ", m_frames.size() + m_display.size(), '\n');
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "constants.h"
+
+class SoundWave;
+
+// Converts count rendered samples, scaled by gain, into count interleaved device frames,
+// plus the first channel of each frame in display format
+using PeriodConvertFn = void (*)(const float* pSrc, Uint8* pFrames, Uint8* pDisplay, Uint32 count, float gain, float yOffset);
+
+// One exact repeating stretch of the output, already in device format.
+//
+// With integer f and fs, fs / f reduces to p / q, so after p frames the wave has gone
+// through exactly q cycles and the output repeats. When p is small enough the whole
+// stretch is rendered once and the audio callback only has to copy it.
+class PeriodCache
+{
+public:
+	static constexpr Uint32 MAX_FRAMES = 1 << 16;
+
+	// Renders the repeating stretch of wave, returns false and leaves the cache invalid
+	// when the period is longer than MAX_FRAMES.
+	bool build(const SoundWave& wave, PeriodConvertFn convert, Uint32 frameBytes, Uint32 sampleBytes, float gain, float yOffset);
+
+	void clear();
+
+	INLINE bool valid() const { return m_periodFrames > 0; }
+
+	INLINE Uint32 periodFrames() const { return m_periodFrames; }
+	INLINE Uint32 cycles() const { return m_cycles; }
+	INLINE Uint32 frameBytes() const { return m_frameBytes; }
+	INLINE Uint32 sampleBytes() const { return m_sampleBytes; }
+
+	INLINE const Uint8* frames() const { return m_frames.data(); }
+	INLINE const Uint8* display() const { return m_display.data(); }
+
+	// Frame of the cache that starts at the given accumulator phase
+	Uint32 frameForPhase(double phase) const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	std::vector<float>	m_scratch;
+	std::vector<Uint8>	m_frames;				// m_periodFrames interleaved frames
+	std::vector<Uint8>	m_display;				// First channel of every frame
+	Uint32				m_periodFrames{};		// p
+	Uint32				m_cycles{};				// q
+	Uint32				m_cyclesInverse{};		// q^-1 mod p, maps a phase back to a frame
+	Uint32				m_frameBytes{};
+	Uint32				m_sampleBytes{};
+};
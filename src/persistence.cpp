@@ -0,0 +1,441 @@
+#include "persistence.h"
+#include "simd.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+// log2(x) for x >= 1 from the bits of the float, exact at powers of 2 and linear in between
+INLINE float fastLog2(float x)
+{
+	Sint32 bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return (float)(bits - 0x3f800000) * (1.0f / (1 << 23));
+}
+
+#if OSC_X86
+// decayToPixels() four hits at a time, returns how many it did
+OSC_TARGET_SSE2 Uint32 decayToPixelsSse2(float* pHits, Uint32 count, float decay, float hitScale, float indexScale, const Uint32* pLut,
+	Uint32* pPixels, float& maxHits)
+{
+	const __m128 vDecay = _mm_set1_ps(decay);
+	const __m128 vHitScale = _mm_set1_ps(hitScale);
+	const __m128 vIndexScale = _mm_set1_ps(indexScale);
+	const __m128 vFloor = _mm_set1_ps(Persistence::HIT_FLOOR);
+	const __m128 vTop = _mm_set1_ps((float)(Persistence::LUT_SIZE - 1));
+	const __m128 vOne = _mm_set1_ps(1.0f);
+	const __m128i vOneBits = _mm_set1_epi32(0x3f800000);
+	const __m128 vMantissa = _mm_set1_ps(1.0f / (1 << 23));
+	const __m128i vEmpty = _mm_set1_epi32((int)pLut[0]);
+	__m128 vMax = _mm_setzero_ps();
+	alignas(16) Sint32 index[4];
+
+	Uint32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 h = _mm_mul_ps(_mm_loadu_ps(pHits + i), vDecay);
+		h = _mm_and_ps(h, _mm_cmpge_ps(h, vFloor));
+		_mm_storeu_ps(pHits + i, h);
+		vMax = _mm_max_ps(vMax, h);
+
+		// Most of the image is empty
+		const __m128 nonZero = _mm_cmpgt_ps(h, _mm_setzero_ps());
+		if (_mm_movemask_ps(nonZero) == 0)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels + i), vEmpty);
+			continue;
+		}
+
+		// fastLog2() of 1 + h * hitScale, scaled to the LUT and at least 1 for every hit
+		const __m128i bits = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_mul_ps(h, vHitScale), vOne)), vOneBits);
+		__m128 x = _mm_min_ps(_mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(bits), vMantissa), vIndexScale), vTop);
+		x = _mm_max_ps(x, _mm_and_ps(nonZero, vOne));
+		_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(x));
+		pPixels[i] = pLut[index[0]];
+		pPixels[i + 1] = pLut[index[1]];
+		pPixels[i + 2] = pLut[index[2]];
+		pPixels[i + 3] = pLut[index[3]];
+	}
+
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, vMax);
+	maxHits = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	return i;
+}
+#endif // OSC_X86
+
+// Display samples as floats, for the columns of short frames
+template <typename T>
+INLINE float sampleAt(const T* pSamples, Uint32 count, float pos)
+{
+	if (pos <= 0.0f)
+	{
+		return static_cast<float>(pSamples[0]);
+	}
+	const Uint32 i = (Uint32)pos;
+	if (i + 1 >= count)
+	{
+		return static_cast<float>(pSamples[count - 1]);
+	}
+	const float t = pos - i;
+	return static_cast<float>(pSamples[i]) + (static_cast<float>(pSamples[i + 1]) - static_cast<float>(pSamples[i])) * t;
+}
+}
+
+float decayToPixels(float* pHits, Uint32 count, float decay, float hitScale, const Uint32* pLut, Uint32* pPixels, SimdLevel level)
+{
+	const float indexScale = Persistence::LUT_SIZE / fastLog2(1.0f + Persistence::LOG_RANGE);
+	Uint32 i = 0;
+	float maxHits = 0.0f;
+#if OSC_X86
+	if (level >= SimdLevel::SSE2)
+	{
+		i = decayToPixelsSse2(pHits, count, decay, hitScale, indexScale, pLut, pPixels, maxHits);
+	}
+#endif
+	(void)level;
+	for (; i < count; ++i)
+	{
+		float h = pHits[i] * decay;
+		h = h >= Persistence::HIT_FLOOR ? h : 0.0f;
+		pHits[i] = h;
+		maxHits = std::max(maxHits, h);
+		float x = std::min(fastLog2(h * hitScale + 1.0f) * indexScale, (float)(Persistence::LUT_SIZE - 1));
+		x = std::max(x, h > 0.0f ? 1.0f : 0.0f);
+		pPixels[i] = pLut[(int)x];
+	}
+	return maxHits;
+}
+
+void Persistence::reset(int width, int height, Uint32 maxSamples, Uint32 sampleBytes)
+{
+	stop();
+	releaseTexture();
+	m_width = std::max(width, 1);
+	m_height = std::max(height, 1);
+	m_texture.setSize(m_width, m_height);
+	m_slotBytes = maxSamples * sampleBytes;
+	buildLut();
+
+	// Frame slots are large and only needed once the view is on, start() allocates them
+	m_pFrames->reset();
+	for (size_t i = 0; i < FrameRing::capacity(); ++i)
+	{
+		std::vector<Uint8>().swap(m_pFrames->slots()[i].samples);
+	}
+	for (int i = 0; i < TripleBuffer<Image>::SLOT_COUNT; ++i)
+	{
+		Image& image = m_output.slots()[i];
+		image.pixels.assign((size_t)m_width * m_height, m_lut[0]);
+		image.number = 0;
+		image.frames = 0;
+	}
+	m_hits.assign((size_t)m_width * m_height, 0.0f);
+	m_columns.assign(m_width, MinMaxColumn{});
+	m_imageNumber = 0;
+	m_uploadedImage = 0;
+}
+
+void Persistence::buildLut()
+{
+	// Entries are spaced evenly in log intensity, decayToPixels() takes the log. Dark blue
+	// through cyan, green, yellow and red to white, empty pixels are transparent.
+	constexpr ColorStop stops[] =
+	{
+		{ 0.00f,   0.0f,   0.0f, 160.0f },
+		{ 0.30f,   0.0f, 200.0f, 255.0f },
+		{ 0.50f,   0.0f, 255.0f,  64.0f },
+		{ 0.70f, 255.0f, 255.0f,   0.0f },
+		{ 0.90f, 255.0f,  64.0f,   0.0f },
+		{ 1.00f, 255.0f, 255.0f, 255.0f },
+	};
+	buildColorRamp(stops, (int)(sizeof(stops) / sizeof(stops[0])), m_lut.data(), LUT_SIZE);
+	m_lut[0] = 0;
+}
+
+void Persistence::start()
+{
+	if (m_bRunning.load(std::memory_order_relaxed) || m_slotBytes == 0)
+	{
+		return;
+	}
+	if (m_pFrames->slots()[0].samples.empty())
+	{
+		for (size_t i = 0; i < FrameRing::capacity(); ++i)
+		{
+			m_pFrames->slots()[i].samples.assign(m_slotBytes, 0);
+		}
+	}
+
+	// Frames and images of the last run are not part of this one. Nothing runs on the ring
+	// or the output while stopped.
+	while (m_pFrames->peek())
+	{
+		m_pFrames->pop();
+	}
+	for (int i = 0; i < TripleBuffer<Image>::SLOT_COUNT; ++i)
+	{
+		m_output.slots()[i].number = 0;
+		m_output.slots()[i].frames = 0;
+	}
+	m_imageNumber = 0;
+	m_uploadedImage = 0;
+	std::fill(m_hits.begin(), m_hits.end(), 0.0f);
+	m_maxHits = 0.0f;
+	m_lastImageTicks = SDL_GetPerformanceCounter();
+	m_accumulated.store(0, std::memory_order_relaxed);
+	m_accumulateTicks.store(0, std::memory_order_relaxed);
+	m_bImageTaken.store(true, std::memory_order_relaxed);
+	m_bRunning.store(true, std::memory_order_relaxed);
+	m_worker = std::thread(&Persistence::workerLoop, this);
+
+	// Slots are in place before the audio thread can see this
+	m_bAccepting.store(true, std::memory_order_release);
+}
+
+void Persistence::stop()
+{
+	m_bAccepting.store(false, std::memory_order_relaxed);
+	m_bRunning.store(false, std::memory_order_relaxed);
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+}
+
+void Persistence::submit(const void* pSamples, SDL_AudioFormat format, Uint32 count, float xOffset)
+{
+	if (!m_bAccepting.load(std::memory_order_acquire))
+	{
+		return;
+	}
+	Frame* pFrame = m_pFrames->beginWrite();
+	if (!pFrame)
+	{
+		return;
+	}
+	const Uint32 bytes = SDL_AUDIO_BITSIZE(format) / 8;
+	pFrame->count = bytes > 0 ? std::min(count, (Uint32)pFrame->samples.size() / bytes) : 0;
+	pFrame->format = format;
+	pFrame->xOffset = xOffset;
+	memcpy(pFrame->samples.data(), pSamples, (size_t)pFrame->count * bytes);
+	m_pFrames->commitWrite();
+}
+
+void Persistence::setNextDecay()
+{
+	constexpr float presets[] = { 100.0f, 500.0f, 2000.0f, 10000.0f, 0.0f };
+	constexpr int PRESET_COUNT = (int)(sizeof(presets) / sizeof(presets[0]));
+	const float decayMs = getDecayMs();
+	int i = 0;
+	while (i < PRESET_COUNT && presets[i] != decayMs)
+	{
+		++i;
+	}
+	setDecayMs(presets[(i + 1) % PRESET_COUNT]);
+}
+
+template <typename T>
+void Persistence::interpolateColumns(const T* pSamples, Uint32 count, float xOffset)
+{
+	// Sample i is at column (i + xOffset) * m_width / count, as TraceRenderer lays it out
+	const float samplesPerColumn = (float)count / m_width;
+	float left = sampleAt(pSamples, count, -xOffset);
+	for (int c = 0; c < m_width; ++c)
+	{
+		const float pos = (c + 1) * samplesPerColumn - xOffset;
+		const float right = sampleAt(pSamples, count, pos);
+		MinMaxColumn& column = m_columns[c];
+		column.min = std::min(left, right);
+		column.max = std::max(left, right);
+
+		// A sample inside the column can be a peak
+		const float inner = std::floor(pos);
+		if (inner > pos - samplesPerColumn && inner >= 0.0f && inner < (float)count)
+		{
+			const float v = static_cast<float>(pSamples[(Uint32)inner]);
+			column.min = std::min(column.min, v);
+			column.max = std::max(column.max, v);
+		}
+		left = right;
+	}
+}
+
+void Persistence::accumulate(const void* pSamples, SDL_AudioFormat format, Uint32 count, float xOffset)
+{
+	if (count < 2 || m_hits.empty())
+	{
+		return;
+	}
+
+	// Longer frames than the image is wide are decimated, the offset is below a column then
+	const Uint32 width = (Uint32)m_width;
+	if (count > width)
+	{
+		if (!decimateMinMax(pSamples, format, count, m_columns.data(), width))
+		{
+			return;
+		}
+	}
+	else
+	{
+		switch (format)
+		{
+			case AUDIO_S8:	interpolateColumns(static_cast<const Sint8*>(pSamples), count, xOffset);	break;
+			case AUDIO_U8:	interpolateColumns(static_cast<const Uint8*>(pSamples), count, xOffset);	break;
+			case AUDIO_S16:	interpolateColumns(static_cast<const Sint16*>(pSamples), count, xOffset);	break;
+			case AUDIO_U16:	interpolateColumns(static_cast<const Uint16*>(pSamples), count, xOffset);	break;
+			case AUDIO_S32:	interpolateColumns(static_cast<const Sint32*>(pSamples), count, xOffset);	break;
+			case AUDIO_F32:	interpolateColumns(static_cast<const float*>(pSamples), count, xOffset);	break;
+			default:
+				return;
+		}
+	}
+
+	// One hit per pixel of the span in each column, connected to the previous column
+	const float height = (float)m_height;
+	for (Uint32 c = 0; c < width; ++c)
+	{
+		float lo = m_columns[c].min;
+		float hi = m_columns[c].max;
+		if (c > 0)
+		{
+			lo = std::min(lo, m_columns[c - 1].max);
+			hi = std::max(hi, m_columns[c - 1].min);
+		}
+		const float top = std::max(height - hi, 0.0f);
+		const float bottom = std::min(height - lo, height - 1.0f);
+		if (top > bottom)
+		{
+			continue;
+		}
+		float* pHit = m_hits.data() + (size_t)top * width + c;
+		for (int y = (int)top, last = (int)bottom; y <= last; ++y, pHit += width)
+		{
+			*pHit += 1.0f;
+		}
+	}
+}
+
+void Persistence::workerLoop()
+{
+	while (m_bRunning.load(std::memory_order_relaxed))
+	{
+		bool bIdle = true;
+		while (const Frame* pFrame = m_pFrames->peek())
+		{
+			const Uint64 start = SDL_GetPerformanceCounter();
+			accumulate(pFrame->samples.data(), pFrame->format, pFrame->count, pFrame->xOffset);
+			m_pFrames->pop();
+			m_accumulateTicks.store(m_accumulateTicks.load(std::memory_order_relaxed) + SDL_GetPerformanceCounter() - start, std::memory_order_relaxed);
+			m_accumulated.store(m_accumulated.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			bIdle = false;
+		}
+
+		// A new image once the UI took the last one, decayed by the time in between
+		if (m_bImageTaken.load(std::memory_order_acquire))
+		{
+			const Uint64 now = SDL_GetPerformanceCounter();
+			const float decayMs = getDecayMs();
+			const double elapsedMs = (now - m_lastImageTicks) * 1000.0 / SDL_GetPerformanceFrequency();
+			const float decay = decayMs > 0.0f ? (float)std::exp(-elapsedMs / decayMs) : 1.0f;
+			m_lastImageTicks = now;
+
+			Image& image = m_output.back();
+			const float hitScale = LOG_RANGE / std::max(m_maxHits, 1.0f);
+			m_maxHits = decayToPixels(m_hits.data(), (Uint32)m_hits.size(), decay, hitScale, m_lut.data(), image.pixels.data());
+			image.number = ++m_imageNumber;
+			image.frames = m_accumulated.load(std::memory_order_relaxed);
+
+			// Cleared before publishing, the UI may take the image right away
+			m_bImageTaken.store(false, std::memory_order_relaxed);
+			m_output.publish();
+			bIdle = false;
+		}
+
+		if (bIdle)
+		{
+			SDL_Delay(1);
+		}
+	}
+}
+
+void Persistence::update(const std::vector<SDL_Event>& events)
+{
+	// draw() makes a new texture once the device lost it
+	m_texture.update(events);
+}
+
+void Persistence::draw(SDL_Renderer* pRenderer, const SDL_Rect& area)
+{
+	if (m_output.update())
+	{
+		m_bImageTaken.store(true, std::memory_order_release);
+	}
+	const Image& image = m_output.front();
+	if (image.number == 0)
+	{
+		return;
+	}
+	bool bCreated = false;
+	SDL_Texture* pTexture = m_texture.acquire(pRenderer, bCreated);
+	if (!pTexture)
+	{
+		return;
+	}
+
+	if (bCreated || image.number != m_uploadedImage)
+	{
+		void* pPixels = nullptr;
+		int pitch = 0;
+		if (SDL_LockTexture(pTexture, nullptr, &pPixels, &pitch) != 0)
+		{
+			ns_Util::Logger::LOG_SDL_ERROR("Persistence: can not lock the texture");
+			return;
+		}
+		for (int y = 0; y < m_height; ++y)
+		{
+			memcpy(static_cast<Uint8*>(pPixels) + (size_t)y * pitch, image.pixels.data() + (size_t)y * m_width, (size_t)m_width * sizeof(Uint32));
+		}
+		SDL_UnlockTexture(pTexture);
+		m_uploadedImage = image.number;
+	}
+	SDL_RenderCopy(pRenderer, pTexture, nullptr, &area);
+}
+
+void Persistence::releaseTexture()
+{
+	m_texture.release();
+}
+
+double Persistence::averageFrameUs() const
+{
+	const Uint64 frames = m_accumulated.load(std::memory_order_relaxed);
+	if (frames == 0)
+	{
+		return 0.0;
+	}
+	return m_accumulateTicks.load(std::memory_order_relaxed) * 1e6 / SDL_GetPerformanceFrequency() / frames;
+}
+
+void Persistence::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	const float decayMs = getDecayMs();
+	Logger::LOG_MSG(prefix, "Persistence: \n");
+	Logger::LOG_MSG(prefix, "    Size               : ", m_width, " x ", m_height, '\n');
+	if (decayMs > 0.0f)
+	{
+		Logger::LOG_MSG(prefix, "    Decay              : ", decayMs, " ms\n");
+	}
+	else
+	{
+		Logger::LOG_MSG(prefix, "    Decay              : Infinite\n");
+	}
+	Logger::LOG_MSG(prefix, "    Worker             : ", isRunning() ? "Running" : "Stopped", ", ", m_accumulated.load(std::memory_order_relaxed),
+		" frames, ", averageFrameUs(), " us each, ", m_pFrames->overruns(), " dropped\n");
+	Logger::LOG_MSG(prefix, "    Images             : ", m_output.front().number, '\n');
+}
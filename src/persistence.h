@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+#include "spscRing.h"
+#include "tripleBuffer.h"
+#include "minMaxDecimator.h"
+#include "colorRamp.h"
+
+// Digital phosphor display, every acquired frame accumulated into one intensity graded image.
+//
+// The audio thread hands each frame it publishes to submit(), which copies it into a slot of
+// a ring and never waits. A worker thread draws every frame from the ring into a hit buffer
+// of one float per pixel, a vertical span per column like the decimated trace. Once the UI has
+// taken the previous image it decays the hit buffer by the time that passed and maps it
+// through a LUT_SIZE entry colour table into the next image, in one SSE2 pass. Images reach
+// the UI through a TripleBuffer and go into a streaming texture, so drawing costs one upload
+// and one copy however many frames came in. A frame that shows up once in thousands stays
+// visible in a dim colour, which is what makes glitches stand out.
+class Persistence
+{
+public:
+	static constexpr int	LUT_SIZE = 4096;
+	static constexpr size_t	FRAME_SLOTS = 32;
+	static constexpr float	HIT_FLOOR = 1.0f / 1024;		// Decayed hits below this are gone
+	static constexpr float	DEFAULT_DECAY_MS = 500.0f;
+	static constexpr float	LOG_RANGE = 1000.0f;			// Brightest pixel over the dimmest the colours tell apart
+
+	// One image, published by the worker
+	struct Image
+	{
+		std::vector<Uint32>	pixels;			// SDL_PIXELFORMAT_ARGB8888, width * height, row 0 at the top
+		Uint64				number{};		// 0 until the first image is in
+		Uint64				frames{};		// Frames accumulated so far
+	};
+
+	Persistence() = default;
+	~Persistence() { stop(); }
+
+	Persistence(const Persistence&) = delete;
+	Persistence& operator=(const Persistence&) = delete;
+
+	// UI thread while the audio thread is not running, stops the worker. width by height
+	// pixels, display samples are pixels above the bottom row. Frames take up to maxSamples
+	// samples of sampleBytes each.
+	void reset(int width, int height, Uint32 maxSamples, Uint32 sampleBytes);
+
+	// UI thread. Clears the image and starts accumulating, stop() ends it.
+	void start();
+	void stop();
+	INLINE bool isRunning() const { return m_bAccepting.load(std::memory_order_relaxed); }
+
+	// Audio thread, a frame of count display samples in format, xOffset samples right of the
+	// left edge. Dropped and counted when the worker is behind.
+	void submit(const void* pSamples, SDL_AudioFormat format, Uint32 count, float xOffset);
+
+	// Hits decay to 1/e in decayMs, 0 keeps them forever
+	INLINE void setDecayMs(float decayMs) { m_decayMs.store(decayMs, std::memory_order_relaxed); }
+	INLINE float getDecayMs() const { return m_decayMs.load(std::memory_order_relaxed); }
+	void setNextDecay();				// Cycles through a few presets
+
+	// Recreates the texture after the renderer lost it
+	void update(const std::vector<SDL_Event>& events);
+
+	// Newest image into area
+	void draw(SDL_Renderer* pRenderer, const SDL_Rect& area);
+
+	// Frees the texture, must happen before its renderer is destroyed
+	void releaseTexture();
+
+	// Worker thread, or any thread while it is stopped. Adds one frame to the hit buffer.
+	void accumulate(const void* pSamples, SDL_AudioFormat format, Uint32 count, float xOffset);
+
+	// Worker time per accumulated frame
+	double averageFrameUs() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	struct Frame
+	{
+		std::vector<Uint8>	samples;		// Allocated by the first start(), never resized after
+		Uint32				count{};
+		SDL_AudioFormat		format{};
+		float				xOffset{};
+	};
+	using FrameRing = SpscRing<Frame, FRAME_SLOTS>;
+
+	template <typename T>
+	void interpolateColumns(const T* pSamples, Uint32 count, float xOffset);
+
+	void workerLoop();
+	void buildLut();
+private:
+	int								m_width{};
+	int								m_height{};
+	Uint32							m_slotBytes{};
+	std::array<Uint32, LUT_SIZE>	m_lut{};
+
+	std::unique_ptr<FrameRing>		m_pFrames{ std::make_unique<FrameRing>() };	// Heap, it is cache line aligned
+	TripleBuffer<Image>				m_output;
+	std::atomic<bool>				m_bAccepting{};		// submit() takes frames
+	std::atomic<bool>				m_bRunning{};		// Worker keeps going
+	std::atomic<bool>				m_bImageTaken{};	// UI took the newest image, the worker makes the next
+	std::atomic<float>				m_decayMs{ DEFAULT_DECAY_MS };
+	std::thread						m_worker;
+
+	// Worker thread
+	std::vector<float>				m_hits;				// width * height, row-major like the image
+	std::vector<MinMaxColumn>		m_columns;
+	float							m_maxHits{};		// Of the last image, sets the LUT scale of the next
+	Uint64							m_imageNumber{};
+	Uint64							m_lastImageTicks{};
+
+	std::atomic<Uint64>				m_accumulated{};
+	std::atomic<Uint64>				m_accumulateTicks{};	// SDL_GetPerformanceCounter() ticks spent in accumulate()
+
+	// UI thread
+	StreamingTexture				m_texture{ "Persistence", SDL_BLENDMODE_BLEND };
+	Uint64							m_uploadedImage{};	// Image number in m_texture
+};
+
+// One image of the worker. Decays count hits by decay, flushing those below
+// Persistence::HIT_FLOOR to 0, and maps them through pLut into pPixels by the log of
+// 1 + hits * hitScale, 1 + Persistence::LOG_RANGE and above on the top LUT entry. Empty
+// pixels take entry 0 and every other one at least entry 1, however far below the brightest
+// it is. Returns the largest decayed hit count. SSE2 does four pixels at a time and writes
+// empty ones without a lookup.
+extern float decayToPixels(float* pHits, Uint32 count, float decay, float hitScale, const Uint32* pLut, Uint32* pPixels,
+	SimdLevel level = detectSimdLevel());
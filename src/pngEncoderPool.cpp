@@ -0,0 +1,136 @@
+#include "pngEncoderPool.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <SDL_image.h>
+
+bool PngEncoderPool::start(int workers)
+{
+	finish();
+	if (workers <= 0)
+	{
+		workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	// Loads the PNG codec once, IMG_SavePNG() would otherwise do it from every worker
+	if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) == 0)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to load the PNG codec, ", IMG_GetError(), '\n');
+		return false;
+	}
+
+	m_bStopping = false;
+	m_encoded = m_failed = m_encodeTicks = m_stalls = m_stallTicks = 0;
+	m_workerCount = workers;
+	for (int i = 0; i < workers; ++i)
+	{
+		m_workers.emplace_back(&PngEncoderPool::workerLoop, this);
+	}
+	return true;
+}
+
+PngEncoderPool::Frame* PngEncoderPool::acquire()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_free.empty() && m_frames.size() < MAX_QUEUED_FRAMES)
+	{
+		m_frames.push_back(std::make_unique<Frame>());
+		return m_frames.back().get();
+	}
+	if (m_free.empty())
+	{
+		const Uint64 start = SDL_GetPerformanceCounter();
+		m_returned.wait(lock, [this] { return !m_free.empty(); });
+		++m_stalls;
+		m_stallTicks += SDL_GetPerformanceCounter() - start;
+	}
+	Frame* pFrame = m_free.back();
+	m_free.pop_back();
+	return pFrame;
+}
+
+void PngEncoderPool::submit(Frame* pFrame)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(pFrame);
+	}
+	m_queued.notify_one();
+}
+
+void PngEncoderPool::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_queued.notify_all();
+
+	// Workers drain the queue before they leave
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void PngEncoderPool::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_queued.wait(lock, [this] { return !m_queue.empty() || m_bStopping; });
+		if (m_queue.empty())
+		{
+			return;
+		}
+		Frame* pFrame = m_queue.front();
+		m_queue.pop_front();
+		++m_busy;
+		lock.unlock();
+
+		const Uint64 start = SDL_GetPerformanceCounter();
+		const bool bEncoded = encode(*pFrame);
+		const Uint64 ticks = SDL_GetPerformanceCounter() - start;
+
+		lock.lock();
+		--m_busy;
+		m_encodeTicks += ticks;
+		++(bEncoded ? m_encoded : m_failed);
+		m_free.push_back(pFrame);
+		m_returned.notify_one();
+	}
+}
+
+bool PngEncoderPool::encode(const Frame& frame)
+{
+	// Wraps the pixels in place, nothing is copied
+	SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormatFrom((void*)frame.pixels.data(), frame.width, frame.height,
+		SDL_BITSPERPIXEL(frame.format), frame.pitch, frame.format);
+	if (!pSurface)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR("Failed to wrap a frame for ", frame.path);
+		return false;
+	}
+	const bool bSaved = IMG_SavePNG(pSurface, frame.path.c_str()) == 0;
+	SDL_FreeSurface(pSurface);
+	if (!bSaved)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to write ", frame.path, ", ", IMG_GetError(), '\n');
+	}
+	return bSaved;
+}
+
+void PngEncoderPool::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const double frequency = (double)SDL_GetPerformanceFrequency();
+	const Uint64 frames = m_encoded + m_failed;
+	Logger::LOG_MSG(prefix, "PngEncoderPool: \n");
+	Logger::LOG_MSG(prefix, "    Workers            : ", m_workerCount, ", ", m_frames.size(), " frame buffers of ", MAX_QUEUED_FRAMES, '\n');
+	Logger::LOG_MSG(prefix, "    Encoded            : ", m_encoded, " frames, ", m_failed, " failed, ",
+		frames > 0 ? m_encodeTicks * 1000.0 / frequency / frames : 0.0, " ms per frame per worker\n");
+	Logger::LOG_MSG(prefix, "    Queued             : ", m_queue.size(), ", ", m_busy, " being encoded\n");
+	Logger::LOG_MSG(prefix, "    Stalls             : ", m_stalls, ", ", m_stallTicks * 1000.0 / frequency, " ms waited for a buffer\n");
+}
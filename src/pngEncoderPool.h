@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+
+// Encodes frames to PNG files with SDL2_image on worker threads.
+//
+// The caller copies a frame into a buffer from acquire() and hands it back with submit(), a
+// worker encodes it and returns the buffer. Buffers are allocated on first use and then
+// reused, up to MAX_QUEUED_FRAMES. The caller only waits when all of them are still queued,
+// every such wait is counted as a stall.
+class PngEncoderPool
+{
+public:
+	static constexpr int MAX_QUEUED_FRAMES = 32;
+
+	struct Frame
+	{
+		std::vector<Uint8>	pixels;
+		int					width{};
+		int					height{};
+		int					pitch{};
+		Uint32				format{};		// SDL_PIXELFORMAT_*
+		std::string			path;
+	};
+
+	PngEncoderPool() = default;
+	~PngEncoderPool() { finish(); }
+
+	PngEncoderPool(const PngEncoderPool&) = delete;
+	PngEncoderPool& operator=(const PngEncoderPool&) = delete;
+
+	// workers <= 0 uses one per core but the caller's
+	bool start(int workers);
+
+	Frame* acquire();
+	void submit(Frame* pFrame);
+
+	// Waits until every submitted frame is written, then stops the workers
+	void finish();
+
+	INLINE int workerCount() const { return m_workerCount; }
+	INLINE Uint64 encodedFrames() const { return m_encoded; }
+	INLINE Uint64 failedFrames() const { return m_failed; }
+	INLINE Uint64 stalls() const { return m_stalls; }
+
+	// SDL_GetPerformanceCounter() ticks, summed over the workers and waited by the caller
+	INLINE Uint64 encodeTicks() const { return m_encodeTicks; }
+	INLINE Uint64 stallTicks() const { return m_stallTicks; }
+
+	void print(const std::string& prefix = "") const;
+private:
+	void workerLoop();
+
+	// Writes the frame, false when SDL2_image fails
+	static bool encode(const Frame& frame);
+
+private:
+	std::vector<std::thread>			m_workers;
+	int									m_workerCount{};	// Kept once finish() joined them
+	std::vector<std::unique_ptr<Frame>>	m_frames;		// Every buffer ever handed out
+	std::vector<Frame*>					m_free;
+	std::deque<Frame*>					m_queue;
+	mutable std::mutex					m_mutex;
+	std::condition_variable				m_queued;		// Workers wait for frames
+	std::condition_variable				m_returned;		// The caller waits for buffers
+	bool								m_bStopping{};
+	int									m_busy{};		// Frames being encoded
+
+	// Under m_mutex
+	Uint64								m_encoded{};
+	Uint64								m_failed{};
+	Uint64								m_encodeTicks{};
+	Uint64								m_stalls{};
+	Uint64								m_stallTicks{};
+};
@@ -0,0 +1,37 @@
+#include "sampleFormat.h"
+
+std::string audioFormat2String(SDL_AudioFormat format)
+{
+	std::string strFormat;
+	switch (format)
+	{
+		case AUDIO_S8:
+			strFormat = "AUDIO_S8";
+			break;
+
+		case AUDIO_U8:
+			strFormat = "AUDIO_U8";
+			break;
+
+		case AUDIO_S16:
+			strFormat = "AUDIO_S16";
+			break;
+
+		case AUDIO_U16:
+			strFormat = "AUDIO_U16";
+			break;
+
+		case AUDIO_S32:
+			strFormat = "AUDIO_S32";
+			break;
+
+		case AUDIO_F32:
+			strFormat = "AUDIO_F32";
+			break;
+
+		default:
+			strFormat = "Unkown";
+			break;
+	}
+	return strFormat;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include "constants.h"
+
+// Conversions between device samples and normalized floats in [-1, 1]. Integer samples are
+// scaled to full range, unsigned ones are centred on half range like the SDL formats.
+
+// Name of an SDL sample format, like AUDIO_S16
+extern std::string audioFormat2String(SDL_AudioFormat format);
+
+// Sample in [-1, 1] at full scale of T, out of range values are clipped
+template <typename T>
+INLINE T toDeviceSample(float x)
+{
+	x = std::clamp(x, -1.0f, 1.0f);
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		return x;
+	}
+	else if constexpr (std::is_signed_v<T>)
+	{
+		return static_cast<T>((double)x * std::numeric_limits<T>::max());
+	}
+	else
+	{
+		constexpr double half = std::numeric_limits<T>::max() / 2;
+		return static_cast<T>(half + 1 + (double)x * half);
+	}
+}
+
+// Inverse of toDeviceSample()
+template <typename T>
+INLINE float toNormalizedSample(T v)
+{
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		return v;
+	}
+	else if constexpr (std::is_signed_v<T>)
+	{
+		return (float)((double)v / std::numeric_limits<T>::max());
+	}
+	else
+	{
+		constexpr double half = std::numeric_limits<T>::max() / 2;
+		return (float)(((double)v - half - 1) / half);
+	}
+}
+
+// Display value in T, clamped so a loud signal cannot wrap around
+template <typename T>
+INLINE T toDisplaySample(float y)
+{
+	constexpr double lo = (double)std::numeric_limits<T>::lowest();
+	constexpr double hi = (double)std::numeric_limits<T>::max();
+	return static_cast<T>(std::clamp((double)y, lo, hi));
+}
+
+// Maps full scale samples of T onto display units, sample * gain + offset
+template <typename T>
+struct DisplayTransform
+{
+	float	gain{};
+	float	offset{};
+
+	INLINE T operator()(T v) const { return toDisplaySample<T>(toNormalizedSample(v) * gain + offset); }
+};
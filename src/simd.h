@@ -0,0 +1,20 @@
+#pragma once
+
+// Shared setup for the hand written SSE2/AVX2 kernels
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define OSC_X86 1
+	#include <immintrin.h>
+#else
+	#define OSC_X86 0
+#endif
+
+// GCC and Clang only emit SSE2/AVX2 instructions inside functions that ask for them,
+// MSVC accepts the intrinsics anywhere.
+#if OSC_X86 && (defined(__GNUC__) || defined(__clang__))
+	#define OSC_TARGET_SSE2 __attribute__((target("sse2")))
+	#define OSC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define OSC_TARGET_SSE2
+	#define OSC_TARGET_AVX2
+#endif
@@ -26,12 +26,33 @@ std::string waveForm2String(WaveForm w)
 	return wave;
 }
 
-SoundWave::SoundWave(int f, int a, WaveForm w, value_type phase)
+std::string oscillatorMode2String(OscillatorMode mode)
+{
+	std::string strMode;
+	switch (mode)
+	{
+		case OscillatorMode::COMPUTE:
+			strMode = "Compute";
+			break;
+		case OscillatorMode::WAVETABLE:
+			strMode = "Wavetable";
+			break;
+		default:
+			strMode = "Unkown";
+			break;
+	}
+	return strMode;
+}
+
+SoundWave::SoundWave(int f, int a, WaveForm w, value_type phase, int sampleRate)
 	: m_f(f)
 	, m_A(a)
 	, m_phase(phase)
 	, m_waveForm(w)
+	, m_sampleRate(sampleRate)
+	, m_pWavetables(&WavetableBank::get(WavetableBank::DEFAULT_SIZE_LOG2))
 {
+	setSimdLevel(detectSimdLevel());
 	reEquateValues();
 }
 
@@ -46,6 +67,18 @@ void SoundWave::setNextWaveForm()
 	m_waveForm = (WaveForm)val;
 }
 
+void SoundWave::setNextOscillatorMode()
+{
+	int val = (int)m_oscillatorMode + 1;
+	setOscillatorMode(val >= (int)OscillatorMode::MAX ? OscillatorMode::COMPUTE : (OscillatorMode)val);
+}
+
+void SoundWave::setNextInterpolation()
+{
+	int val = (int)m_interpolation + 1;
+	setInterpolation(val >= (int)Interpolation::MAX ? Interpolation::LINEAR : (Interpolation)val);
+}
+
 void SoundWave::changeFrequency(int deltaChange)
 {
 	m_f += deltaChange;
@@ -64,6 +97,12 @@ void SoundWave::reEquateValues()
 	m_halfA = m_A / 2.0;
 	m_p = 1 / (value_type)m_f;
 	m_af = M_PI_2 * m_f;
+
+	// Keep the increment in [0, 1), a negative or above fs frequency aliases to the same samples
+	m_phaseInc = m_sampleRate > 0 ? m_f / (phase_type)m_sampleRate : 0;
+	m_phaseInc -= std::floor(m_phaseInc);
+	m_phaseOffset = (phase_type)m_phase / (2 * M_PI);
+	m_phaseOffset -= std::floor(m_phaseOffset);
 }
 
 SoundWave::value_type SoundWave::getSample(value_type t) const
@@ -120,6 +159,66 @@ SoundWave::value_type SoundWave::getSample(value_type t) const
 	return value;
 }
 
+void SoundWave::selectKernels()
+{
+	m_waveKernels = m_oscillatorMode == OscillatorMode::WAVETABLE ? getWavetableKernels(m_interpolation) : getWaveKernels(m_simdLevel);
+}
+
+void SoundWave::renderWith(WaveForm w, sample_type* out, size_t n)
+{
+	WaveKernelParams params;
+	params.phase = m_phaseAcc;
+	params.increment = m_phaseInc;
+	params.offset = m_phaseOffset;
+	params.amplitude = (float)m_A;
+	params.wavetable = &m_pWavetables->table(w);
+	m_waveKernels[(int)w](out, n, params);
+
+	advancePhase(n);
+}
+
+SoundWave::sample_type SoundWave::shape(phase_type p) const
+{
+	// p is the position inside the current cycle, shift it by the phase and wrap back to [0, 1)
+	p += m_phaseOffset;
+	if (p >= 1.0)
+	{
+		p -= 1.0;
+	}
+
+	sample_type value{};
+	switch (m_waveForm)
+	{
+		case WaveForm::SINE:
+			// y = A * sin(2πp)
+			value = static_cast<sample_type>(m_A * std::sin(2 * M_PI * p));
+			break;
+
+		case WaveForm::SQUARE:
+			// +A for the first half of the cycle, -A for the second half
+			value = static_cast<sample_type>(p < 0.5 ? m_A : -m_A);
+			break;
+
+		case WaveForm::SAWTOOTH:
+			// Ramps from -A to +A over one cycle
+			value = static_cast<sample_type>(m_A * (2 * p - 1));
+			break;
+
+		case WaveForm::TRIANGLE:
+			// Starts at 0, +A at p = 0.25, -A at p = 0.75
+			p += 0.25;
+			if (p >= 1.0)
+			{
+				p -= 1.0;
+			}
+			value = static_cast<sample_type>(m_A * (1 - 4 * std::abs(p - 0.5)));
+			break;
+		default:
+			break;
+	}
+	return value;
+}
+
 void SoundWave::print(const std::string& prefix) const
 {
 	using ns_Util::Logger;
@@ -129,5 +228,15 @@ void SoundWave::print(const std::string& prefix) const
 	Logger::LOG_MSG(prefix, "    Period             : ", m_p, '\n');
 	Logger::LOG_MSG(prefix, "    Phase              : ", m_phase, '\n');
 	Logger::LOG_MSG(prefix, "    Waveform           : ", waveForm2String(m_waveForm), '\n');
-	
+	Logger::LOG_MSG(prefix, "    Sample rate        : ", m_sampleRate, ", Phase increment : ", m_phaseInc, '\n');
+	Logger::LOG_MSG(prefix, "    Normalized phase   : ", m_phaseAcc, '\n');
+	Logger::LOG_MSG(prefix, "    Oscillator mode    : ", oscillatorMode2String(m_oscillatorMode), '\n');
+	if (m_oscillatorMode == OscillatorMode::WAVETABLE)
+	{
+		Logger::LOG_MSG(prefix, "    Wavetable          : ", m_pWavetables->table(m_waveForm).size(), " points, ", interpolation2String(m_interpolation), " interpolation\n");
+	}
+	else
+	{
+		Logger::LOG_MSG(prefix, "    Render kernels     : ", simdLevel2String(m_simdLevel), '\n');
+	}
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <string>
 #include "constants.h"
+#include "waveKernels.h"
+#include "wavetable.h"
 
 enum class WaveForm
 {
@@ -14,22 +16,84 @@ enum class WaveForm
 
 extern std::string waveForm2String(WaveForm w);
 
+// How render() produces samples
+enum class OscillatorMode
+{
+	COMPUTE,		// Closed form per sample, see waveKernels.h
+	WAVETABLE,		// Interpolated lookup into a precomputed cycle, see wavetable.h
+	MAX
+};
+
+extern std::string oscillatorMode2String(OscillatorMode mode);
+
 class SoundWave
 {
 public:
 	using value_type = long double;
+	using sample_type = float;		// Output of the phase accumulator engine
+	using phase_type = double;		// Normalized phase, always in [0, 1)
 
-	SoundWave(int f, int a, WaveForm w, value_type phase);
+	SoundWave(int f, int a, WaveForm w, value_type phase, int sampleRate = SAMPLE_RATE);
 
-	INLINE void setFrequency(int f) { m_f = f; }
-	INLINE void setAmplitude(int a) { m_A = a; }
-	INLINE void setPhase(value_type phase) { m_phase = phase; }
+	INLINE void setFrequency(int f) { m_f = f; reEquateValues(); }
+	INLINE void setAmplitude(int a) { m_A = a; reEquateValues(); }
+	INLINE void setPhase(value_type phase) { m_phase = phase; reEquateValues(); }
 	INLINE void setWaveForm(WaveForm w) { m_waveForm = w; }
+	INLINE void setSampleRate(int sampleRate) { m_sampleRate = sampleRate; reEquateValues(); }
 
 	INLINE int getFrequency() const { return m_f; }
 	INLINE int getAmplitude() const { return m_A; }
 	INLINE value_type getPhase() const { return m_phase; }
 	INLINE WaveForm getWaveForm() const { return m_waveForm; }
+	INLINE int getSampleRate() const { return m_sampleRate; }
+
+	// Phase accumulator API
+	INLINE phase_type getNormalizedPhase() const { return m_phaseAcc; }
+	INLINE phase_type getPhaseIncrement() const { return m_phaseInc; }
+	INLINE void resetPhase() { m_phaseAcc = 0; }
+	INLINE void setNormalizedPhase(phase_type p) { m_phaseAcc = p - std::floor(p); }
+
+	// Moves the phase forward by n samples without rendering them
+	INLINE void advancePhase(size_t n)
+	{
+		m_phaseAcc += n * m_phaseInc;
+		m_phaseAcc -= std::floor(m_phaseAcc);
+	}
+
+	INLINE void setSimdLevel(SimdLevel level) { m_simdLevel = availableSimdLevel(level); selectKernels(); }
+	INLINE SimdLevel getSimdLevel() const { return m_simdLevel; }
+
+	INLINE void setOscillatorMode(OscillatorMode mode) { m_oscillatorMode = mode; selectKernels(); }
+	INLINE void setInterpolation(Interpolation i) { m_interpolation = i; selectKernels(); }
+	INLINE void setWavetableSize(int sizeLog2) { m_pWavetables = &WavetableBank::get(sizeLog2); }
+	INLINE OscillatorMode getOscillatorMode() const { return m_oscillatorMode; }
+	INLINE Interpolation getInterpolation() const { return m_interpolation; }
+	INLINE int getWavetableSize() const { return m_pWavetables->sizeLog2(); }
+
+	void setNextOscillatorMode();
+	void setNextInterpolation();
+
+	// Returns the sample at the current phase and advances the phase by f / fs.
+	// Unlike getSample(t) there is no absolute time involved, so it can run forever
+	// without overflow or loss of precision.
+	INLINE sample_type nextSample()
+	{
+		const sample_type value = shape(m_phaseAcc);
+		m_phaseAcc += m_phaseInc;
+		if (m_phaseAcc >= 1.0)
+		{
+			m_phaseAcc -= 1.0;
+		}
+		return value;
+	}
+
+	// Block version of nextSample(), fills out[0, n) and advances the phase by n samples
+	INLINE void render(sample_type* out, size_t n) { renderWith(m_waveForm, out, n); }
+
+	// Same as render() for a waveform known at compile time, no lookup on the current waveform
+	template<WaveForm W>
+	INLINE void renderAs(sample_type* out, size_t n) { renderWith(W, out, n); }
+	// Phase accumulator API
 
 	void setNextWaveForm();
 	void changeFrequency(int deltaChange);
@@ -37,9 +101,14 @@ public:
 
 	void reEquateValues();
 
+	// Reference implementation, evaluates the waveform at absolute time t (in seconds)
 	value_type getSample(value_type t) const;
 
 	void print(const std::string& prefix = "") const;
+private:
+	sample_type shape(phase_type p) const;
+	void renderWith(WaveForm w, sample_type* out, size_t n);
+	void selectKernels();
 private:
 	int			m_f{};		// Frequency
 	int			m_A{};		// Amplitude
@@ -52,4 +121,15 @@ private:
 	int			m_2A{};		// 2 * a
 	value_type	m_halfA{};	// a / 2
 	value_type	m_af{};		// angular frequency = 2πf
+
+	int			m_sampleRate{};		// fs
+	phase_type	m_phaseAcc{};		// Current phase, in cycles [0, 1)
+	phase_type	m_phaseInc{};		// f / fs, phase advance per sample
+	phase_type	m_phaseOffset{};	// φ / 2π, in cycles [0, 1)
+
+	SimdLevel				m_simdLevel{};		// Instruction set used by render()
+	OscillatorMode			m_oscillatorMode{};
+	Interpolation			m_interpolation{};
+	const WavetableBank*	m_pWavetables{};
+	const WaveKernel*		m_waveKernels{};	// Kernels used by render(), indexed by WaveForm
 };
\ No newline at end of file
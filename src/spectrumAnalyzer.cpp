@@ -0,0 +1,248 @@
+#include "spectrumAnalyzer.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SpectrumAnalyzer::reset(int sampleRate, float bias, float fullScale, Uint32 columns)
+{
+	stop();
+	m_sampleRate = sampleRate;
+	m_bias = bias;
+	m_invFullScale = fullScale > 0.0f ? 1.0f / fullScale : 1.0f;
+	m_history.assign(MAX_SIZE, 0.0f);
+	m_written = m_submitted = 0;
+
+	// Everything both sides touch is allocated here, before the worker runs
+	for (int i = 0; i < TripleBuffer<Input>::SLOT_COUNT; ++i)
+	{
+		m_input.slots()[i].samples.assign(MAX_SIZE, 0.0f);
+		m_input.slots()[i].size = 0;
+	}
+	for (int i = 0; i < TripleBuffer<Spectrum>::SLOT_COUNT; ++i)
+	{
+		Spectrum& spectrum = m_output.slots()[i];
+		spectrum.columnDb.assign(columns, DB_FLOOR);
+		spectrum.columns = columns;
+		spectrum.frameNumber = 0;
+	}
+	m_windowed.assign(MAX_SIZE, 0.0f);
+	m_scratch.assign(MAX_SIZE, 0.0f);
+	m_re.assign(MAX_SIZE / 2 + 1, 0.0f);
+	m_im.assign(MAX_SIZE / 2 + 1, 0.0f);
+	m_db.assign(MAX_SIZE / 2 + 1, DB_FLOOR);
+	m_windowTable.assign(MAX_SIZE, 0.0f);
+	m_tableWindow = FftWindow::MAX;
+	m_tableSize = 0;
+	m_frameNumber = 0;
+	m_spectra.store(0, std::memory_order_relaxed);
+	m_spectrumTicks.store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+void SpectrumAnalyzer::appendSamples(const T* pSamples, Uint32 count)
+{
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		m_history[(size_t)((m_written + i) & (MAX_SIZE - 1))] = (static_cast<float>(pSamples[i]) - m_bias) * m_invFullScale;
+	}
+	m_written += count;
+}
+
+bool SpectrumAnalyzer::append(const void* pSamples, SDL_AudioFormat format, Uint32 count)
+{
+	if (m_history.empty())
+	{
+		return false;
+	}
+	switch (format)
+	{
+		case AUDIO_S8:	appendSamples(static_cast<const Sint8*>(pSamples), count);	break;
+		case AUDIO_U8:	appendSamples(static_cast<const Uint8*>(pSamples), count);	break;
+		case AUDIO_S16:	appendSamples(static_cast<const Sint16*>(pSamples), count);	break;
+		case AUDIO_U16:	appendSamples(static_cast<const Uint16*>(pSamples), count);	break;
+		case AUDIO_S32:	appendSamples(static_cast<const Sint32*>(pSamples), count);	break;
+		case AUDIO_F32:	appendSamples(static_cast<const float*>(pSamples), count);	break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+void SpectrumAnalyzer::submit()
+{
+	if (m_history.empty() || m_written == m_submitted)
+	{
+		return;
+	}
+	m_submitted = m_written;
+
+	// Newest m_size samples oldest first, in at most two pieces of the ring
+	Input& input = m_input.back();
+	input.size = m_size;
+	input.window = m_window;
+	input.sampleRate = m_sampleRate;
+	input.endSample = m_written;
+	const Uint32 first = (Uint32)((m_written - m_size) & (MAX_SIZE - 1));
+	const Uint32 head = std::min(m_size, MAX_SIZE - first);
+	std::copy_n(m_history.data() + first, head, input.samples.data());
+	std::copy_n(m_history.data(), m_size - head, input.samples.data() + head);
+	m_input.publish();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bPending = true;
+		if (!m_bRunning)
+		{
+			m_bRunning = true;
+			m_worker = std::thread(&SpectrumAnalyzer::workerLoop, this);
+		}
+	}
+	m_wake.notify_one();
+}
+
+const SpectrumAnalyzer::Spectrum& SpectrumAnalyzer::acquireSpectrum()
+{
+	m_output.update();
+	return m_output.front();
+}
+
+void SpectrumAnalyzer::setSize(Uint32 size)
+{
+	Uint32 powerOfTwo = MIN_SIZE;
+	while (powerOfTwo < size && powerOfTwo < MAX_SIZE)
+	{
+		powerOfTwo *= 2;
+	}
+	m_size = powerOfTwo;
+}
+
+void SpectrumAnalyzer::setNextWindow()
+{
+	m_window = (FftWindow)(((int)m_window + 1) % (int)FftWindow::MAX);
+}
+
+void SpectrumAnalyzer::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bRunning = false;
+	}
+	m_wake.notify_one();
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+}
+
+double SpectrumAnalyzer::averageMs() const
+{
+	const Uint64 spectra = m_spectra.load(std::memory_order_relaxed);
+	if (spectra == 0)
+	{
+		return 0.0;
+	}
+	return m_spectrumTicks.load(std::memory_order_relaxed) * 1000.0 / SDL_GetPerformanceFrequency() / spectra;
+}
+
+void SpectrumAnalyzer::workerLoop()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_bPending || !m_bRunning; });
+			if (!m_bRunning)
+			{
+				return;
+			}
+			m_bPending = false;
+		}
+
+		if (!m_input.update())
+		{
+			continue;
+		}
+		const Uint64 start = SDL_GetPerformanceCounter();
+		analyse(m_input.front(), m_output.back());
+		m_output.publish();
+		m_spectrumTicks.fetch_add(SDL_GetPerformanceCounter() - start, std::memory_order_relaxed);
+		m_spectra.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void SpectrumAnalyzer::analyse(const Input& input, Spectrum& spectrum)
+{
+	const Uint32 size = input.size;
+	if (input.window != m_tableWindow || size != m_tableSize)
+	{
+		makeFftWindow(input.window, m_windowTable.data(), size);
+		m_tableWindow = input.window;
+		m_tableSize = size;
+	}
+	for (Uint32 i = 0; i < size; ++i)
+	{
+		m_windowed[i] = input.samples[i] * m_windowTable[i];
+	}
+
+	const RealFft& fft = RealFft::plan(size);
+	fft.forward(m_windowed.data(), m_re.data(), m_im.data(), m_scratch.data());
+	const Uint32 bins = fft.bins();
+	powerToDb(m_re.data(), m_im.data(), m_db.data(), bins, 1.0f, std::pow(10.0f, DB_FLOOR / 10.0f), fft.getSimdLevel());
+
+	spectrum.size = size;
+	spectrum.window = input.window;
+	spectrum.endSample = input.endSample;
+	spectrum.frameNumber = ++m_frameNumber;
+
+	// Loudest bin above DC
+	Uint32 peak = 1;
+	for (Uint32 k = 2; k < bins; ++k)
+	{
+		peak = m_db[k] > m_db[peak] ? k : peak;
+	}
+	const float binHz = (float)input.sampleRate / size;
+	spectrum.peakFrequency = peak * binHz;
+	spectrum.peakDb = m_db[peak];
+
+	// Column c spans [MIN_FREQUENCY * r^c, MIN_FREQUENCY * r^(c + 1)) with r^columns reaching Nyquist
+	const Uint32 columns = spectrum.columns;
+	const float nyquist = input.sampleRate / 2.0f;
+	const float ratio = std::pow(nyquist / MIN_FREQUENCY, 1.0f / std::max(columns, 1u));
+	float lo = MIN_FREQUENCY / binHz;
+	for (Uint32 c = 0; c < columns; ++c)
+	{
+		const float hi = lo * ratio;
+		const Uint32 first = (Uint32)std::ceil(lo);
+		const Uint32 last = std::min((Uint32)std::ceil(hi), bins);
+		float db = DB_FLOOR;
+		if (first < last)
+		{
+			db = *std::max_element(m_db.data() + first, m_db.data() + last);
+		}
+		else
+		{
+			const float centre = std::min(0.5f * (lo + hi), (float)(bins - 1));
+			const Uint32 k = std::min((Uint32)centre, bins - 2);
+			const float t = centre - k;
+			db = m_db[k] + (m_db[k + 1] - m_db[k]) * t;
+		}
+		spectrum.columnDb[c] = db;
+		lo = hi;
+	}
+}
+
+void SpectrumAnalyzer::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "SpectrumAnalyzer: \n");
+	Logger::LOG_MSG(prefix, "    FFT                : ", m_size, " points, ", fftWindow2String(m_window), " window, ",
+		m_sampleRate > 0 ? (double)m_sampleRate / m_size : 0.0, " Hz per bin\n");
+	Logger::LOG_MSG(prefix, "    Worker             : ", m_bRunning ? "Running" : "Stopped", ", ", m_spectra.load(std::memory_order_relaxed),
+		" spectra, ", averageMs(), " ms each\n");
+	const Spectrum& spectrum = m_output.front();
+	if (spectrum.frameNumber != 0)
+	{
+		Logger::LOG_MSG(prefix, "    Peak               : ", spectrum.peakFrequency, " Hz at ", spectrum.peakDb, " dB\n");
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+#include "fft.h"
+#include "tripleBuffer.h"
+
+// Spectrum of the newest display samples, on a log frequency axis.
+//
+// The UI thread appends display samples as they are drained from the audio thread and
+// submit()s the newest getSize() of them once a frame. A worker thread windows them, runs
+// the FFT, converts to dB and reduces the bins to one value per column, the loudest bin in
+// the column or, where columns are narrower than bins, the two bins around it
+// interpolated. Samples go to the worker and spectra come back through TripleBuffers, so
+// neither side waits and a worker that falls behind only skips to the newest samples. The
+// audio thread is never involved.
+class SpectrumAnalyzer
+{
+public:
+	static constexpr Uint32 MIN_SIZE = 256;
+	static constexpr Uint32 MAX_SIZE = RealFft::MAX_SIZE;
+	static constexpr Uint32 DEFAULT_SIZE = SAMPLE_COUNT * 4;
+	static constexpr float DB_FLOOR = -120.0f;			// Bottom of the view, 0 dB is the top
+	static constexpr float MIN_FREQUENCY = 20.0f;		// Left edge of the view, Nyquist is the right one
+
+	// One analysed block, published by the worker
+	struct Spectrum
+	{
+		std::vector<float>	columnDb;		// Preallocated for the columns given to reset()
+		Uint32				columns{};
+		Uint32				size{};			// FFT size it was computed with
+		FftWindow			window{};
+		Uint64				endSample{};	// Display sample one past the newest one analysed
+		Uint64				frameNumber{};	// 0 until the first spectrum is in
+		float				peakFrequency{};
+		float				peakDb{ DB_FLOOR };
+	};
+
+	SpectrumAnalyzer() = default;
+	~SpectrumAnalyzer() { stop(); }
+
+	SpectrumAnalyzer(const SpectrumAnalyzer&) = delete;
+	SpectrumAnalyzer& operator=(const SpectrumAnalyzer&) = delete;
+
+	// UI thread, stops the worker. Display samples are bias at silence and bias +- fullScale
+	// at 0 dB, the spectrum is reduced to columns values.
+	void reset(int sampleRate, float bias, float fullScale, Uint32 columns);
+
+	// UI thread, display samples in one of the player's formats, false for any other format
+	bool append(const void* pSamples, SDL_AudioFormat format, Uint32 count);
+
+	// UI thread. Hands the newest getSize() samples to the worker when new ones came in since
+	// the last call, and starts the worker the first time.
+	void submit();
+
+	// UI thread, newest spectrum, frameNumber is 0 until there is one
+	const Spectrum& acquireSpectrum();
+
+	// UI thread, take effect with the next submit()
+	void setSize(Uint32 size);
+	INLINE Uint32 getSize() const { return m_size; }
+	INLINE void setWindow(FftWindow window) { m_window = window; }
+	INLINE FftWindow getWindow() const { return m_window; }
+	void setNextWindow();
+
+	void stop();
+
+	// Worker time per spectrum, window to columns
+	double averageMs() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	struct Input
+	{
+		std::vector<float>	samples;		// Preallocated to MAX_SIZE, the newest size in use
+		Uint32				size{};
+		FftWindow			window{};
+		int					sampleRate{};
+		Uint64				endSample{};
+	};
+
+	template <typename T>
+	void appendSamples(const T* pSamples, Uint32 count);
+
+	void workerLoop();
+	void analyse(const Input& input, Spectrum& spectrum);
+private:
+	// UI thread
+	std::vector<float>			m_history;			// MAX_SIZE newest samples, a ring
+	Uint64						m_written{};
+	Uint64						m_submitted{};
+	int							m_sampleRate{};
+	float						m_bias{};
+	float						m_invFullScale{ 1.0f };
+	Uint32						m_size{ DEFAULT_SIZE };
+	FftWindow					m_window{ FftWindow::HANN };
+
+	TripleBuffer<Input>			m_input;
+	TripleBuffer<Spectrum>		m_output;
+
+	std::thread					m_worker;
+	std::mutex					m_mutex;
+	std::condition_variable		m_wake;
+	bool						m_bPending{};		// Guarded by m_mutex
+	bool						m_bRunning{};		// Guarded by m_mutex
+
+	// Worker thread
+	std::vector<float>			m_windowed;
+	std::vector<float>			m_re;
+	std::vector<float>			m_im;
+	std::vector<float>			m_scratch;
+	std::vector<float>			m_db;
+	std::vector<float>			m_windowTable;
+	FftWindow					m_tableWindow{ FftWindow::MAX };
+	Uint32						m_tableSize{};
+	Uint64						m_frameNumber{};
+
+	std::atomic<Uint64>			m_spectra{};
+	std::atomic<Uint64>			m_spectrumTicks{};	// SDL_GetPerformanceCounter() ticks spent in analyse()
+};
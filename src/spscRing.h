@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324)		// Structure was padded due to alignment specifier, that is the point
+#endif
+
+// Bounded single producer, single consumer queue of N preallocated slots, wait-free on both sides.
+//
+// The producer fills the slot from beginWrite() in place and hands it over with commitWrite(),
+// the consumer reads the slot from peek() in place and gives it back with pop(). Nothing is
+// copied or allocated after construction. When the queue is full the producer does not wait,
+// beginWrite() returns nullptr and the lost slot is counted as an overrun.
+//
+// Each index lives on its own cache line next to the other side's index as last seen, so the
+// two threads only touch each other's line when the cached value says the queue looks full or
+// empty.
+template <typename T, size_t N>
+class SpscRing
+{
+	static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+public:
+	SpscRing() = default;
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	// Producer side
+	T* beginWrite()
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (head - m_tailCache >= N)
+		{
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			if (head - m_tailCache >= N)
+			{
+				m_overruns.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+		}
+		return &m_slots[head & MASK];
+	}
+
+	void commitWrite()
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer side
+	const T* peek()
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == m_headCache)
+		{
+			m_headCache = m_head.load(std::memory_order_acquire);
+			if (tail == m_headCache)
+			{
+				return nullptr;
+			}
+		}
+		return &m_slots[tail & MASK];
+	}
+
+	void pop()
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Either side, a snapshot that may already be stale
+	size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+	uint64_t overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+	static constexpr size_t capacity() { return N; }
+
+	// Every slot, for preallocating them before the two sides start running
+	T* slots() { return m_slots; }
+
+	// Only while neither side is running
+	void reset()
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+		m_tailCache = m_headCache = 0;
+		m_overruns.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr size_t MASK = N - 1;
+
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t>	m_head{};		// Next slot to write
+	size_t											m_tailCache{};	// Producer's copy of m_tail
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t>	m_tail{};		// Next slot to read
+	size_t											m_headCache{};	// Consumer's copy of m_head
+	alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>	m_overruns{};	// Slots the producer had to drop
+	alignas(CACHE_LINE_SIZE) T						m_slots[N]{};
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
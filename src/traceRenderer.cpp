@@ -0,0 +1,144 @@
+#include "traceRenderer.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TraceRenderer::reserve(int traceCount, Uint32 pointsPerTrace)
+{
+	m_capacity = pointsPerTrace;
+	m_traces.resize(traceCount);
+	for (Trace& trace : m_traces)
+	{
+		trace.count = 0;
+		trace.points.assign(m_capacity, SDL_FPoint{});
+		trace.vertices.assign(m_capacity > 1 ? (size_t)(m_capacity - 1) * 4 : 0, SDL_Vertex{});
+		trace.spans.assign(m_capacity, SDL_FRect{});
+	}
+
+	// Segment i is the quad of vertices 4i .. 4i + 3, as two triangles
+	const Uint32 segments = m_capacity > 1 ? m_capacity - 1 : 0;
+	m_quadIndices.resize((size_t)segments * 6);
+	for (Uint32 i = 0; i < segments; ++i)
+	{
+		const int v = (int)(4 * i);
+		int* pIndex = m_quadIndices.data() + (size_t)6 * i;
+		pIndex[0] = v;
+		pIndex[1] = v + 1;
+		pIndex[2] = v + 2;
+		pIndex[3] = v + 2;
+		pIndex[4] = v + 1;
+		pIndex[5] = v + 3;
+	}
+}
+
+void TraceRenderer::setStyle(int trace, const TraceStyle& style)
+{
+	m_traces[trace].style = style;
+}
+
+void TraceRenderer::setColumns(int trace, const MinMaxColumn* pColumns, Uint32 columns, const SDL_FRect& area)
+{
+	Trace& t = m_traces[trace];
+	t.bSpans = true;
+	t.count = std::min(columns, m_capacity);
+	if (t.count == 0)
+	{
+		return;
+	}
+
+	const float columnWidth = area.w / t.count;
+	const float spanWidth = std::max(columnWidth, 1.0f);
+	const float pad = std::max(t.style.thickness, 1.0f);
+	const float bottom = area.y + area.h;
+	SDL_FRect* pSpans = t.spans.data();
+	for (Uint32 c = 0; c < t.count; ++c)
+	{
+		float lo = pColumns[c].min;
+		float hi = pColumns[c].max;
+		if (c > 0)
+		{
+			// Close the gap to the previous column
+			lo = std::min(lo, pColumns[c - 1].max);
+			hi = std::max(hi, pColumns[c - 1].min);
+		}
+		pSpans[c].x = area.x + c * columnWidth;
+		pSpans[c].w = spanWidth;
+		pSpans[c].y = bottom - hi - pad / 2;
+		pSpans[c].h = hi - lo + pad;
+	}
+}
+
+void TraceRenderer::draw(SDL_Renderer* pRenderer)
+{
+	SDL_RenderSetScale(pRenderer, 1.0f, 1.0f);
+	for (Trace& trace : m_traces)
+	{
+		if (trace.bSpans && trace.count > 0)
+		{
+			const SDL_Color& c = trace.style.color;
+			SDL_SetRenderDrawColor(pRenderer, c.r, c.g, c.b, c.a);
+			SDL_RenderFillRectsF(pRenderer, trace.spans.data(), (int)trace.count);
+			continue;
+		}
+		if (trace.count < 2)
+		{
+			continue;
+		}
+		if (trace.style.thickness > 1.0f)
+		{
+			drawThick(pRenderer, trace);
+		}
+		else
+		{
+			const SDL_Color& c = trace.style.color;
+			SDL_SetRenderDrawColor(pRenderer, c.r, c.g, c.b, c.a);
+			SDL_RenderDrawLinesF(pRenderer, trace.points.data(), (int)trace.count);
+		}
+	}
+}
+
+void TraceRenderer::drawThick(SDL_Renderer* pRenderer, Trace& trace)
+{
+	const float halfWidth = trace.style.thickness / 2;
+	const SDL_Color color = trace.style.color;
+	const SDL_FPoint* pPoints = trace.points.data();
+	SDL_Vertex* pVertex = trace.vertices.data();
+
+	const Uint32 segments = trace.count - 1;
+	for (Uint32 i = 0; i < segments; ++i, pVertex += 4)
+	{
+		const SDL_FPoint& p0 = pPoints[i];
+		const SDL_FPoint& p1 = pPoints[i + 1];
+
+		// Offset both ends along the segment normal
+		const float dx = p1.x - p0.x;
+		const float dy = p1.y - p0.y;
+		const float len = std::sqrt(dx * dx + dy * dy);
+		const float nx = len > 0 ? -dy * halfWidth / len : 0.0f;
+		const float ny = len > 0 ? dx * halfWidth / len : halfWidth;
+
+		pVertex[0].position = { p0.x + nx, p0.y + ny };
+		pVertex[1].position = { p0.x - nx, p0.y - ny };
+		pVertex[2].position = { p1.x + nx, p1.y + ny };
+		pVertex[3].position = { p1.x - nx, p1.y - ny };
+		for (int k = 0; k < 4; ++k)
+		{
+			pVertex[k].color = color;
+		}
+	}
+	SDL_RenderGeometry(pRenderer, nullptr, trace.vertices.data(), (int)segments * 4, m_quadIndices.data(), (int)segments * 6);
+}
+
+void TraceRenderer::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "TraceRenderer: \n");
+	Logger::LOG_MSG(prefix, "    Traces             : ", m_traces.size(), ", up to ", m_capacity, " points each\n");
+	for (size_t i = 0; i < m_traces.size(); ++i)
+	{
+		const TraceStyle& style = m_traces[i].style;
+		Logger::LOG_MSG(prefix, "    Trace ", i, "            : ", m_traces[i].count, m_traces[i].bSpans ? " spans" : " points", ", thickness ", style.thickness,
+			", color(", (int)style.color.r, ',', (int)style.color.g, ',', (int)style.color.b, ',', (int)style.color.a, ")\n");
+	}
+}
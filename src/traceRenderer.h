@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+#include "minMaxDecimator.h"
+
+struct TraceStyle
+{
+	SDL_Color	color{ 127, 255, 0, SDL_ALPHA_OPAQUE };		// Chartreuse
+	float		thickness{ 1.0f };							// In pixels, above 1 the trace is drawn as triangles
+};
+
+// Draws sample traces, one renderer call per trace.
+//
+// Every trace owns preallocated points and spans, setSamples() and setColumns() only rewrite
+// them, so drawing a frame allocates nothing. A polyline goes out with one
+// SDL_RenderDrawLinesF() when thin, or as one SDL_RenderGeometry() with a quad per segment,
+// whose index list never changes, when thick. Decimated traces are a vertical span per pixel
+// column drawn with one SDL_RenderFillRectsF(), so their cost only depends on the width.
+class TraceRenderer
+{
+public:
+	// Allocates traceCount traces of up to pointsPerTrace points or columns each
+	void reserve(int traceCount, Uint32 pointsPerTrace);
+
+	INLINE int traceCount() const { return (int)m_traces.size(); }
+	INLINE Uint32 capacity() const { return m_capacity; }
+
+	void setStyle(int trace, const TraceStyle& style);
+	INLINE const TraceStyle& getStyle(int trace) const { return m_traces[trace].style; }
+
+	// Lays count samples out across area, one every area.w / count pixels starting at its
+	// left edge. A sample of value v sits v pixels above the bottom of area. count is
+	// clamped to capacity(). xOffset moves every sample right by that many samples, a
+	// fraction of one keeps a sub-sample trigger position at the left edge. A last sample
+	// moved past the right edge is pulled back onto it along the last segment.
+	template <typename T>
+	void setSamples(int trace, const T* pSamples, Uint32 count, const SDL_FRect& area, float xOffset = 0.0f);
+
+	// Draws the trace as one vertical span per column, from min to max, across area. Each
+	// span also reaches its neighbours so the trace stays connected. columns is clamped to
+	// capacity().
+	void setColumns(int trace, const MinMaxColumn* pColumns, Uint32 columns, const SDL_FRect& area);
+
+	// Hides the trace until the next setSamples() or setColumns()
+	INLINE void clearTrace(int trace) { m_traces[trace].count = 0; }
+
+	// Draws every trace with at least two points, in order, at render scale 1
+	void draw(SDL_Renderer* pRenderer);
+
+	void print(const std::string& prefix = "") const;
+private:
+	struct Trace
+	{
+		TraceStyle					style;
+		Uint32						count{};		// # of points, or of spans when bSpans
+		bool						bSpans{};
+		std::vector<SDL_FPoint>		points;
+		std::vector<SDL_Vertex>		vertices;		// 4 per segment, only used by thick traces
+		std::vector<SDL_FRect>		spans;
+	};
+
+	void drawThick(SDL_Renderer* pRenderer, Trace& trace);
+private:
+	std::vector<Trace>	m_traces;
+	std::vector<int>	m_quadIndices;		// 6 per segment, shared by all thick traces
+	Uint32				m_capacity{};
+};
+
+template <typename T>
+void TraceRenderer::setSamples(int trace, const T* pSamples, Uint32 count, const SDL_FRect& area, float xOffset)
+{
+	Trace& t = m_traces[trace];
+	t.bSpans = false;
+	t.count = count < m_capacity ? count : m_capacity;
+	if (t.count == 0)
+	{
+		return;
+	}
+
+	const float xStep = area.w / t.count;
+	const float left = area.x + xOffset * xStep;
+	const float bottom = area.y + area.h;
+	SDL_FPoint* pPoints = t.points.data();
+	for (Uint32 i = 0; i < t.count; ++i)
+	{
+		pPoints[i].x = left + i * xStep;
+		pPoints[i].y = bottom - static_cast<float>(pSamples[i]);
+	}
+
+	// The offset moves the trace right, its last segment is cut at the right edge
+	const float right = area.x + area.w;
+	SDL_FPoint& last = pPoints[t.count - 1];
+	if (last.x > right)
+	{
+		if (t.count > 1)
+		{
+			const SDL_FPoint& before = pPoints[t.count - 2];
+			last.y = before.y + (last.y - before.y) * (right - before.x) / (last.x - before.x);
+		}
+		last.x = right;
+	}
+}
@@ -0,0 +1,302 @@
+#include "trigger.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+// First of n samples at or below t when bBelow, at or above t otherwise, n when none
+template <typename T>
+INLINE Uint32 findScalar(const T* p, Uint32 n, T t, bool bBelow)
+{
+	for (Uint32 i = 0; i < n; ++i)
+	{
+		if (bBelow ? p[i] <= t : p[i] >= t)
+		{
+			return i;
+		}
+	}
+	return n;
+}
+
+#if OSC_X86
+// Signed compares only, unsigned bytes and words are moved into the signed range by flipping
+// the top bit, which keeps their order
+template <typename T>
+OSC_TARGET_SSE2 INLINE __m128i flipSse2(__m128i v)
+{
+	if constexpr (std::is_same_v<T, Uint8>)
+	{
+		return _mm_xor_si128(v, _mm_set1_epi8((char)0x80));
+	}
+	else if constexpr (std::is_same_v<T, Uint16>)
+	{
+		return _mm_xor_si128(v, _mm_set1_epi16((short)0x8000));
+	}
+	else
+	{
+		return v;
+	}
+}
+
+template <typename T>
+OSC_TARGET_SSE2 INLINE __m128i greaterSse2(__m128i a, __m128i b)
+{
+	if constexpr (sizeof(T) == 1)
+	{
+		return _mm_cmpgt_epi8(a, b);
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		return _mm_cmpgt_epi16(a, b);
+	}
+	else
+	{
+		return _mm_cmpgt_epi32(a, b);
+	}
+}
+
+template <typename T>
+OSC_TARGET_SSE2 INLINE __m128i set1Sse2(T t)
+{
+	if constexpr (sizeof(T) == 1)
+	{
+		return _mm_set1_epi8((char)t);
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		return _mm_set1_epi16((short)t);
+	}
+	else
+	{
+		return _mm_set1_epi32((int)t);
+	}
+}
+
+INLINE Uint32 lowestBit(Uint32 mask)
+{
+	Uint32 bit = 0;
+	while ((mask & 1) == 0)
+	{
+		mask >>= 1;
+		++bit;
+	}
+	return bit;
+}
+
+// findScalar() a vector at a time. The compare gives a byte mask, the first set bit is the
+// first matching sample.
+template <typename T>
+OSC_TARGET_SSE2 Uint32 findSse2(const T* p, Uint32 n, T t, bool bBelow)
+{
+	constexpr Uint32 LANES = 16 / sizeof(T);
+	Uint32 i = 0;
+	if constexpr (std::is_same_v<T, float>)
+	{
+		const __m128 vt = _mm_set1_ps(t);
+		for (; i + LANES <= n; i += LANES)
+		{
+			const __m128 v = _mm_loadu_ps(p + i);
+			const int mask = _mm_movemask_ps(bBelow ? _mm_cmple_ps(v, vt) : _mm_cmpge_ps(v, vt));
+			if (mask != 0)
+			{
+				return i + lowestBit((Uint32)mask);
+			}
+		}
+	}
+	else
+	{
+		// v <= t is !(v > t) and v >= t is !(t > v)
+		const __m128i vt = flipSse2<T>(set1Sse2<T>(t));
+		for (; i + LANES <= n; i += LANES)
+		{
+			const __m128i v = flipSse2<T>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+			const __m128i greater = bBelow ? greaterSse2<T>(v, vt) : greaterSse2<T>(vt, v);
+			const Uint32 mask = ~(Uint32)_mm_movemask_epi8(greater) & 0xffff;
+			if (mask != 0)
+			{
+				return i + lowestBit(mask) / sizeof(T);
+			}
+		}
+	}
+	return i + findScalar(p + i, n - i, t, bBelow);
+}
+#endif // OSC_X86
+
+// Level as the T that find() compares against, <= when bBelow and >= otherwise. bStrict makes
+// it < or >, integers move one step and floats to the next representable value. false when
+// no T can pass the compare.
+template <typename T>
+INLINE bool threshold(float level, bool bBelow, bool bStrict, T& t)
+{
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		t = bStrict ? std::nextafter(level, bBelow ? -INFINITY : INFINITY) : level;
+		return true;
+	}
+	else
+	{
+		constexpr double lowest = (double)std::numeric_limits<T>::lowest();
+		constexpr double highest = (double)std::numeric_limits<T>::max();
+		double d = bBelow ? std::floor(level) : std::ceil(level);
+		if (bStrict && d == level)
+		{
+			d += bBelow ? -1.0 : 1.0;
+		}
+		if (bBelow ? d < lowest : d > highest)
+		{
+			return false;
+		}
+		t = static_cast<T>(std::clamp(d, lowest, highest));
+		return true;
+	}
+}
+
+template <typename T>
+Uint32 find(const T* pSamples, Uint32 count, T t, bool bBelow, bool bSse2)
+{
+#if OSC_X86
+	if (bSse2)
+	{
+		return findSse2(pSamples, count, t, bBelow);
+	}
+#endif
+	(void)bSse2;
+	return findScalar(pSamples, count, t, bBelow);
+}
+
+// First preset above value, the first one past the last
+template <size_t N>
+float nextPreset(const float (&presets)[N], float value)
+{
+	for (float preset : presets)
+	{
+		if (preset > value)
+		{
+			return preset;
+		}
+	}
+	return presets[0];
+}
+
+template <typename T>
+Uint32 findTrigger(const T* pSamples, Uint32 count, const TriggerLevels& levels, bool& bArmed, bool bSse2)
+{
+	// Rising arms below the arm level and fires at or above the fire level, falling the other way
+	const bool bRising = levels.slope == TriggerSlope::RISING;
+	T arm{};
+	T fire{};
+	const bool bCanArm = threshold(levels.arm, bRising, true, arm);
+	if (!threshold(levels.fire, !bRising, false, fire))
+	{
+		return count;
+	}
+
+	Uint32 i = 0;
+	if (!bArmed)
+	{
+		i = bCanArm ? find(pSamples, count, arm, bRising, bSse2) : count;
+		if (i == count)
+		{
+			return count;
+		}
+		bArmed = true;
+	}
+	i += find(pSamples + i, count - i, fire, !bRising, bSse2);
+	if (i < count)
+	{
+		bArmed = false;
+	}
+	return i;
+}
+}
+
+std::string triggerMode2String(TriggerMode mode)
+{
+	switch (mode)
+	{
+		case TriggerMode::AUTO:		return "Auto";
+		case TriggerMode::NORMAL:	return "Normal";
+		case TriggerMode::SINGLE:	return "Single";
+		default:					return "Unknown";
+	}
+}
+
+std::string triggerSlope2String(TriggerSlope slope)
+{
+	switch (slope)
+	{
+		case TriggerSlope::RISING:	return "Rising";
+		case TriggerSlope::FALLING:	return "Falling";
+		default:					return "Unknown";
+	}
+}
+
+void TriggerSettings::setNextMode()
+{
+	mode = (TriggerMode)(((int)mode + 1) % (int)TriggerMode::MAX);
+}
+
+void TriggerSettings::setNextSlope()
+{
+	slope = (TriggerSlope)(((int)slope + 1) % (int)TriggerSlope::MAX);
+}
+
+void TriggerSettings::changeLevel(float delta)
+{
+	level = std::clamp(level + delta, -1.0f, 1.0f);
+}
+
+void TriggerSettings::setNextHysteresis()
+{
+	constexpr float presets[] = { 0.0f, 0.02f, 0.05f, 0.1f, 0.2f };
+	hysteresis = nextPreset(presets, hysteresis);
+}
+
+void TriggerSettings::setNextHoldoff()
+{
+	constexpr float presets[] = { 0.0f, 1.0f, 5.0f, 20.0f, 100.0f };
+	holdoffMs = nextPreset(presets, holdoffMs);
+}
+
+float displaySampleAt(const void* pSamples, SDL_AudioFormat format, Uint32 index)
+{
+	switch (format)
+	{
+		case AUDIO_S8:	return static_cast<const Sint8*>(pSamples)[index];
+		case AUDIO_U8:	return static_cast<const Uint8*>(pSamples)[index];
+		case AUDIO_S16:	return static_cast<const Sint16*>(pSamples)[index];
+		case AUDIO_U16:	return static_cast<const Uint16*>(pSamples)[index];
+		case AUDIO_S32:	return (float)static_cast<const Sint32*>(pSamples)[index];
+		case AUDIO_F32:	return static_cast<const float*>(pSamples)[index];
+		default:		return 0.0f;
+	}
+}
+
+float crossingOffset(float previous, float fired, float level)
+{
+	const float rise = fired - previous;
+	if (rise == 0.0f)
+	{
+		return 0.0f;
+	}
+	return std::clamp((fired - level) / rise, 0.0f, 1.0f);
+}
+
+Uint32 findTrigger(const void* pSamples, SDL_AudioFormat format, Uint32 count, const TriggerLevels& levels, bool& bArmed, SimdLevel level)
+{
+	const bool bSse2 = OSC_X86 && level >= SimdLevel::SSE2;
+	switch (format)
+	{
+		case AUDIO_S8:	return findTrigger(static_cast<const Sint8*>(pSamples), count, levels, bArmed, bSse2);
+		case AUDIO_U8:	return findTrigger(static_cast<const Uint8*>(pSamples), count, levels, bArmed, bSse2);
+		case AUDIO_S16:	return findTrigger(static_cast<const Sint16*>(pSamples), count, levels, bArmed, bSse2);
+		case AUDIO_U16:	return findTrigger(static_cast<const Uint16*>(pSamples), count, levels, bArmed, bSse2);
+		case AUDIO_S32:	return findTrigger(static_cast<const Sint32*>(pSamples), count, levels, bArmed, bSse2);
+		case AUDIO_F32:	return findTrigger(static_cast<const float*>(pSamples), count, levels, bArmed, bSse2);
+		default:		return count;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <SDL_audio.h>
+#include "constants.h"
+#include "waveKernels.h"
+
+enum class TriggerMode
+{
+	AUTO,			// Triggered frames, and an untriggered one when nothing triggers for a while
+	NORMAL,			// Triggered frames only, the last one stays up until the next trigger
+	SINGLE,			// One triggered frame, then nothing until re-armed
+	MAX
+};
+
+enum class TriggerSlope
+{
+	RISING,
+	FALLING,
+	MAX
+};
+
+extern std::string triggerMode2String(TriggerMode mode);
+extern std::string triggerSlope2String(TriggerSlope slope);
+
+// UI side trigger setup, levels are fractions of half the display height around the centre
+struct TriggerSettings
+{
+	TriggerMode		mode{ TriggerMode::AUTO };
+	TriggerSlope	slope{ TriggerSlope::RISING };
+	float			level{};				// [-1, 1]
+	float			hysteresis{ 0.05f };	// How far past the level the signal has to come from
+	float			holdoffMs{};			// After a frame, before the next trigger is looked for
+	float			autoTimeoutMs{ 100.0f };	// AUTO frames start untriggered after this long without a trigger
+
+	void setNextMode();
+	void setNextSlope();
+	void changeLevel(float delta);		// Clamped to [-1, 1]
+	void setNextHysteresis();			// Cycles through a few presets
+	void setNextHoldoff();				// Cycles through a few presets
+};
+
+// Trigger in display units and samples, as the audio thread uses it
+struct TriggerLevels
+{
+	TriggerSlope	slope{ TriggerSlope::RISING };
+	float			arm{};			// Rising: armed below, falling: armed above
+	float			fire{};			// Rising: fires at or above, falling: fires at or below, once armed
+};
+
+// Index of the first sample of count display samples in format that fires the trigger,
+// count when none does. bArmed carries the hysteresis state from one call to the next: the
+// signal has to reach the arm level before a crossing of the fire level counts, so noise
+// around the level cannot fire it again and again. Both searches scan 16 bytes of samples
+// at a time with SSE2.
+extern Uint32 findTrigger(const void* pSamples, SDL_AudioFormat format, Uint32 count, const TriggerLevels& levels, bool& bArmed,
+	SimdLevel level = detectSimdLevel());
+
+// Display sample at index, as a float
+extern float displaySampleAt(const void* pSamples, SDL_AudioFormat format, Uint32 index);
+
+// Where the signal crossed level between previous and the sample after it that fired, as
+// the fraction of a sample before the fired one. Linear interpolation, in [0, 1].
+extern float crossingOffset(float previous, float fired, float level);
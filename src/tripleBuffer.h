@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Single writer, single reader hand off of the latest value of T, wait-free on both sides.
+//
+// There are three slots: the writer owns one, the reader owns one and the third sits in
+// between holding the most recently published value. publish() and update() just swap
+// their own slot with the middle one, so neither side ever sees a slot the other one
+// is working on, and neither side ever waits.
+//
+// The writer gets back an old slot after publish(), it has to fully rewrite it.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer side
+	T& back() { return m_slots[m_writeIndex]; }
+
+	void publish()
+	{
+		const uint8_t prev = m_middle.exchange(m_writeIndex | DIRTY, std::memory_order_acq_rel);
+		m_writeIndex = prev & INDEX_MASK;
+	}
+
+	// Reader side, returns true when a newer value was picked up
+	bool update()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & DIRTY) == 0)
+		{
+			return false;
+		}
+		const uint8_t prev = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+		m_readIndex = prev & INDEX_MASK;
+		return true;
+	}
+
+	T& front() { return m_slots[m_readIndex]; }
+	const T& front() const { return m_slots[m_readIndex]; }
+
+	// Every slot, for preallocating them before the two sides start running
+	T* slots() { return m_slots; }
+	static constexpr int SLOT_COUNT = 3;
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t DIRTY = 0x4;
+
+	T						m_slots[SLOT_COUNT]{};
+	uint8_t					m_writeIndex{ 2 };
+	uint8_t					m_readIndex{ 0 };
+	std::atomic<uint8_t>	m_middle{ 1 };
+};
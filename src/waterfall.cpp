@@ -0,0 +1,141 @@
+#include "waterfall.h"
+#include "logger.h"
+
+#include <algorithm>
+
+Waterfall::Waterfall()
+{
+	setRange(m_floorDb, 0.0f);
+}
+
+void Waterfall::setSize(int width, int height)
+{
+	m_width = std::max(width, 1);
+	m_height = std::max(height, 1);
+	m_texture.setSize(m_width, m_height);
+	m_head = 0;
+	m_columnsWritten = 0;
+	m_pushTicks = 0;
+}
+
+void Waterfall::setRange(float floorDb, float topDb)
+{
+	m_floorDb = floorDb;
+	m_lutPerDb = (LUT_SIZE - 1) / std::max(topDb - floorDb, 1.0f);
+	buildLut();
+}
+
+void Waterfall::buildLut()
+{
+	// Black through purple, red and orange to pale yellow, brighter is louder
+	constexpr ColorStop stops[] =
+	{
+		{ 0.00f,   0.0f,   0.0f,   0.0f },
+		{ 0.25f,  40.0f,  10.0f, 100.0f },
+		{ 0.50f, 180.0f,  30.0f,  80.0f },
+		{ 0.75f, 250.0f, 140.0f,  20.0f },
+		{ 1.00f, 255.0f, 255.0f, 200.0f },
+	};
+	buildColorRamp(stops, (int)(sizeof(stops) / sizeof(stops[0])), m_lut.data(), LUT_SIZE);
+}
+
+void Waterfall::update(const std::vector<SDL_Event>& events)
+{
+	// push() makes a blank texture once the device lost it
+	m_texture.update(events);
+}
+
+void Waterfall::push(SDL_Renderer* pRenderer, const float* pDb, Uint32 count)
+{
+	if (count == 0 || m_width == 0)
+	{
+		return;
+	}
+	bool bCreated = false;
+	SDL_Texture* pTexture = m_texture.acquire(pRenderer, bCreated);
+	if (!pTexture)
+	{
+		return;
+	}
+
+	// A new texture starts out at the quietest colour, the only time all of it is written
+	if (bCreated)
+	{
+		void* pPixels = nullptr;
+		int pitch = 0;
+		if (SDL_LockTexture(pTexture, nullptr, &pPixels, &pitch) == 0)
+		{
+			for (int y = 0; y < m_height; ++y)
+			{
+				Uint32* pRow = reinterpret_cast<Uint32*>(static_cast<Uint8*>(pPixels) + (size_t)y * pitch);
+				std::fill_n(pRow, m_width, m_lut[0]);
+			}
+			SDL_UnlockTexture(pTexture);
+		}
+		m_head = 0;
+	}
+
+	const Uint64 start = SDL_GetPerformanceCounter();
+	const SDL_Rect column{ m_head, 0, 1, m_height };
+	void* pPixels = nullptr;
+	int pitch = 0;
+	if (SDL_LockTexture(pTexture, &column, &pPixels, &pitch) != 0)
+	{
+		ns_Util::Logger::LOG_SDL_ERROR("Waterfall: can not lock the texture");
+		return;
+	}
+
+	// Row 0 is the top, the highest frequencies
+	Uint8* pColumn = static_cast<Uint8*>(pPixels);
+	for (int y = 0; y < m_height; ++y)
+	{
+		const Uint32 row = (Uint32)(m_height - 1 - y);
+		const Uint32 first = (Uint32)((Uint64)row * count / m_height);
+		const Uint32 last = std::max((Uint32)((Uint64)(row + 1) * count / m_height), first + 1);
+		const float db = *std::max_element(pDb + first, pDb + std::min(last, count));
+		const int index = std::clamp((int)((db - m_floorDb) * m_lutPerDb), 0, LUT_SIZE - 1);
+		*reinterpret_cast<Uint32*>(pColumn + (size_t)y * pitch) = m_lut[index];
+	}
+	SDL_UnlockTexture(pTexture);
+
+	m_head = (m_head + 1) % m_width;
+	++m_columnsWritten;
+	m_pushTicks += SDL_GetPerformanceCounter() - start;
+}
+
+void Waterfall::draw(SDL_Renderer* pRenderer, const SDL_Rect& area)
+{
+	SDL_Texture* pTexture = m_texture.get(pRenderer);
+	if (!pTexture)
+	{
+		return;
+	}
+
+	// Columns [m_head, m_width) are the oldest and go on the left, [0, m_head) follow them
+	const int older = m_width - m_head;
+	const int split = (int)((Sint64)older * area.w / m_width);
+	const SDL_Rect oldSrc{ m_head, 0, older, m_height };
+	const SDL_Rect oldDst{ area.x, area.y, split, area.h };
+	SDL_RenderCopy(pRenderer, pTexture, &oldSrc, &oldDst);
+	if (m_head > 0)
+	{
+		const SDL_Rect newSrc{ 0, 0, m_head, m_height };
+		const SDL_Rect newDst{ area.x + split, area.y, area.w - split, area.h };
+		SDL_RenderCopy(pRenderer, pTexture, &newSrc, &newDst);
+	}
+}
+
+void Waterfall::releaseTexture()
+{
+	m_texture.release();
+}
+
+void Waterfall::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "Waterfall: \n");
+	Logger::LOG_MSG(prefix, "    Size               : ", m_width, " spectra of ", m_height, " rows\n");
+	Logger::LOG_MSG(prefix, "    Texture            : ", m_texture.isCreated() ? "Streaming" : "None", ", built ", m_texture.builds(), " times\n");
+	Logger::LOG_MSG(prefix, "    Columns written    : ", m_columnsWritten, ", ",
+		m_columnsWritten > 0 ? m_pushTicks * 1e6 / SDL_GetPerformanceFrequency() / m_columnsWritten : 0.0, " us each\n");
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "constants.h"
+#include "colorRamp.h"
+
+// Spectrogram that scrolls from right to left, time across and frequency up.
+//
+// The image is a streaming texture used as a ring of columns. push() locks only the column
+// it writes, the oldest one, and draw() shows the ring oldest first with two SDL_RenderCopy()
+// calls split at the write position. Nothing is shifted or uploaded again, so a spectrum and
+// a frame cost the same after a minute as after hours. Levels become colours through a
+// LUT_SIZE entry table built once.
+class Waterfall
+{
+public:
+	static constexpr int LUT_SIZE = 256;
+
+	Waterfall();
+
+	Waterfall(const Waterfall&) = delete;
+	Waterfall& operator=(const Waterfall&) = delete;
+
+	// width spectra of history, each reduced to height rows. Starts over blank.
+	void setSize(int width, int height);
+
+	// Levels at and below floorDb get the first colour, at and above topDb the last one
+	void setRange(float floorDb, float topDb);
+
+	// Device resets drop the texture, the next push() starts a blank one
+	void update(const std::vector<SDL_Event>& events);
+
+	// Writes one spectrum as the newest column, pDb holds count levels from the lowest
+	// frequency to the highest. A row covering several levels shows the loudest of them.
+	void push(SDL_Renderer* pRenderer, const float* pDb, Uint32 count);
+
+	// Whole history into area, oldest column at the left
+	void draw(SDL_Renderer* pRenderer, const SDL_Rect& area);
+
+	// Before the renderer goes, the history is lost with the texture
+	void releaseTexture();
+
+	INLINE Uint64 columnsWritten() const { return m_columnsWritten; }
+
+	void print(const std::string& prefix = "") const;
+private:
+	void buildLut();
+private:
+	int								m_width{};
+	int								m_height{};
+	float							m_floorDb{ -120.0f };
+	float							m_lutPerDb{};		// LUT entries per dB above m_floorDb
+	std::array<Uint32, LUT_SIZE>	m_lut{};			// SDL_PIXELFORMAT_ARGB8888
+
+	StreamingTexture				m_texture{ "Waterfall", SDL_BLENDMODE_NONE };
+	int								m_head{};			// Column written next, the oldest one
+	Uint64							m_columnsWritten{};
+	Uint64							m_pushTicks{};		// SDL_GetPerformanceCounter() ticks spent in push()
+};
@@ -0,0 +1,456 @@
+#include "wavFile.h"
+#include "sampleFormat.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+// WAV is little endian
+INLINE Uint16 readLE16(const Uint8* p) { return (Uint16)(p[0] | p[1] << 8); }
+INLINE Uint32 readLE32(const Uint8* p) { return (Uint32)p[0] | (Uint32)p[1] << 8 | (Uint32)p[2] << 16 | (Uint32)p[3] << 24; }
+INLINE Uint64 readLE64(const Uint8* p) { return (Uint64)readLE32(p) | (Uint64)readLE32(p + 4) << 32; }
+INLINE void writeLE16(Uint8* p, Uint16 v) { p[0] = (Uint8)v; p[1] = (Uint8)(v >> 8); }
+INLINE void writeLE32(Uint8* p, Uint32 v) { writeLE16(p, (Uint16)v); writeLE16(p + 2, (Uint16)(v >> 16)); }
+INLINE void writeLE64(Uint8* p, Uint64 v) { writeLE32(p, (Uint32)v); writeLE32(p + 4, (Uint32)(v >> 32)); }
+
+constexpr Uint16 WAVE_FORMAT_PCM = 1;
+constexpr Uint16 WAVE_FORMAT_IEEE_FLOAT = 3;
+constexpr Uint16 WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Header PcmWriter writes: RIFF, a JUNK chunk the size of a ds64 one, fmt and the data chunk
+// header. The fmt chunk is the extensible one for more than 2 channels or 16 bits.
+constexpr size_t DS64_BYTES = 28;
+constexpr size_t FMT_BYTES = 16;
+constexpr size_t FMT_EXTENSIBLE_BYTES = 40;
+constexpr size_t WAV_HEADER_BYTES = 12 + 8 + DS64_BYTES + 8 + FMT_EXTENSIBLE_BYTES + 8;
+
+// Tail of the KSDATAFORMAT_SUBTYPE GUIDs, the first 2 bytes are the plain format tag
+constexpr Uint8 SUBFORMAT_GUID_TAIL[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+// Speakers in the order SDL lays out the channels, 0 leaves them unassigned
+Uint32 channelMask(int channels)
+{
+	switch (channels)
+	{
+		case MONO:		return 0x4;		// Front centre
+		case STEREO:	return 0x3;		// Front left, front right
+		case QUAD:		return 0x33;	// Front left, front right, back left, back right
+		case HEXA:		return 0x3F;	// Front left, front right, front centre, LFE, back left, back right
+		default:		return 0;
+	}
+}
+
+std::string lowerCaseExtension(const std::string& path)
+{
+	const size_t dot = path.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return extension;
+}
+
+bool parsePositive(const std::string& text, int& value)
+{
+	char* pEnd = nullptr;
+	const long v = std::strtol(text.c_str(), &pEnd, 10);
+	if (text.empty() || *pEnd != '\0' || v <= 0 || v > 1000000)
+	{
+		return false;
+	}
+	value = (int)v;
+	return true;
+}
+
+// Samples may sit at any offset in the mapping, memcpy reads them unaligned
+template <typename T>
+void toFloat(const Uint8* pSrc, float* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		T v{};
+		memcpy(&v, pSrc + i * sizeof(T), sizeof(T));
+		pDst[i] = toNormalizedSample(v);
+	}
+}
+
+void packed24ToFloat(const Uint8* pSrc, float* pDst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i, pSrc += 3)
+	{
+		// Into the top of 32 bits, then an arithmetic shift back sign extends it
+		const Sint32 v = (Sint32)((Uint32)pSrc[0] << 8 | (Uint32)pSrc[1] << 16 | (Uint32)pSrc[2] << 24) >> 8;
+		pDst[i] = (float)(v / 8388607.0);
+	}
+}
+}
+
+bool PcmLayout::parse(const std::string& text, PcmLayout& layout)
+{
+	const size_t first = text.find(':');
+	const size_t second = first == std::string::npos ? std::string::npos : text.find(':', first + 1);
+	if (second == std::string::npos)
+	{
+		return false;
+	}
+
+	PcmLayout parsed;
+	const std::string format = text.substr(0, first);
+	if (format == "S8")			parsed.format = AUDIO_S8;
+	else if (format == "U8")	parsed.format = AUDIO_U8;
+	else if (format == "S16")	parsed.format = AUDIO_S16;
+	else if (format == "U16")	parsed.format = AUDIO_U16;
+	else if (format == "S32")	parsed.format = AUDIO_S32;
+	else if (format == "F32")	parsed.format = AUDIO_F32;
+	else if (format == "S24")
+	{
+		parsed.format = AUDIO_S32;
+		parsed.bPacked24 = true;
+	}
+	else
+	{
+		return false;
+	}
+	if (!parsePositive(text.substr(first + 1, second - first - 1), parsed.channels)
+		|| !parsePositive(text.substr(second + 1), parsed.sampleRate))
+	{
+		return false;
+	}
+	layout = parsed;
+	return true;
+}
+
+std::string PcmLayout::toString() const
+{
+	return (bPacked24 ? std::string("AUDIO_S24") : audioFormat2String(format)) + ", " + std::to_string(channels) + " channels at "
+		+ std::to_string(sampleRate) + " Hz";
+}
+
+bool PcmFile::handles(const std::string& path)
+{
+	const std::string extension = lowerCaseExtension(path);
+	return extension == "wav" || extension == "raw" || extension == "pcm";
+}
+
+bool PcmFile::open(const std::string& path, const PcmLayout& rawLayout)
+{
+	close();
+	if (!m_file.open(path))
+	{
+		return false;
+	}
+	m_path = path;
+	m_bWav = lowerCaseExtension(path) == "wav";
+	if (m_bWav)
+	{
+		if (!parseWav())
+		{
+			close();
+			return false;
+		}
+	}
+	else
+	{
+		if (!rawLayout.valid())
+		{
+			ns_Util::Logger::LOG_ERROR("No sample layout for ", path, '\n');
+			close();
+			return false;
+		}
+		m_layout = rawLayout;
+		m_pFrames = m_file.data();
+		m_frameCount = m_file.size() / m_layout.frameBytes();
+	}
+	m_lastAdvised = m_prefetchedTo = m_releasedTo = 0;
+	return true;
+}
+
+void PcmFile::close()
+{
+	m_file.close();
+	m_layout = PcmLayout{};
+	m_pFrames = nullptr;
+	m_frameCount = 0;
+}
+
+bool PcmFile::parseWav()
+{
+	const Uint8* pFile = m_file.data();
+	const Uint64 size = m_file.size();
+	if (size < 12 || (memcmp(pFile, "RIFF", 4) != 0 && memcmp(pFile, "RF64", 4) != 0) || memcmp(pFile + 8, "WAVE", 4) != 0)
+	{
+		ns_Util::Logger::LOG_ERROR(m_path, " is not a WAV file\n");
+		return false;
+	}
+
+	// Only the chunk headers are read, they all sit in front of the samples
+	const bool bRf64 = memcmp(pFile, "RF64", 4) == 0;
+	Uint64 dataSize64 = 0;
+	bool bFormat = false;
+	for (Uint64 pos = 12; pos + 8 <= size; )
+	{
+		const Uint8* pChunk = pFile + (size_t)pos;
+		const Uint32 chunkSize = readLE32(pChunk + 4);
+		const Uint64 body = pos + 8;
+		const Uint8* pBody = pFile + (size_t)body;
+		if (memcmp(pChunk, "ds64", 4) == 0 && chunkSize >= 16 && body + 16 <= size)
+		{
+			// RF64 keeps the sizes that do not fit 32 bits here, the RIFF size comes first
+			dataSize64 = readLE64(pBody + 8);
+		}
+		else if (memcmp(pChunk, "fmt ", 4) == 0 && chunkSize >= 16 && body + chunkSize <= size)
+		{
+			Uint16 tag = readLE16(pBody);
+			const Uint16 blockAlign = readLE16(pBody + 12);
+			const Uint16 bits = readLE16(pBody + 14);
+			if (tag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 40)
+			{
+				// The sub format GUID starts with the plain format tag
+				tag = readLE16(pBody + 24);
+			}
+			m_layout.channels = readLE16(pBody + 2);
+			m_layout.sampleRate = (int)readLE32(pBody + 4);
+			if (tag == WAVE_FORMAT_PCM && bits == 8)			m_layout.format = AUDIO_U8;
+			else if (tag == WAVE_FORMAT_PCM && bits == 16)		m_layout.format = AUDIO_S16;
+			else if (tag == WAVE_FORMAT_PCM && bits == 24)		{ m_layout.format = AUDIO_S32; m_layout.bPacked24 = true; }
+			else if (tag == WAVE_FORMAT_PCM && bits == 32)		m_layout.format = AUDIO_S32;
+			else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32)	m_layout.format = AUDIO_F32;
+			if (!m_layout.valid() || blockAlign != m_layout.frameBytes())
+			{
+				ns_Util::Logger::LOG_ERROR(m_path, " has an unsupported sample format, tag ", tag, ", ", bits, " bits\n");
+				return false;
+			}
+			bFormat = true;
+		}
+		else if (memcmp(pChunk, "data", 4) == 0)
+		{
+			if (!bFormat)
+			{
+				ns_Util::Logger::LOG_ERROR(m_path, " has no format ahead of its samples\n");
+				return false;
+			}
+			Uint64 bytes = bRf64 && chunkSize == 0xFFFFFFFF ? dataSize64 : chunkSize;
+
+			// A capture that was cut short plays as far as it got
+			bytes = std::min(bytes, size - body);
+			m_pFrames = pBody;
+			m_frameCount = bytes / m_layout.frameBytes();
+			return true;
+		}
+		pos = body + chunkSize + (chunkSize & 1);
+	}
+	ns_Util::Logger::LOG_ERROR(m_path, " has no samples\n");
+	return false;
+}
+
+bool PcmFile::matches(const SDL_AudioSpec& spec) const
+{
+	const Uint64 offset = (Uint64)(m_pFrames - m_file.data());
+	return isOpen() && !m_layout.bPacked24 && m_layout.format == spec.format && m_layout.channels == spec.channels
+		&& m_layout.sampleRate == spec.freq && offset % m_layout.sampleBytes() == 0;
+}
+
+void PcmFile::adviseAround(Uint64 frame)
+{
+	const Uint64 pos = (Uint64)(m_pFrames - m_file.data()) + std::min(frame, m_frameCount) * m_layout.frameBytes();
+	if (pos < m_lastAdvised)
+	{
+		// Went back, typically a loop to the start, nothing after the old window is needed
+		m_file.release(m_releasedTo, m_prefetchedTo - m_releasedTo);
+		m_prefetchedTo = m_releasedTo = pos;
+	}
+	m_lastAdvised = pos;
+
+	// Both only once the reader has moved far enough, so this costs nothing most frames
+	if (pos + PREFETCH_BYTES / 2 >= m_prefetchedTo)
+	{
+		m_file.willNeed(pos, PREFETCH_BYTES);
+		m_prefetchedTo = pos + PREFETCH_BYTES;
+	}
+	if (pos >= m_releasedTo + 2 * KEEP_BEHIND_BYTES)
+	{
+		m_file.release(m_releasedTo, pos - KEEP_BEHIND_BYTES - m_releasedTo);
+		m_releasedTo = pos - KEEP_BEHIND_BYTES;
+	}
+}
+
+std::string PcmFile::name() const
+{
+	return m_bWav ? "WAV" : "Raw PCM";
+}
+
+void PcmFile::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "PcmFile: \n");
+	Logger::LOG_MSG(prefix, "    File               : ", m_path, ", ", name(), ", ", m_layout.toString(), '\n');
+	Logger::LOG_MSG(prefix, "    Frames             : ", m_frameCount, ", ", m_layout.sampleRate > 0 ? (double)m_frameCount / m_layout.sampleRate : 0.0, " s\n");
+	Logger::LOG_MSG(prefix, "    Mapped(in bytes)   : ", m_file.size(), ", resident window ", m_releasedTo, " .. ", m_prefetchedTo, '\n');
+}
+
+Uint32 PcmDecoder::read(float* pFrames, Uint32 frames)
+{
+	const PcmLayout& layout = m_pFile->layout();
+	const Uint32 count = (Uint32)std::min<Uint64>(frames, m_pFile->frameCount() - m_cursor);
+	const Uint8* pSrc = m_pFile->frames(m_cursor);
+	const size_t samples = (size_t)count * layout.channels;
+	if (layout.bPacked24)
+	{
+		packed24ToFloat(pSrc, pFrames, samples);
+	}
+	else
+	{
+		switch (layout.format)
+		{
+			case AUDIO_S8:	toFloat<Sint8>(pSrc, pFrames, samples);		break;
+			case AUDIO_U8:	toFloat<Uint8>(pSrc, pFrames, samples);		break;
+			case AUDIO_S16:	toFloat<Sint16>(pSrc, pFrames, samples);	break;
+			case AUDIO_U16:	toFloat<Uint16>(pSrc, pFrames, samples);	break;
+			case AUDIO_S32:	toFloat<Sint32>(pSrc, pFrames, samples);	break;
+			case AUDIO_F32:	toFloat<float>(pSrc, pFrames, samples);		break;
+			default:		return 0;
+		}
+	}
+	m_cursor += count;
+
+	// The decode thread is not real time, it can afford the system calls
+	m_pFile->adviseAround(m_cursor);
+	return count;
+}
+
+bool PcmDecoder::rewind()
+{
+	m_cursor = 0;
+	return true;
+}
+
+bool PcmWriter::open(const std::string& path, const PcmLayout& layout)
+{
+	close();
+	m_bWav = lowerCaseExtension(path) == "wav";
+	if (!layout.valid() || (m_bWav && (layout.format == AUDIO_S8 || layout.format == AUDIO_U16)))
+	{
+		ns_Util::Logger::LOG_ERROR("Cannot write ", layout.toString(), " to ", path, m_bWav ? ", WAV has no such samples, use a .raw file\n" : "\n");
+		return false;
+	}
+	m_pFile = std::fopen(path.c_str(), "wb");
+	if (!m_pFile)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to create ", path, '\n');
+		return false;
+	}
+	std::setvbuf(m_pFile, nullptr, _IOFBF, BUFFER_BYTES);
+	m_path = path;
+	m_layout = layout;
+	m_bFailed = false;
+	m_frames = m_dataBytes = 0;
+
+	// Sizes are filled in by close()
+	m_bFailed = m_bWav && !writeWavHeader();
+	return !m_bFailed;
+}
+
+bool PcmWriter::write(const Uint8* pFrames, Uint32 frames)
+{
+	if (!m_pFile || m_bFailed)
+	{
+		return false;
+	}
+	const size_t bytes = (size_t)frames * m_layout.frameBytes();
+	if (m_layout.bPacked24)
+	{
+		// Little endian, the top 3 bytes of every 32 bit sample
+		const size_t samples = (size_t)frames * m_layout.channels;
+		m_packed.resize(bytes);
+		for (size_t i = 0; i < samples; ++i)
+		{
+			memcpy(m_packed.data() + i * 3, pFrames + i * 4 + 1, 3);
+		}
+		pFrames = m_packed.data();
+	}
+	if (std::fwrite(pFrames, 1, bytes, m_pFile) != bytes)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to write ", m_path, '\n');
+		m_bFailed = true;
+		return false;
+	}
+	m_frames += frames;
+	m_dataBytes += bytes;
+	return true;
+}
+
+bool PcmWriter::close()
+{
+	if (!m_pFile)
+	{
+		return false;
+	}
+	bool bOk = !m_bFailed && (!m_bWav || writeWavHeader());
+	bOk = std::fclose(m_pFile) == 0 && bOk;
+	m_pFile = nullptr;
+	if (!bOk)
+	{
+		ns_Util::Logger::LOG_ERROR("Failed to finish ", m_path, '\n');
+	}
+	return bOk;
+}
+
+bool PcmWriter::writeWavHeader()
+{
+	// Chunks are word aligned
+	const Uint64 padding = m_dataBytes & 1;
+	const Uint16 bits = (Uint16)(m_layout.sampleBytes() * 8);
+	const bool bExtensible = m_layout.channels > STEREO || bits > 16;
+	const size_t fmtBytes = bExtensible ? FMT_EXTENSIBLE_BYTES : FMT_BYTES;
+	const size_t headerBytes = WAV_HEADER_BYTES - FMT_EXTENSIBLE_BYTES + fmtBytes;
+	const Uint64 riffBytes = headerBytes - 8 + m_dataBytes + padding;
+	const bool bRf64 = riffBytes > 0xFFFFFFFF;
+
+	Uint8 header[WAV_HEADER_BYTES] = {};
+	Uint8* p = header;
+	memcpy(p, bRf64 ? "RF64" : "RIFF", 4);
+	writeLE32(p + 4, bRf64 ? 0xFFFFFFFF : (Uint32)riffBytes);
+	memcpy(p + 8, "WAVE", 4);
+	p += 12;
+
+	// Reserved until the file outgrows 32 bit sizes
+	memcpy(p, bRf64 ? "ds64" : "JUNK", 4);
+	writeLE32(p + 4, (Uint32)DS64_BYTES);
+	if (bRf64)
+	{
+		writeLE64(p + 8, riffBytes);
+		writeLE64(p + 16, m_dataBytes);
+		writeLE64(p + 24, m_frames);		// Table of other large chunks stays empty
+	}
+	p += 8 + DS64_BYTES;
+
+	memcpy(p, "fmt ", 4);
+	const Uint16 tag = m_layout.format == AUDIO_F32 ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+	writeLE32(p + 4, (Uint32)fmtBytes);
+	writeLE16(p + 8, bExtensible ? WAVE_FORMAT_EXTENSIBLE : tag);
+	writeLE16(p + 10, (Uint16)m_layout.channels);
+	writeLE32(p + 12, (Uint32)m_layout.sampleRate);
+	writeLE32(p + 16, (Uint32)m_layout.sampleRate * m_layout.frameBytes());
+	writeLE16(p + 20, (Uint16)m_layout.frameBytes());
+	writeLE16(p + 22, bits);
+	if (bExtensible)
+	{
+		writeLE16(p + 24, (Uint16)(FMT_EXTENSIBLE_BYTES - 18));
+		writeLE16(p + 26, bits);		// Valid bits, every bit of the container is used
+		writeLE32(p + 28, channelMask(m_layout.channels));
+		writeLE16(p + 32, tag);
+		memcpy(p + 34, SUBFORMAT_GUID_TAIL, sizeof(SUBFORMAT_GUID_TAIL));
+	}
+	p += 8 + fmtBytes;
+
+	memcpy(p, "data", 4);
+	writeLE32(p + 4, bRf64 ? 0xFFFFFFFF : (Uint32)m_dataBytes);
+
+	if (m_dataBytes > 0 && padding != 0 && std::fputc(0, m_pFile) == EOF)
+	{
+		return false;
+	}
+	return std::fseek(m_pFile, 0, SEEK_SET) == 0 && std::fwrite(header, 1, headerBytes, m_pFile) == headerBytes;
+}
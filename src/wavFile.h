@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SDL_audio.h>
+#include "constants.h"
+#include "mappedFile.h"
+#include "audioDecoder.h"
+
+// Layout of interleaved PCM samples
+struct PcmLayout
+{
+	SDL_AudioFormat	format{};			// 0 when not known
+	bool			bPacked24{};		// Signed 24 bit samples in 3 bytes, format is AUDIO_S32 then
+	int				channels{};
+	int				sampleRate{};
+
+	INLINE Uint32 sampleBytes() const { return bPacked24 ? 3 : SDL_AUDIO_BITSIZE(format) / 8; }
+	INLINE Uint32 frameBytes() const { return sampleBytes() * channels; }
+	INLINE bool valid() const { return format != 0 && channels > 0 && sampleRate > 0; }
+
+	// Parses "FORMAT:CHANNELS:RATE", e.g. "S16:2:44100". FORMAT is one of S8, U8, S16, U16,
+	// S24, S32 or F32, all little endian.
+	static bool parse(const std::string& text, PcmLayout& layout);
+
+	std::string toString() const;
+};
+
+// Memory mapped WAV (RIFF or RF64) or headerless PCM file. Opening reads the header only, so
+// it takes the same time whatever the size of the file, and adviseAround() keeps just a
+// window around the reader resident.
+class PcmFile
+{
+public:
+	// Reads ahead of the reader and lets go of what is this far behind it
+	static constexpr Uint64 PREFETCH_BYTES = 4 << 20;
+	static constexpr Uint64 KEEP_BEHIND_BYTES = 1 << 20;
+
+	// .wav files carry their layout, .raw and .pcm files are read with the one given to open()
+	static bool handles(const std::string& path);
+
+	bool open(const std::string& path, const PcmLayout& rawLayout);
+	void close();
+
+	INLINE bool isOpen() const { return m_file.isOpen(); }
+	INLINE const PcmLayout& layout() const { return m_layout; }
+	INLINE Uint64 frameCount() const { return m_frameCount; }
+	INLINE const Uint8* frames(Uint64 firstFrame) const { return m_pFrames + (size_t)(firstFrame * m_layout.frameBytes()); }
+
+	// True when the samples can be handed to a device with this spec as they are
+	bool matches(const SDL_AudioSpec& spec) const;
+
+	// Prefetches ahead of frame and releases the pages well behind it. Expects frame to move
+	// forward, going back starts over from there.
+	void adviseAround(Uint64 frame);
+
+	std::string name() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	bool parseWav();
+
+	MappedFile		m_file;
+	std::string		m_path;
+	PcmLayout		m_layout;
+	bool			m_bWav{};
+	const Uint8*	m_pFrames{};
+	Uint64			m_frameCount{};
+
+	// Offsets into the mapping
+	Uint64			m_lastAdvised{};
+	Uint64			m_prefetchedTo{};
+	Uint64			m_releasedTo{};
+};
+
+// Decodes a PcmFile to float for AudioFileStream, for files the device cannot play as they are
+class PcmDecoder : public AudioDecoder
+{
+public:
+	explicit PcmDecoder(std::unique_ptr<PcmFile> pFile) : m_pFile(std::move(pFile)) {}
+
+	int channels() const override { return m_pFile->layout().channels; }
+	int sampleRate() const override { return m_pFile->layout().sampleRate; }
+	Uint64 lengthInFrames() const override { return m_pFile->frameCount(); }
+
+	Uint32 read(float* pFrames, Uint32 frames) override;
+	bool rewind() override;
+
+	std::string name() const override { return m_pFile->name(); }
+private:
+	std::unique_ptr<PcmFile>	m_pFile;
+	Uint64						m_cursor{};
+};
+
+// Writes interleaved PCM to a WAV file, or a headerless one for .raw and .pcm, through the
+// C library's buffering. A WAV header reserves room for an RF64 ds64 chunk, close() fills in
+// the sizes and switches to RF64 once the samples pass 4 GB.
+class PcmWriter
+{
+public:
+	static constexpr size_t BUFFER_BYTES = 1 << 20;
+
+	~PcmWriter() { close(); }
+
+	PcmWriter() = default;
+	PcmWriter(const PcmWriter&) = delete;
+	PcmWriter& operator=(const PcmWriter&) = delete;
+
+	// WAV takes U8, S16, S24, S32 and F32, raw files take every layout
+	bool open(const std::string& path, const PcmLayout& layout);
+
+	// frames frames in layout().format, packed 24 bit files take AUDIO_S32 frames and keep
+	// their top 3 bytes
+	bool write(const Uint8* pFrames, Uint32 frames);
+
+	// Finishes the header, false when anything failed to write
+	bool close();
+
+	INLINE bool isOpen() const { return m_pFile != nullptr; }
+	INLINE const PcmLayout& layout() const { return m_layout; }
+	INLINE Uint64 framesWritten() const { return m_frames; }
+	INLINE Uint64 bytesWritten() const { return m_dataBytes; }
+private:
+	// At the start of the file, for the samples written so far
+	bool writeWavHeader();
+
+	std::FILE*			m_pFile{};
+	std::string			m_path;
+	PcmLayout			m_layout;
+	bool				m_bWav{};
+	bool				m_bFailed{};
+	Uint64				m_frames{};
+	Uint64				m_dataBytes{};
+	std::vector<Uint8>	m_packed;			// Packed 24 bit samples of one write()
+};
@@ -0,0 +1,313 @@
+#include "waveKernels.h"
+#include "soundWave.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr float kTwoPi = 6.28318530717958647692f;
+
+// Taylor coefficients of sin(y), accurate to ~1e-7 on [-π/2, π/2]
+constexpr float kSin3 = -1.0f / 6.0f;
+constexpr float kSin5 = 1.0f / 120.0f;
+constexpr float kSin7 = -1.0f / 5040.0f;
+constexpr float kSin9 = 1.0f / 362880.0f;
+constexpr float kSin11 = -1.0f / 39916800.0f;
+
+INLINE double wrap(double p)
+{
+	return p - std::floor(p);
+}
+
+// Triangle is shaped as 1 - 4|p - 0.5|, which peaks at p = 0.5, so it runs a quarter cycle ahead
+template<WaveForm W>
+INLINE double startPhase(const WaveKernelParams& params)
+{
+	return wrap(params.phase + params.offset + (W == WaveForm::TRIANGLE ? 0.25 : 0.0));
+}
+
+// sin(2πp) for p in [0, 1)
+INLINE float sinCycle(float p)
+{
+	// sin(2πp) = -sin(2πx) with x = p - 0.5 in [-0.5, 0.5), fold x into [-0.25, 0.25]
+	float x = p - 0.5f;
+	if (std::abs(x) > 0.25f)
+	{
+		x = std::copysign(0.5f, x) - x;
+	}
+	const float y = x * kTwoPi;
+	const float y2 = y * y;
+	return -y * (1.0f + y2 * (kSin3 + y2 * (kSin5 + y2 * (kSin7 + y2 * (kSin9 + y2 * kSin11)))));
+}
+
+template<WaveForm W>
+INLINE float shapeScalar(float p, float a)
+{
+	if constexpr (W == WaveForm::SINE)
+	{
+		return a * sinCycle(p);
+	}
+	else if constexpr (W == WaveForm::SQUARE)
+	{
+		return p < 0.5f ? a : -a;
+	}
+	else if constexpr (W == WaveForm::SAWTOOTH)
+	{
+		return a * (2.0f * p - 1.0f);
+	}
+	else
+	{
+		return a * (1.0f - 4.0f * std::abs(p - 0.5f));
+	}
+}
+
+// Renders from an already shifted phase, also used for the tail of the SIMD kernels
+template<WaveForm W>
+void renderScalarFrom(float* out, size_t n, double p, double inc, float a)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		out[i] = shapeScalar<W>((float)p, a);
+		p += inc;
+		if (p >= 1.0)
+		{
+			p -= 1.0;
+		}
+	}
+}
+
+template<WaveForm W>
+void renderScalar(float* out, size_t n, const WaveKernelParams& params)
+{
+	renderScalarFrom<W>(out, n, startPhase<W>(params), params.increment, params.amplitude);
+}
+
+#if OSC_X86
+// ---------------------------------------------- SSE2 ----------------------------------------------
+OSC_TARGET_SSE2 INLINE __m128 fracSse2(__m128 x)
+{
+	// x is never negative, so truncation is floor
+	return _mm_sub_ps(x, _mm_cvtepi32_ps(_mm_cvttps_epi32(x)));
+}
+
+OSC_TARGET_SSE2 INLINE __m128 selectSse2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+OSC_TARGET_SSE2 INLINE __m128 sinCycleSse2(__m128 p)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	__m128 x = _mm_sub_ps(p, half);
+	const __m128 folded = _mm_sub_ps(_mm_or_ps(half, _mm_and_ps(x, signMask)), x);
+	x = selectSse2(_mm_cmpgt_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(0.25f)), folded, x);
+
+	const __m128 y = _mm_mul_ps(x, _mm_set1_ps(kTwoPi));
+	const __m128 y2 = _mm_mul_ps(y, y);
+	__m128 s = _mm_add_ps(_mm_mul_ps(y2, _mm_set1_ps(kSin11)), _mm_set1_ps(kSin9));
+	s = _mm_add_ps(_mm_mul_ps(y2, s), _mm_set1_ps(kSin7));
+	s = _mm_add_ps(_mm_mul_ps(y2, s), _mm_set1_ps(kSin5));
+	s = _mm_add_ps(_mm_mul_ps(y2, s), _mm_set1_ps(kSin3));
+	s = _mm_add_ps(_mm_mul_ps(y2, s), _mm_set1_ps(1.0f));
+	return _mm_xor_ps(_mm_mul_ps(y, s), signMask);
+}
+
+template<WaveForm W>
+OSC_TARGET_SSE2 INLINE __m128 shapeSse2(__m128 p, __m128 a)
+{
+	if constexpr (W == WaveForm::SINE)
+	{
+		return _mm_mul_ps(a, sinCycleSse2(p));
+	}
+	else if constexpr (W == WaveForm::SQUARE)
+	{
+		return selectSse2(_mm_cmplt_ps(p, _mm_set1_ps(0.5f)), a, _mm_xor_ps(a, _mm_set1_ps(-0.0f)));
+	}
+	else if constexpr (W == WaveForm::SAWTOOTH)
+	{
+		return _mm_sub_ps(_mm_mul_ps(_mm_add_ps(a, a), p), a);
+	}
+	else
+	{
+		const __m128 dist = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(p, _mm_set1_ps(0.5f)));
+		return _mm_sub_ps(a, _mm_mul_ps(_mm_mul_ps(a, _mm_set1_ps(4.0f)), dist));
+	}
+}
+
+template<WaveForm W>
+OSC_TARGET_SSE2 void renderSse2(float* out, size_t n, const WaveKernelParams& params)
+{
+	constexpr size_t kLanes = 4;
+	const double inc = params.increment;
+	const double step = wrap(kLanes * inc);
+	const __m128 lanes = _mm_setr_ps(0.0f, (float)inc, (float)(2 * inc), (float)(3 * inc));
+	const __m128 a = _mm_set1_ps(params.amplitude);
+
+	// The base phase is carried in double and only the in-vector offsets are float,
+	// so long blocks do not accumulate float rounding error.
+	double base = startPhase<W>(params);
+	size_t i = 0;
+	for (; i + kLanes <= n; i += kLanes)
+	{
+		const __m128 p = fracSse2(_mm_add_ps(_mm_set1_ps((float)base), lanes));
+		_mm_storeu_ps(out + i, shapeSse2<W>(p, a));
+		base += step;
+		if (base >= 1.0)
+		{
+			base -= 1.0;
+		}
+	}
+	renderScalarFrom<W>(out + i, n - i, base, inc, params.amplitude);
+}
+
+// ---------------------------------------------- AVX2 ----------------------------------------------
+OSC_TARGET_AVX2 INLINE __m256 fracAvx2(__m256 x)
+{
+	return _mm256_sub_ps(x, _mm256_floor_ps(x));
+}
+
+OSC_TARGET_AVX2 INLINE __m256 sinCycleAvx2(__m256 p)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	__m256 x = _mm256_sub_ps(p, half);
+	const __m256 folded = _mm256_sub_ps(_mm256_or_ps(half, _mm256_and_ps(x, signMask)), x);
+	x = _mm256_blendv_ps(x, folded, _mm256_cmp_ps(_mm256_andnot_ps(signMask, x), _mm256_set1_ps(0.25f), _CMP_GT_OQ));
+
+	const __m256 y = _mm256_mul_ps(x, _mm256_set1_ps(kTwoPi));
+	const __m256 y2 = _mm256_mul_ps(y, y);
+	__m256 s = _mm256_add_ps(_mm256_mul_ps(y2, _mm256_set1_ps(kSin11)), _mm256_set1_ps(kSin9));
+	s = _mm256_add_ps(_mm256_mul_ps(y2, s), _mm256_set1_ps(kSin7));
+	s = _mm256_add_ps(_mm256_mul_ps(y2, s), _mm256_set1_ps(kSin5));
+	s = _mm256_add_ps(_mm256_mul_ps(y2, s), _mm256_set1_ps(kSin3));
+	s = _mm256_add_ps(_mm256_mul_ps(y2, s), _mm256_set1_ps(1.0f));
+	return _mm256_xor_ps(_mm256_mul_ps(y, s), signMask);
+}
+
+template<WaveForm W>
+OSC_TARGET_AVX2 INLINE __m256 shapeAvx2(__m256 p, __m256 a)
+{
+	if constexpr (W == WaveForm::SINE)
+	{
+		return _mm256_mul_ps(a, sinCycleAvx2(p));
+	}
+	else if constexpr (W == WaveForm::SQUARE)
+	{
+		const __m256 mask = _mm256_cmp_ps(p, _mm256_set1_ps(0.5f), _CMP_LT_OQ);
+		return _mm256_blendv_ps(_mm256_xor_ps(a, _mm256_set1_ps(-0.0f)), a, mask);
+	}
+	else if constexpr (W == WaveForm::SAWTOOTH)
+	{
+		return _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(a, a), p), a);
+	}
+	else
+	{
+		const __m256 dist = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_sub_ps(p, _mm256_set1_ps(0.5f)));
+		return _mm256_sub_ps(a, _mm256_mul_ps(_mm256_mul_ps(a, _mm256_set1_ps(4.0f)), dist));
+	}
+}
+
+template<WaveForm W>
+OSC_TARGET_AVX2 void renderAvx2(float* out, size_t n, const WaveKernelParams& params)
+{
+	constexpr size_t kLanes = 8;
+	const double inc = params.increment;
+	const double step = wrap(kLanes * inc);
+	const __m256 lanes = _mm256_setr_ps(0.0f, (float)inc, (float)(2 * inc), (float)(3 * inc),
+		(float)(4 * inc), (float)(5 * inc), (float)(6 * inc), (float)(7 * inc));
+	const __m256 a = _mm256_set1_ps(params.amplitude);
+
+	double base = startPhase<W>(params);
+	size_t i = 0;
+	for (; i + kLanes <= n; i += kLanes)
+	{
+		const __m256 p = fracAvx2(_mm256_add_ps(_mm256_set1_ps((float)base), lanes));
+		_mm256_storeu_ps(out + i, shapeAvx2<W>(p, a));
+		base += step;
+		if (base >= 1.0)
+		{
+			base -= 1.0;
+		}
+	}
+	renderScalarFrom<W>(out + i, n - i, base, inc, params.amplitude);
+}
+#endif // OSC_X86
+
+// Indexed by [SimdLevel][WaveForm], nullptr when the level is not available for this target
+const WaveKernel s_waveKernels[(int)SimdLevel::MAX][(int)WaveForm::MAX] =
+{
+	{ renderScalar<WaveForm::SINE>, renderScalar<WaveForm::SQUARE>, renderScalar<WaveForm::SAWTOOTH>, renderScalar<WaveForm::TRIANGLE> },
+#if OSC_X86
+	{ renderSse2<WaveForm::SINE>, renderSse2<WaveForm::SQUARE>, renderSse2<WaveForm::SAWTOOTH>, renderSse2<WaveForm::TRIANGLE> },
+	{ renderAvx2<WaveForm::SINE>, renderAvx2<WaveForm::SQUARE>, renderAvx2<WaveForm::SAWTOOTH>, renderAvx2<WaveForm::TRIANGLE> },
+#else
+	{ nullptr, nullptr, nullptr, nullptr },
+	{ nullptr, nullptr, nullptr, nullptr },
+#endif
+};
+}
+
+std::string simdLevel2String(SimdLevel level)
+{
+	std::string strLevel;
+	switch (level)
+	{
+		case SimdLevel::SCALAR:
+			strLevel = "Scalar";
+			break;
+		case SimdLevel::SSE2:
+			strLevel = "SSE2";
+			break;
+		case SimdLevel::AVX2:
+			strLevel = "AVX2";
+			break;
+		default:
+			strLevel = "Unkown";
+			break;
+	}
+	return strLevel;
+}
+
+SimdLevel detectSimdLevel()
+{
+#if OSC_X86
+	if (SDL_HasAVX2())
+	{
+		return SimdLevel::AVX2;
+	}
+	if (SDL_HasSSE2())
+	{
+		return SimdLevel::SSE2;
+	}
+#endif
+	return SimdLevel::SCALAR;
+}
+
+SimdLevel availableSimdLevel(SimdLevel level)
+{
+	int l = std::min((int)level, (int)SimdLevel::MAX - 1);
+	while (l > 0 && !s_waveKernels[l][0])
+	{
+		--l;
+	}
+	return (SimdLevel)std::max(l, 0);
+}
+
+const WaveKernel* getWaveKernels(SimdLevel level)
+{
+	return s_waveKernels[(int)availableSimdLevel(level)];
+}
+
+WaveKernel getWaveKernel(WaveForm w, SimdLevel level)
+{
+	if ((int)w < 0 || w >= WaveForm::MAX)
+	{
+		return nullptr;
+	}
+	return getWaveKernels(level)[(int)w];
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "constants.h"
+
+enum class WaveForm;
+class Wavetable;
+
+enum class SimdLevel
+{
+	SCALAR,
+	SSE2,
+	AVX2,
+	MAX
+};
+
+extern std::string simdLevel2String(SimdLevel level);
+
+// Best instruction set available on this machine, as reported by SDL_cpuinfo.h
+extern SimdLevel detectSimdLevel();
+
+// Everything a block kernel needs to render n samples of one waveform
+struct WaveKernelParams
+{
+	double		phase{};		// Normalized phase of the first sample, [0, 1)
+	double		increment{};	// f / fs, [0, 1)
+	double		offset{};		// φ / 2π, [0, 1)
+	float		amplitude{};
+
+	const Wavetable*	wavetable{};	// Only read by the wavetable kernels
+};
+
+// Fills out[0, n) with the waveform, sample i is at phase + offset + i * increment.
+using WaveKernel = void (*)(float* out, size_t n, const WaveKernelParams& params);
+
+// Highest level compiled into this build that is not above the requested one
+extern SimdLevel availableSimdLevel(SimdLevel level);
+
+// All kernels of one level, indexed by WaveForm
+extern const WaveKernel* getWaveKernels(SimdLevel level);
+
+// Kernel for the waveform at the requested level, falls back to a lower level when
+// the requested one was not compiled in.
+extern WaveKernel getWaveKernel(WaveForm w, SimdLevel level);
@@ -0,0 +1,150 @@
+#include "waveformPyramid.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+void WaveformPyramid::Level::push_back(const Bucket& bucket)
+{
+	if (m_size == capacity())
+	{
+		m_blocks.push_back(std::make_unique<Bucket[]>(BLOCK_BUCKETS));
+	}
+	m_blocks.back()[m_size % BLOCK_BUCKETS] = bucket;
+	++m_size;
+}
+
+void WaveformPyramid::finishBucket()
+{
+	m_pending.meanSquare = (float)(m_pendingSquares / BASE_DECIMATION);
+	if (m_levels.empty())
+	{
+		m_levels.emplace_back();
+	}
+	m_levels[0].push_back(m_pending);
+
+	// Every second bucket completes a pair, which is one bucket of the level above
+	for (size_t l = 0; m_levels[l].size() % 2 == 0; ++l)
+	{
+		const Bucket& a = m_levels[l][m_levels[l].size() - 2];
+		const Bucket& b = m_levels[l].back();
+		Bucket parent;
+		parent.min = std::min(a.min, b.min);
+		parent.max = std::max(a.max, b.max);
+		parent.meanSquare = (a.meanSquare + b.meanSquare) / 2;
+		if (l + 1 == m_levels.size())
+		{
+			m_levels.emplace_back();
+		}
+		m_levels[l + 1].push_back(parent);
+	}
+
+	m_pendingSquares = 0;
+	m_pendingCount = 0;
+}
+
+bool WaveformPyramid::append(const void* pSamples, SDL_AudioFormat format, Uint32 count)
+{
+	switch (format)
+	{
+		case AUDIO_S8:
+			append(static_cast<const Sint8*>(pSamples), count);
+			break;
+
+		case AUDIO_U8:
+			append(static_cast<const Uint8*>(pSamples), count);
+			break;
+
+		case AUDIO_S16:
+			append(static_cast<const Sint16*>(pSamples), count);
+			break;
+
+		case AUDIO_U16:
+			append(static_cast<const Uint16*>(pSamples), count);
+			break;
+
+		case AUDIO_S32:
+			append(static_cast<const Sint32*>(pSamples), count);
+			break;
+
+		case AUDIO_F32:
+			append(static_cast<const float*>(pSamples), count);
+			break;
+
+		default:
+			return false;
+	}
+	return true;
+}
+
+void WaveformPyramid::clear()
+{
+	m_levels.clear();
+	m_pending = Bucket{};
+	m_pendingSquares = 0;
+	m_pendingCount = 0;
+	m_sampleCount = 0;
+}
+
+bool WaveformPyramid::query(Uint64 firstSample, Uint64 sampleCount, MinMaxColumn* pColumns, float* pRms, Uint32 columns) const
+{
+	const Uint64 end = firstSample + sampleCount;
+	if (columns == 0 || sampleCount / columns < BASE_DECIMATION || end > summarisedCount())
+	{
+		return false;
+	}
+
+	// Coarsest level with a bucket per column that also reaches the end of the range
+	int l = 0;
+	while (l + 1 < levelCount() && bucketSamples(l + 1) <= sampleCount / columns)
+	{
+		++l;
+	}
+	while (l > 0 && m_levels[l].size() * bucketSamples(l) < end)
+	{
+		--l;
+	}
+
+	const Level& buckets = m_levels[l];
+	const Uint64 bucketSize = bucketSamples(l);
+	for (Uint32 c = 0; c < columns; ++c)
+	{
+		const Uint64 s0 = firstSample + sampleCount * c / columns;
+		const Uint64 s1 = firstSample + sampleCount * (c + 1) / columns;
+		const size_t b0 = (size_t)(s0 / bucketSize);
+		const size_t b1 = std::min((size_t)std::max((s1 + bucketSize - 1) / bucketSize, (Uint64)b0 + 1), buckets.size());
+
+		MinMaxColumn column{ buckets[b0].min, buckets[b0].max };
+		double meanSquare = 0;
+		for (size_t b = b0; b < b1; ++b)
+		{
+			column.min = std::min(column.min, buckets[b].min);
+			column.max = std::max(column.max, buckets[b].max);
+			meanSquare += buckets[b].meanSquare;
+		}
+		pColumns[c] = column;
+		if (pRms)
+		{
+			pRms[c] = (float)std::sqrt(meanSquare / (b1 - b0));
+		}
+	}
+	return true;
+}
+
+size_t WaveformPyramid::memoryUsage() const
+{
+	size_t bytes = 0;
+	for (const Level& level : m_levels)
+	{
+		bytes += level.capacity() * sizeof(Bucket);
+	}
+	return bytes;
+}
+
+void WaveformPyramid::print(const std::string& prefix) const
+{
+	using ns_Util::Logger;
+	Logger::LOG_MSG(prefix, "WaveformPyramid: \n");
+	Logger::LOG_MSG(prefix, "    Samples            : ", m_sampleCount, ", in ", levelCount(), " levels\n");
+	Logger::LOG_MSG(prefix, "    Memory(in bytes)   : ", memoryUsage(), '\n');
+}
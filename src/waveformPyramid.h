@@ -0,0 +1,113 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <SDL_audio.h>
+#include "constants.h"
+#include "minMaxDecimator.h"
+
+// Min/max/RMS summaries of a recording at power-of-two decimation levels, for drawing any
+// stretch of a long recording in O(columns).
+//
+// Level 0 summarises BASE_DECIMATION samples per bucket, level k 2^k times as many. Samples
+// are appended as they arrive, a bucket is finished every BASE_DECIMATION samples and every
+// second bucket of a level finishes one in the level above, so appending is O(1) amortized.
+// All levels together take 2 * sizeof(Bucket) / BASE_DECIMATION = 0.375 bytes per sample
+// plus one partly filled block per level, a tenth of the samples as floats. The raw samples
+// are not kept. Levels grow a fixed size block at a time, so an append never copies the
+// buckets already there, however long the recording.
+class WaveformPyramid
+{
+public:
+	static constexpr Uint32 BASE_DECIMATION = 64;
+
+	struct Bucket
+	{
+		float	min{};
+		float	max{};
+		float	meanSquare{};		// Around the bias, see setBias()
+	};
+
+	// Buckets of one level in blocks of BLOCK_BUCKETS that stay where they are
+	class Level
+	{
+	public:
+		static constexpr size_t BLOCK_BUCKETS = 1024;		// Power of two
+
+		INLINE size_t size() const { return m_size; }
+		INLINE size_t capacity() const { return m_blocks.size() * BLOCK_BUCKETS; }
+		INLINE const Bucket& operator[](size_t i) const { return m_blocks[i / BLOCK_BUCKETS][i % BLOCK_BUCKETS]; }
+		INLINE const Bucket& back() const { return (*this)[m_size - 1]; }
+
+		void push_back(const Bucket& bucket);
+	private:
+		std::vector<std::unique_ptr<Bucket[]>>	m_blocks;
+		size_t									m_size{};
+	};
+
+	// RMS is measured around bias, display samples carry the centre line as an offset
+	INLINE void setBias(float bias) { m_bias = bias; }
+	INLINE float getBias() const { return m_bias; }
+
+	template <typename T>
+	void append(const T* pSamples, Uint32 count);
+
+	// append() for a buffer in one of the player's formats, false for any other format
+	bool append(const void* pSamples, SDL_AudioFormat format, Uint32 count);
+
+	void clear();
+
+	// Samples appended so far, and samples covered by finished level 0 buckets
+	INLINE Uint64 sampleCount() const { return m_sampleCount; }
+	INLINE Uint64 summarisedCount() const { return m_levels.empty() ? 0 : (Uint64)m_levels[0].size() * BASE_DECIMATION; }
+
+	INLINE int levelCount() const { return (int)m_levels.size(); }
+	INLINE const Level& level(int l) const { return m_levels[l]; }
+	INLINE static Uint64 bucketSamples(int l) { return (Uint64)BASE_DECIMATION << l; }
+
+	// Summarises samples [firstSample, firstSample + sampleCount) into columns, each one
+	// from the coarsest level that still has at least one bucket per column. pRms may be
+	// null. Returns false when a column is narrower than BASE_DECIMATION samples or the
+	// range is not summarised yet, the columns are left untouched then.
+	bool query(Uint64 firstSample, Uint64 sampleCount, MinMaxColumn* pColumns, float* pRms, Uint32 columns) const;
+
+	// Heap bytes held by the summaries
+	size_t memoryUsage() const;
+
+	void print(const std::string& prefix = "") const;
+private:
+	void finishBucket();
+private:
+	std::vector<Level>					m_levels;
+	Bucket								m_pending;			// Level 0 bucket being filled
+	double								m_pendingSquares{};
+	Uint32								m_pendingCount{};
+	Uint64								m_sampleCount{};
+	float								m_bias{};
+};
+
+template <typename T>
+void WaveformPyramid::append(const T* pSamples, Uint32 count)
+{
+	for (Uint32 i = 0; i < count; ++i)
+	{
+		const float v = static_cast<float>(pSamples[i]);
+		if (m_pendingCount == 0)
+		{
+			m_pending.min = m_pending.max = v;
+		}
+		else
+		{
+			m_pending.min = v < m_pending.min ? v : m_pending.min;
+			m_pending.max = v > m_pending.max ? v : m_pending.max;
+		}
+		const double centred = (double)v - m_bias;
+		m_pendingSquares += centred * centred;
+		if (++m_pendingCount == BASE_DECIMATION)
+		{
+			finishBucket();
+		}
+	}
+	m_sampleCount += count;
+}
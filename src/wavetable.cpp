@@ -0,0 +1,182 @@
+#include "wavetable.h"
+#include "soundWave.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace
+{
+// Phase is carried as a 32 bit fixed point fraction of a cycle, wrapping is free
+constexpr double PHASE_ONE = 4294967296.0;
+
+INLINE Uint32 toFixedPhase(double p)
+{
+	p -= std::floor(p);
+	return (Uint32)(Uint64)(p * PHASE_ONE);
+}
+
+INLINE float cubic(const float* t, Uint32 idx, float f)
+{
+	// Catmull-Rom spline through t[idx - 1], t[idx], t[idx + 1], t[idx + 2]
+	const float ym1 = t[(int)idx - 1];
+	const float y0 = t[idx];
+	const float y1 = t[idx + 1];
+	const float y2 = t[idx + 2];
+	const float c1 = 0.5f * (y1 - ym1);
+	const float c2 = ym1 - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
+	const float c3 = 0.5f * (y2 - ym1) + 1.5f * (y0 - y1);
+	return ((c3 * f + c2) * f + c1) * f + y0;
+}
+
+template<Interpolation I>
+void renderTable(const float* t, int sizeLog2, float* out, size_t n, const WaveKernelParams& params)
+{
+	const int shift = 32 - sizeLog2;
+	const Uint32 fracMask = (1u << shift) - 1;
+	const float fracScale = 1.0f / (float)(1u << shift);
+	const float a = params.amplitude;
+
+	Uint32 phase = toFixedPhase(params.phase + params.offset);
+	const Uint32 inc = toFixedPhase(params.increment);
+	for (size_t i = 0; i < n; ++i)
+	{
+		const Uint32 idx = phase >> shift;
+		const float f = (phase & fracMask) * fracScale;
+		if constexpr (I == Interpolation::LINEAR)
+		{
+			out[i] = a * (t[idx] + f * (t[idx + 1] - t[idx]));
+		}
+		else
+		{
+			out[i] = a * cubic(t, idx, f);
+		}
+		phase += inc;
+	}
+}
+
+template<Interpolation I>
+void renderWavetable(float* out, size_t n, const WaveKernelParams& params)
+{
+	params.wavetable->render(out, n, params, I);
+}
+
+const WaveKernel s_wavetableKernels[(int)Interpolation::MAX][(int)WaveForm::MAX] =
+{
+	{ renderWavetable<Interpolation::LINEAR>, renderWavetable<Interpolation::LINEAR>, renderWavetable<Interpolation::LINEAR>, renderWavetable<Interpolation::LINEAR> },
+	{ renderWavetable<Interpolation::CUBIC>, renderWavetable<Interpolation::CUBIC>, renderWavetable<Interpolation::CUBIC>, renderWavetable<Interpolation::CUBIC> },
+};
+}
+
+std::string interpolation2String(Interpolation i)
+{
+	std::string strInterpolation;
+	switch (i)
+	{
+		case Interpolation::LINEAR:
+			strInterpolation = "Linear";
+			break;
+		case Interpolation::CUBIC:
+			strInterpolation = "Cubic";
+			break;
+		default:
+			strInterpolation = "Unkown";
+			break;
+	}
+	return strInterpolation;
+}
+
+double waveformAt(WaveForm w, double p)
+{
+	double value{};
+	switch (w)
+	{
+		case WaveForm::SINE:
+			value = std::sin(2 * M_PI * p);
+			break;
+		case WaveForm::SQUARE:
+			value = p < 0.5 ? 1.0 : -1.0;
+			break;
+		case WaveForm::SAWTOOTH:
+			value = 2 * p - 1;
+			break;
+		case WaveForm::TRIANGLE:
+			p += 0.25;
+			p -= std::floor(p);
+			value = 1 - 4 * std::abs(p - 0.5);
+			break;
+		default:
+			break;
+	}
+	return value;
+}
+
+Wavetable::Wavetable(WaveForm w, int sizeLog2)
+	: m_waveForm(w)
+	, m_sizeLog2(sizeLog2)
+	, m_size(1u << sizeLog2)
+	, m_data(m_size + 3)
+{
+	float* t = m_data.data() + 1;
+	for (Uint32 k = 0; k < m_size; ++k)
+	{
+		t[k] = (float)waveformAt(w, k / (double)m_size);
+	}
+	m_data[0] = t[m_size - 1];
+	t[m_size] = t[0];
+	t[m_size + 1] = t[1];
+}
+
+float Wavetable::lookup(double p, Interpolation i) const
+{
+	const double pos = (p - std::floor(p)) * m_size;
+	const Uint32 idx = std::min((Uint32)pos, m_size - 1);
+	const float f = (float)(pos - idx);
+	const float* t = points();
+	if (i == Interpolation::CUBIC)
+	{
+		return cubic(t, idx, f);
+	}
+	return t[idx] + f * (t[idx + 1] - t[idx]);
+}
+
+void Wavetable::render(float* out, size_t n, const WaveKernelParams& params, Interpolation i) const
+{
+	if (i == Interpolation::CUBIC)
+	{
+		renderTable<Interpolation::CUBIC>(points(), m_sizeLog2, out, n, params);
+	}
+	else
+	{
+		renderTable<Interpolation::LINEAR>(points(), m_sizeLog2, out, n, params);
+	}
+}
+
+WavetableBank::WavetableBank(int sizeLog2)
+	: m_sizeLog2(sizeLog2)
+{
+	for (int w = 0; w < (int)WaveForm::MAX; ++w)
+	{
+		m_tables.push_back(std::make_unique<Wavetable>((WaveForm)w, sizeLog2));
+	}
+}
+
+const WavetableBank& WavetableBank::get(int sizeLog2)
+{
+	static std::mutex s_mutex;
+	static std::unique_ptr<WavetableBank> s_banks[MAX_SIZE_LOG2 + 1];
+
+	sizeLog2 = std::clamp(sizeLog2, MIN_SIZE_LOG2, MAX_SIZE_LOG2);
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (!s_banks[sizeLog2])
+	{
+		s_banks[sizeLog2] = std::make_unique<WavetableBank>(sizeLog2);
+	}
+	return *s_banks[sizeLog2];
+}
+
+const WaveKernel* getWavetableKernels(Interpolation i)
+{
+	return s_wavetableKernels[i == Interpolation::CUBIC ? 1 : 0];
+}
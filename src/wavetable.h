@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "waveKernels.h"
+
+enum class Interpolation
+{
+	LINEAR,
+	CUBIC,
+	MAX
+};
+
+extern std::string interpolation2String(Interpolation i);
+
+// Exact single cycle of the waveform at unit amplitude, p in [0, 1).
+// Same phase convention as SoundWave::nextSample().
+extern double waveformAt(WaveForm w, double p);
+
+// One precomputed cycle of a waveform, 2^sizeLog2 points
+class Wavetable
+{
+public:
+	Wavetable(WaveForm w, int sizeLog2);
+
+	INLINE Uint32 size() const { return m_size; }
+	INLINE int sizeLog2() const { return m_sizeLog2; }
+	INLINE WaveForm getWaveForm() const { return m_waveForm; }
+
+	// Unit amplitude lookup at p in [0, 1)
+	float lookup(double p, Interpolation i) const;
+
+	// Same contract as a WaveKernel, scaled by params.amplitude
+	void render(float* out, size_t n, const WaveKernelParams& params, Interpolation i) const;
+
+private:
+	// Table entry k lives at m_data[k + 1], with one guard point before and two after
+	// so cubic interpolation never has to wrap the index.
+	INLINE const float* points() const { return m_data.data() + 1; }
+
+private:
+	WaveForm			m_waveForm{};
+	int					m_sizeLog2{};
+	Uint32				m_size{};
+	std::vector<float>	m_data;
+};
+
+// Tables of every waveform for one size, generated once on first use and shared by all oscillators
+class WavetableBank
+{
+public:
+	static constexpr int MIN_SIZE_LOG2 = 4;
+	static constexpr int MAX_SIZE_LOG2 = 16;
+	static constexpr int DEFAULT_SIZE_LOG2 = 11;
+
+	static const WavetableBank& get(int sizeLog2);
+
+	INLINE const Wavetable& table(WaveForm w) const { return *m_tables[(int)w]; }
+	INLINE int sizeLog2() const { return m_sizeLog2; }
+
+	explicit WavetableBank(int sizeLog2);
+
+private:
+	int										m_sizeLog2{};
+	std::vector<std::unique_ptr<Wavetable>>	m_tables;		// Indexed by WaveForm
+};
+
+// Kernels that read params.wavetable instead of computing the waveform, indexed by WaveForm
+extern const WaveKernel* getWavetableKernels(Interpolation i);